@@ -0,0 +1,274 @@
+#include "batchfile.h"
+#include "scenario.h"
+#include "mappedfile.h"
+#include "point.h"
+#include <stdint.h>
+#include <cstddef>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+
+namespace polyanya
+{
+
+// Points are written as they are laid out in memory.
+static_assert(sizeof(Point) == 2 * sizeof(double), "Point must be 2 doubles");
+
+// Workers hand their buffer over once it gets this big.
+const size_t BATCH_BUFFER_SIZE = 1 << 20;
+const int BATCH_QUERY_COLUMNS = 5;
+
+bool is_batch_queries_file(const std::string& filename)
+{
+    std::ifstream infile(filename, std::ios::in | std::ios::binary);
+    char magic[sizeof(BATCH_QUERIES_MAGIC)];
+    if (!infile.read(magic, sizeof(magic)))
+    {
+        return false;
+    }
+    return std::memcmp(magic, BATCH_QUERIES_MAGIC, sizeof(magic)) == 0;
+}
+
+bool load_batch_queries(const std::string& filename,
+                        std::vector<Scenario>& out)
+{
+    MappedFile mapped;
+    if (!mapped.open(filename) || mapped.size() < sizeof(BatchQueriesHeader))
+    {
+        std::cerr << "Error reading batch query header" << std::endl;
+        return false;
+    }
+    BatchQueriesHeader header;
+    std::memcpy(&header, mapped.data(), sizeof(header));
+    if (std::memcmp(header.magic, BATCH_QUERIES_MAGIC,
+                    sizeof(BATCH_QUERIES_MAGIC)) != 0 ||
+        header.byte_order != BATCH_BYTE_ORDER ||
+        header.version != BATCH_VERSION)
+    {
+        std::cerr << "Invalid batch query file" << std::endl;
+        return false;
+    }
+    const uint64_t n = header.num_queries;
+    if ((mapped.size() - sizeof(header)) / sizeof(double) /
+        BATCH_QUERY_COLUMNS < n)
+    {
+        std::cerr << "Batch query file is truncated" << std::endl;
+        return false;
+    }
+    // The header is 8 byte aligned, so the columns can be used in place.
+    const double* columns = reinterpret_cast<const double*>(
+        mapped.data() + sizeof(header));
+    const double* start_x = columns;
+    const double* start_y = start_x + n;
+    const double* goal_x = start_y + n;
+    const double* goal_y = goal_x + n;
+    const double* reference = goal_y + n;
+    out.resize(n);
+    for (uint64_t i = 0; i < n; i++)
+    {
+        out[i] = {0, 0, 0, {start_x[i], start_y[i]}, {goal_x[i], goal_y[i]},
+                  reference[i]};
+    }
+    return true;
+}
+
+bool write_batch_queries(std::ostream& outfile,
+                         const std::vector<Scenario>& scenarios)
+{
+    BatchQueriesHeader header;
+    std::memset(&header, 0, sizeof(header));
+    std::memcpy(header.magic, BATCH_QUERIES_MAGIC,
+                sizeof(BATCH_QUERIES_MAGIC));
+    header.version = BATCH_VERSION;
+    header.byte_order = BATCH_BYTE_ORDER;
+    header.num_queries = scenarios.size();
+    outfile.write(reinterpret_cast<const char*>(&header), sizeof(header));
+
+    std::vector<double> column(scenarios.size());
+    const auto write_column = [&](double (*get)(const Scenario&))
+    {
+        for (size_t i = 0; i < scenarios.size(); i++)
+        {
+            column[i] = get(scenarios[i]);
+        }
+        outfile.write(reinterpret_cast<const char*>(column.data()),
+                      column.size() * sizeof(double));
+    };
+    write_column([](const Scenario& s) { return s.start.x; });
+    write_column([](const Scenario& s) { return s.start.y; });
+    write_column([](const Scenario& s) { return s.goal.x; });
+    write_column([](const Scenario& s) { return s.goal.y; });
+    write_column([](const Scenario& s) { return s.gridcost; });
+    return (bool) outfile;
+}
+
+bool BatchResultWriter::open(const std::string& filename, int num_workers,
+                             bool paths)
+{
+    close();
+    outfile.open(filename, std::ios::out | std::ios::binary);
+    if (!outfile.is_open())
+    {
+        return false;
+    }
+    with_paths = paths;
+    failed = false;
+    closing = false;
+
+    // The number of results is filled in by close().
+    BatchResultsHeader header;
+    std::memset(&header, 0, sizeof(header));
+    std::memcpy(header.magic, BATCH_RESULTS_MAGIC,
+                sizeof(BATCH_RESULTS_MAGIC));
+    header.version = BATCH_VERSION;
+    header.byte_order = BATCH_BYTE_ORDER;
+    header.flags = with_paths ? BATCH_RESULTS_PATHS : 0;
+    outfile.write(reinterpret_cast<const char*>(&header), sizeof(header));
+
+    buffers.assign(num_workers, std::vector<char>());
+    for (std::vector<char>& buffer : buffers)
+    {
+        buffer.reserve(BATCH_BUFFER_SIZE);
+    }
+    num_records.assign(num_workers, 0);
+    writer = std::thread(&BatchResultWriter::write_full_buffers, this);
+    return true;
+}
+
+void BatchResultWriter::write(int worker, const BatchResultRecord& record,
+                              const Point* path)
+{
+    std::vector<char>& buffer = buffers[worker];
+    const char* bytes = reinterpret_cast<const char*>(&record);
+    buffer.insert(buffer.end(), bytes, bytes + sizeof(record));
+    if (with_paths && record.num_points > 0)
+    {
+        bytes = reinterpret_cast<const char*>(path);
+        buffer.insert(buffer.end(), bytes,
+                      bytes + record.num_points * sizeof(Point));
+    }
+    num_records[worker]++;
+    if (buffer.size() >= BATCH_BUFFER_SIZE)
+    {
+        hand_over(worker);
+    }
+}
+
+void BatchResultWriter::hand_over(int worker)
+{
+    std::vector<char>& buffer = buffers[worker];
+    {
+        std::lock_guard<std::mutex> guard(lock);
+        full.push_back(std::move(buffer));
+        if (spare.empty())
+        {
+            buffer = std::vector<char>();
+            buffer.reserve(BATCH_BUFFER_SIZE);
+        }
+        else
+        {
+            buffer = std::move(spare.back());
+            spare.pop_back();
+        }
+    }
+    wake.notify_one();
+}
+
+void BatchResultWriter::write_full_buffers()
+{
+    std::unique_lock<std::mutex> guard(lock);
+    while (true)
+    {
+        wake.wait(guard, [this] { return !full.empty() || closing; });
+        if (full.empty())
+        {
+            // closing, and everything has been written.
+            return;
+        }
+        std::vector<char> buffer = std::move(full.front());
+        full.pop_front();
+        guard.unlock();
+        outfile.write(buffer.data(), buffer.size());
+        if (!outfile)
+        {
+            failed = true;
+        }
+        buffer.clear();
+        guard.lock();
+        spare.push_back(std::move(buffer));
+    }
+}
+
+bool BatchResultWriter::close()
+{
+    if (!writer.joinable())
+    {
+        return !failed;
+    }
+    uint64_t total = 0;
+    for (int worker = 0; worker < (int) buffers.size(); worker++)
+    {
+        if (!buffers[worker].empty())
+        {
+            hand_over(worker);
+        }
+        total += num_records[worker];
+    }
+    {
+        std::lock_guard<std::mutex> guard(lock);
+        closing = true;
+    }
+    wake.notify_one();
+    writer.join();
+
+    outfile.seekp(offsetof(BatchResultsHeader, num_results));
+    outfile.write(reinterpret_cast<const char*>(&total), sizeof(total));
+    outfile.close();
+    if (!outfile)
+    {
+        failed = true;
+    }
+    buffers.clear();
+    spare.clear();
+    return !failed;
+}
+
+bool BatchResultReader::open(const std::string& filename)
+{
+    infile.open(filename, std::ios::in | std::ios::binary);
+    num_read = 0;
+    if (!infile.read(reinterpret_cast<char*>(&header), sizeof(header)))
+    {
+        return false;
+    }
+    return std::memcmp(header.magic, BATCH_RESULTS_MAGIC,
+                       sizeof(BATCH_RESULTS_MAGIC)) == 0 &&
+           header.byte_order == BATCH_BYTE_ORDER &&
+           header.version == BATCH_VERSION;
+}
+
+bool BatchResultReader::next(BatchResultRecord& record,
+                             std::vector<Point>& path)
+{
+    if (num_read == header.num_results ||
+        !infile.read(reinterpret_cast<char*>(&record), sizeof(record)))
+    {
+        return false;
+    }
+    path.clear();
+    if (has_paths() && record.num_points > 0)
+    {
+        path.resize(record.num_points);
+        if (!infile.read(reinterpret_cast<char*>(path.data()),
+                         record.num_points * sizeof(Point)))
+        {
+            return false;
+        }
+    }
+    num_read++;
+    return true;
+}
+
+}
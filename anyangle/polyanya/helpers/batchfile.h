@@ -0,0 +1,138 @@
+#pragma once
+#include "scenario.h"
+#include "point.h"
+#include <stdint.h>
+#include <condition_variable>
+#include <deque>
+#include <fstream>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace polyanya
+{
+
+// Binary query and result files for replaying large batches of queries.
+// See utils/spec/batch/binary.txt.
+
+const char BATCH_QUERIES_MAGIC[8] = {'p', 'o', 'l', 'y', 'q', 'r', 'y', 's'};
+const char BATCH_RESULTS_MAGIC[8] = {'p', 'o', 'l', 'y', 'r', 'e', 's', 'l'};
+const uint32_t BATCH_VERSION = 1;
+// As in binarymesh.h.
+const uint32_t BATCH_BYTE_ORDER = 0x01020304;
+
+// Followed by five columns of num_queries doubles: start x, start y, goal x,
+// goal y and reference cost.
+struct BatchQueriesHeader
+{
+    char magic[8];
+    uint32_t version;
+    uint32_t byte_order;
+    uint64_t num_queries;
+};
+
+const uint32_t BATCH_RESULTS_PATHS = 1; // records are followed by paths
+
+// Followed by num_results records, in the order the queries finished.
+struct BatchResultsHeader
+{
+    char magic[8];
+    uint32_t version;
+    uint32_t byte_order;
+    uint32_t flags;
+    uint32_t padding;
+    uint64_t num_results;
+};
+
+// Followed by num_points points (x, y as doubles) if the file has paths.
+struct BatchResultRecord
+{
+    int32_t index; // of the query
+    int32_t num_points;
+    double cost;
+    double micro;
+    int32_t successor_calls;
+    int32_t nodes_generated;
+    int32_t nodes_pushed;
+    int32_t nodes_popped;
+    int32_t nodes_pruned_post_pop;
+    int32_t cache_hit;
+};
+
+// Whether filename starts like a binary query file.
+bool is_batch_queries_file(const std::string& filename);
+// Reads a binary query file into scenarios, with the reference cost as the
+// gridcost. Returns false if it can't.
+bool load_batch_queries(const std::string& filename,
+                        std::vector<Scenario>& out);
+bool write_batch_queries(std::ostream& outfile,
+                         const std::vector<Scenario>& scenarios);
+
+// Writes a binary result file from several threads without making them
+// wait on the disk. Each worker appends records to a buffer of its own, and
+// full buffers are handed to a thread which does the writing.
+class BatchResultWriter
+{
+    private:
+        std::ofstream outfile;
+        bool with_paths;
+        bool failed;
+
+        // Only touched by their worker.
+        std::vector<std::vector<char>> buffers;
+        std::vector<uint64_t> num_records;
+
+        // Shared with the writing thread.
+        std::mutex lock;
+        std::condition_variable wake;
+        std::deque<std::vector<char>> full;
+        std::vector<std::vector<char>> spare;
+        bool closing;
+        std::thread writer;
+
+        void hand_over(int worker);
+        void write_full_buffers();
+
+    public:
+        BatchResultWriter() : with_paths(false), failed(false),
+                              closing(false) { }
+        BatchResultWriter(BatchResultWriter const &) = delete;
+        void operator=(BatchResultWriter const &x) = delete;
+        ~BatchResultWriter() { close(); }
+
+        // Returns false (and stays closed) if the file can't be opened.
+        bool open(const std::string& filename, int num_workers,
+                  bool paths);
+        // path has record.num_points points, and is ignored if the file
+        // has no paths. Different workers may call this at the same time.
+        void write(int worker, const BatchResultRecord& record,
+                   const Point* path);
+        // Writes everything out. Returns false if anything failed.
+        bool close();
+};
+
+// Reads a binary result file one record at a time.
+class BatchResultReader
+{
+    private:
+        std::ifstream infile;
+        BatchResultsHeader header;
+        uint64_t num_read;
+
+    public:
+        // Returns false if the file can't be opened or isn't a result file.
+        bool open(const std::string& filename);
+        bool has_paths() const
+        {
+            return header.flags & BATCH_RESULTS_PATHS;
+        }
+        uint64_t size() const
+        {
+            return header.num_results;
+        }
+        // Returns false once there are no records left, or on errors.
+        bool next(BatchResultRecord& record, std::vector<Point>& path);
+};
+
+}
@@ -227,6 +227,12 @@ class cpool
             #endif
         }
 
+        inline size_t
+        num_chunks()
+        {
+            return num_chunks_;
+        }
+
         size_t
         mem()
         {
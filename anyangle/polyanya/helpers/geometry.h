@@ -1,5 +1,6 @@
 #pragma once
 #include "point.h"
+#include <stdint.h>
 
 namespace polyanya
 {
@@ -117,4 +118,37 @@ inline bool is_collinear(const Point& a, const Point& b, const Point& c)
     return std::abs((b - a) * (c - b)) < EPSILON;
 }
 
+// A point with integer coordinates, as stored by compacted meshes.
+struct IntPoint
+{
+    int64_t x, y;
+
+    bool operator==(const IntPoint& other) const
+    {
+        return x == other.x && y == other.y;
+    }
+};
+
+// Like get_orientation, but exact, with no EPSILON. The coordinates must be
+// less than 2^30 in magnitude so that nothing overflows.
+inline Orientation get_orientation(
+    const IntPoint& a, const IntPoint& b, const IntPoint& c
+)
+{
+    const int64_t cross = (b.x - a.x) * (c.y - b.y) -
+                          (b.y - a.y) * (c.x - b.x);
+    if (cross == 0)
+    {
+        return Orientation::COLLINEAR;
+    }
+    else if (cross > 0)
+    {
+        return Orientation::CCW;
+    }
+    else
+    {
+        return Orientation::CW;
+    }
+}
+
 }
@@ -0,0 +1,47 @@
+#include "mappedfile.h"
+#include <string>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+namespace polyanya
+{
+
+bool MappedFile::open(const std::string& filename)
+{
+    close();
+    const int fd = ::open(filename.c_str(), O_RDONLY);
+    if (fd == -1)
+    {
+        return false;
+    }
+    struct stat st;
+    if (fstat(fd, &st) == -1 || st.st_size <= 0)
+    {
+        ::close(fd);
+        return false;
+    }
+    void* addr = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    // The mapping keeps its own reference to the file.
+    ::close(fd);
+    if (addr == MAP_FAILED)
+    {
+        return false;
+    }
+    data_ = static_cast<const char*>(addr);
+    size_ = st.st_size;
+    return true;
+}
+
+void MappedFile::close()
+{
+    if (data_ != nullptr)
+    {
+        munmap(const_cast<char*>(data_), size_);
+        data_ = nullptr;
+        size_ = 0;
+    }
+}
+
+}
@@ -0,0 +1,43 @@
+#pragma once
+#include <string>
+#include <cstddef>
+
+namespace polyanya
+{
+
+// A read-only memory mapping of a whole file.
+// The mapping is private to the process but backed by the page cache, so
+// several processes mapping the same file share its pages.
+class MappedFile
+{
+    private:
+        const char* data_;
+        size_t size_;
+
+    public:
+        MappedFile() : data_(nullptr), size_(0) { }
+        MappedFile(MappedFile const &) = delete;
+        void operator=(MappedFile const &x) = delete;
+        ~MappedFile() { close(); }
+
+        // Maps the file. Returns false (and stays closed) on failure.
+        bool open(const std::string& filename);
+        void close();
+
+        bool is_open() const
+        {
+            return data_ != nullptr;
+        }
+
+        const char* data() const
+        {
+            return data_;
+        }
+
+        size_t size() const
+        {
+            return size_;
+        }
+};
+
+}
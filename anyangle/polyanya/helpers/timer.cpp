@@ -60,10 +60,8 @@ double warthog::timer::elapsed_time_nano()
     //return (double) UnsignedWideToUInt64(nanosecs) ;
 
 #else
-    if ((stop_time.tv_nsec-start_time.tv_nsec)<0)
-        return (double)(1000000000+stop_time.tv_nsec-start_time.tv_nsec);
-    else
-        return (double)(stop_time.tv_nsec - start_time.tv_nsec);
+    return (double)(stop_time.tv_sec - start_time.tv_sec) * 1e9 +
+        (double)(stop_time.tv_nsec - start_time.tv_nsec);
 #endif
 }
 
@@ -0,0 +1,84 @@
+#include "workqueue.h"
+#include <deque>
+#include <mutex>
+#include <vector>
+#include <cassert>
+
+namespace polyanya
+{
+
+WorkStealingQueue::WorkStealingQueue(int num_workers)
+{
+    assert(num_workers > 0);
+    deques.resize(num_workers);
+    for (WorkerDeque*& d : deques)
+    {
+        d = new WorkerDeque;
+    }
+}
+
+WorkStealingQueue::~WorkStealingQueue()
+{
+    for (WorkerDeque* d : deques)
+    {
+        delete d;
+    }
+}
+
+void WorkStealingQueue::fill(int num_jobs)
+{
+    const int W = num_workers();
+    // Give each worker a contiguous block so that workers which never steal
+    // run their jobs in order.
+    int next_job = 0;
+    for (int i = 0; i < W; i++)
+    {
+        const int block = num_jobs / W + (i < num_jobs % W);
+        std::lock_guard<std::mutex> guard(deques[i]->lock);
+        deques[i]->jobs.clear();
+        for (int j = 0; j < block; j++)
+        {
+            deques[i]->jobs.push_back(next_job++);
+        }
+    }
+    assert(next_job == num_jobs);
+}
+
+bool WorkStealingQueue::pop_own(int worker, int& job)
+{
+    WorkerDeque& d = *deques[worker];
+    std::lock_guard<std::mutex> guard(d.lock);
+    if (d.jobs.empty())
+    {
+        return false;
+    }
+    job = d.jobs.front();
+    d.jobs.pop_front();
+    return true;
+}
+
+bool WorkStealingQueue::steal(int thief, int& job)
+{
+    const int W = num_workers();
+    // Start with our neighbour so that thieves spread themselves out.
+    for (int offset = 1; offset < W; offset++)
+    {
+        WorkerDeque& d = *deques[(thief + offset) % W];
+        std::lock_guard<std::mutex> guard(d.lock);
+        if (!d.jobs.empty())
+        {
+            job = d.jobs.back();
+            d.jobs.pop_back();
+            return true;
+        }
+    }
+    return false;
+}
+
+bool WorkStealingQueue::pop(int worker, int& job)
+{
+    assert(worker >= 0 && worker < num_workers());
+    return pop_own(worker, job) || steal(worker, job);
+}
+
+}
@@ -0,0 +1,47 @@
+#pragma once
+#include <deque>
+#include <mutex>
+#include <vector>
+
+namespace polyanya
+{
+
+// A work-stealing queue of job indices.
+// Each worker owns a deque which is filled with a contiguous block of jobs.
+// A worker pops jobs off the front of its own deque and, once that runs dry,
+// steals from the back of the other workers' deques.
+class WorkStealingQueue
+{
+    private:
+        struct WorkerDeque
+        {
+            std::mutex lock;
+            std::deque<int> jobs;
+        };
+
+        std::vector<WorkerDeque*> deques;
+
+        bool pop_own(int worker, int& job);
+        bool steal(int thief, int& job);
+
+    public:
+        WorkStealingQueue(int num_workers);
+        WorkStealingQueue(WorkStealingQueue const &) = delete;
+        void operator=(WorkStealingQueue const &x) = delete;
+        ~WorkStealingQueue();
+
+        // Distributes the jobs [0, num_jobs) between the workers.
+        // Must not be called while workers are popping.
+        void fill(int num_jobs);
+
+        // Gets the next job for the worker.
+        // Returns false when there are no jobs left anywhere.
+        bool pop(int worker, int& job);
+
+        int num_workers() const
+        {
+            return (int) deques.size();
+        }
+};
+
+}
@@ -1,6 +1,10 @@
 // Runs scenarios.
 #include "scenario.h"
+#include "batchfile.h"
 #include "searchinstance.h"
+#include "weightedsearchinstance.h"
+#include "queryservice.h"
+#include "openlist.h"
 #include "point.h"
 #include "mesh.h"
 #include "cfg.h"
@@ -10,14 +14,54 @@
 #include <vector>
 #include <iomanip>
 #include <algorithm>
+#include <cstdlib>
 
 using namespace std;
 using namespace polyanya;
 
-SearchInstance* si;
-
 int get_path = 0;
 int verbose = 0;
+int grid_index = 0;
+int compact = 0;
+size_t cache_capacity = 0;
+double cache_tolerance = 0;
+double weight = 1;
+vector<double> sweep_weights;
+vector<double> anytime_weights;
+double time_limit = 0;
+double crossing_spacing = 0;
+// With --stats, the stats of every search are added up here.
+string stats_format;
+SearchStats total_stats;
+// With --batch-output, results go here instead of to stdout.
+string batch_output;
+BatchResultWriter batch_writer;
+
+// Parses a comma separated list of heuristic weights, which must all be at
+// least 1. Returns false if it can't.
+bool parse_weights(const string& s, vector<double>& out)
+{
+    out.clear();
+    size_t begin = 0;
+    while (begin <= s.size())
+    {
+        size_t end = s.find(',', begin);
+        if (end == string::npos)
+        {
+            end = s.size();
+        }
+        const string token = s.substr(begin, end - begin);
+        char* token_end;
+        const double w = strtod(token.c_str(), &token_end);
+        if (token.empty() || *token_end != '\0' || !(w >= 1))
+        {
+            return false;
+        }
+        out.push_back(w);
+        begin = end + 1;
+    }
+    return true;
+}
 
 void print_header()
 {
@@ -25,23 +69,108 @@ void print_header()
          << "pruned_post_pop;length;gridcost" << endl;
 }
 
-void run_scenario(int index, Scenario scen)
+#ifndef NDEBUG
+// The mesh being searched, to check the cost of paths against.
+const Mesh* path_mesh = nullptr;
+
+// The cost of a piece of a path on a weighted mesh which doesn't pass
+// through a vertex: the weight of each polygon it crosses times the length
+// inside it. A piece along an edge between two weights costs the smaller
+// one. -1 if it can't be found.
+double weighted_piece_cost(const Mesh& mesh, const Point& a, const Point& b)
+{
+    // The ends are usually on edges or vertices, so walk from the middle.
+    const Point middle = (a + b) * 0.5;
+    const PointLocation loc = mesh.get_point_location(middle);
+    const PolygonArrays& polygons = mesh.mesh_polygons;
+    switch (loc.type)
+    {
+        case PointLocation::IN_POLYGON:
+        case PointLocation::ON_MESH_BORDER:
+        {
+            const double to_a = mesh.get_segment_cost(loc.poly1, middle, a);
+            const double to_b = mesh.get_segment_cost(loc.poly1, middle, b);
+            if (to_a < 0 || to_b < 0)
+            {
+                return -1;
+            }
+            return to_a + to_b;
+        }
+
+        case PointLocation::ON_EDGE:
+            return min(polygons.weight(loc.poly1),
+                       polygons.weight(loc.poly2)) * a.distance(b);
+
+        default:
+            return -1;
+    }
+}
+
+// As weighted_piece_cost, for a segment which may pass through vertices:
+// it is split at each of them.
+double weighted_segment_cost(const Mesh& mesh, const Point& a,
+                             const Point& b)
+{
+    const Point ab = b - a;
+    const double length = a.distance(b);
+    if (length < EPSILON)
+    {
+        return 0;
+    }
+    vector<double> splits = {0, 1};
+    for (int v = 0; v < mesh.mesh_vertices.size(); v++)
+    {
+        const Point& p = mesh.mesh_vertices.points[v];
+        const double t = ((p.x - a.x) * ab.x + (p.y - a.y) * ab.y) /
+                         (length * length);
+        if (t > 0 && t < 1 && std::abs(ab * (p - a)) < EPSILON * length)
+        {
+            splits.push_back(t);
+        }
+    }
+    sort(splits.begin(), splits.end());
+    double cost = 0;
+    for (int i = 1; i < (int) splits.size(); i++)
+    {
+        const Point from = a + ab * splits[i-1];
+        const Point to = a + ab * splits[i];
+        if (from.distance(to) < EPSILON)
+        {
+            continue;
+        }
+        const double piece = weighted_piece_cost(mesh, from, to);
+        if (piece < 0)
+        {
+            return -1;
+        }
+        cost += piece;
+    }
+    return cost;
+}
+#endif
+
+void print_result(int index, const Scenario& scen, const QueryResult& r)
 {
-    si->set_start_goal(scen.start, scen.goal);
-    si->search();
     if (get_path)
     {
-        vector<Point> path;
-        si->get_path_points(path);
+        const vector<Point>& path = r.path;
         const int n = (int) path.size();
 
         #ifndef NDEBUG
-        double actual = si->get_cost();
+        double actual = r.cost;
         double expected = min(actual, 0.0);
 
         for (int i = 1; i < n; i++)
         {
-            expected += path[i].distance(path[i-1]);
+            if (path_mesh->is_weighted())
+            {
+                expected += weighted_segment_cost(*path_mesh, path[i-1],
+                                                  path[i]);
+            }
+            else
+            {
+                expected += path[i].distance(path[i-1]);
+            }
         }
 
         if (std::abs(expected - actual) > 1e-8)
@@ -60,19 +189,303 @@ void run_scenario(int index, Scenario scen)
                 cout << " ";
             }
         }
-        cout << endl;
+        // Not endl: flushing every line is slow with millions of queries.
+        cout << "\n";
     }
     else
     {
         cout << index << ";"
-             << si->get_search_micro() << ";"
-             << si->successor_calls << ";"
-             << si->nodes_generated << ";"
-             << si->nodes_pushed << ";"
-             << si->nodes_popped << ";"
-             << si->nodes_pruned_post_pop << ";"
-             << setprecision(16) << si->get_cost() << ";"
-             << setprecision(8) << scen.gridcost << endl;
+             << r.micro << ";"
+             << r.successor_calls << ";"
+             << r.nodes_generated << ";"
+             << r.nodes_pushed << ";"
+             << r.nodes_popped << ";"
+             << r.nodes_pruned_post_pop << ";"
+             << setprecision(16) << r.cost << ";"
+             << setprecision(8) << scen.gridcost << "\n";
+    }
+}
+
+void write_batch_result(int worker, int index, const QueryResult& r)
+{
+    const BatchResultRecord record =
+    {
+        index, (int32_t) r.path.size(), r.cost, r.micro, r.successor_calls,
+        r.nodes_generated, r.nodes_pushed, r.nodes_popped,
+        r.nodes_pruned_post_pop, r.cache_hit
+    };
+    batch_writer.write(worker, record, r.path.data());
+}
+
+// Prints the result, or writes it to the batch output if there is one.
+void output_result(int index, const Scenario& scen, const QueryResult& r)
+{
+    if (batch_output.empty())
+    {
+        print_result(index, scen, r);
+    }
+    else
+    {
+        write_batch_result(0, index, r);
+    }
+}
+
+// The result of the search si just did.
+template<typename Instance>
+QueryResult get_result(Instance& si)
+{
+    QueryResult r;
+    r.cost = si.get_cost();
+    r.micro = si.get_search_micro();
+    r.successor_calls = si.successor_calls;
+    r.nodes_generated = si.nodes_generated;
+    r.nodes_pushed = si.nodes_pushed;
+    r.nodes_popped = si.nodes_popped;
+    r.nodes_pruned_post_pop = si.nodes_pruned_post_pop;
+    r.cache_hit = false;
+    if (get_path)
+    {
+        si.get_path_points(r.path);
+    }
+    return r;
+}
+
+template<typename Instance>
+void run_scenario(Instance& si, int index, const Scenario& scen)
+{
+    si.set_start_goal(scen.start, scen.goal);
+    si.search();
+    QueryResult r = get_result(si);
+    r.cache_hit = si.cache_hit;
+    output_result(index, scen, r);
+}
+
+// Printed on stderr, like the threaded summary.
+void print_cache_stats(int hits, int misses, double hit_micro,
+                       double miss_micro)
+{
+    cout.flush();
+    cerr << "cache_hits;cache_misses;hit_rate;avg_hit_micro;avg_miss_micro"
+         << endl
+         << hits << ";" << misses << ";"
+         << (hits + misses ? hits / (double) (hits + misses) : 0) << ";"
+         << (hits ? hit_micro / hits : 0) << ";"
+         << (misses ? miss_micro / misses : 0) << endl;
+}
+
+template<typename OpenList>
+void run_serial(Mesh* m, const vector<Scenario>& scenarios)
+{
+    SearchInstanceBase<OpenList> si(m);
+    if (verbose)
+    {
+        si.verbose = true;
+    }
+    si.enable_cache(cache_capacity, cache_tolerance);
+    si.set_weight(weight);
+    for (int i = 0; i < (int) scenarios.size(); i++)
+    {
+        run_scenario(si, i, scenarios[i]);
+    }
+    total_stats.merge(si.get_stats());
+    if (const PathCache* cache = si.get_cache())
+    {
+        print_cache_stats(cache->hits, cache->misses, cache->hit_micro,
+                          cache->miss_micro);
+    }
+}
+
+// Runs every scenario on a QueryService with the given number of threads,
+// then prints the usual per-query lines followed by throughput and latency
+// percentiles (on stderr, so that stdout stays parseable).
+template<typename OpenList>
+void run_threaded(Mesh* m, int num_threads, const vector<Scenario>& scenarios)
+{
+    QueryServiceBase<OpenList> service(m, num_threads);
+    service.enable_cache(cache_capacity, cache_tolerance);
+    service.set_weight(weight);
+    vector<Query> queries;
+    queries.reserve(scenarios.size());
+    for (const Scenario& scen : scenarios)
+    {
+        queries.push_back({scen.start, scen.goal});
+    }
+    const int n = (int) queries.size();
+    vector<double> latencies(n);
+    vector<char> cache_hits(n);
+    if (batch_output.empty())
+    {
+        vector<QueryResult> results;
+        service.run(queries, results, get_path);
+        for (int i = 0; i < n; i++)
+        {
+            print_result(i, scenarios[i], results[i]);
+            latencies[i] = results[i].micro;
+            cache_hits[i] = results[i].cache_hit;
+        }
+    }
+    else
+    {
+        // Results are written as they come, without waiting for the batch.
+        service.run(queries, [&](int worker, int index, const QueryResult& r)
+        {
+            latencies[index] = r.micro;
+            cache_hits[index] = r.cache_hit;
+            write_batch_result(worker, index, r);
+        }, get_path);
+    }
+    total_stats.merge(service.get_stats());
+    if (n == 0)
+    {
+        return;
+    }
+
+    int hits = 0;
+    double hit_micro = 0, miss_micro = 0;
+    for (int i = 0; i < n; i++)
+    {
+        hits += cache_hits[i];
+        (cache_hits[i] ? hit_micro : miss_micro) += latencies[i];
+    }
+
+    sort(latencies.begin(), latencies.end());
+    const auto percentile = [&](double p) -> double
+    {
+        // Nearest-rank percentile.
+        int rank = (int) (p / 100.0 * n + 0.5);
+        rank = max(1, min(n, rank));
+        return latencies[rank - 1];
+    };
+    const double batch_micro = service.get_batch_micro();
+    cout.flush();
+    cerr << "threads;queries;batch_micro;queries_per_sec;"
+         << "p50_micro;p90_micro;p99_micro;max_micro" << endl
+         << num_threads << ";" << n << ";" << batch_micro << ";"
+         << (batch_micro > 0 ? n / (batch_micro / 1e6) : 0) << ";"
+         << percentile(50) << ";" << percentile(90) << ";"
+         << percentile(99) << ";" << latencies.back() << endl;
+
+    if (cache_capacity)
+    {
+        print_cache_stats(hits, n - hits, hit_micro, miss_micro);
+    }
+}
+
+// Runs every scenario optimally, then again with each weight, printing one
+// summary line per weight: total effort, and how much longer the paths were.
+template<typename OpenList>
+void run_sweep(Mesh* m, const vector<Scenario>& scenarios)
+{
+    SearchInstanceBase<OpenList> si(m);
+    const int n = (int) scenarios.size();
+    vector<double> optimal(n);
+    for (int i = 0; i < n; i++)
+    {
+        si.set_start_goal(scenarios[i].start, scenarios[i].goal);
+        si.search();
+        optimal[i] = si.get_cost();
+    }
+
+    cout << "weight;queries;popped;generated;micro;"
+         << "mean_cost_ratio;max_cost_ratio" << endl;
+    for (const double w : sweep_weights)
+    {
+        si.set_weight(w);
+        long long popped = 0, generated = 0;
+        double micro = 0, ratio_sum = 0, ratio_max = 1;
+        int num_ratios = 0;
+        for (int i = 0; i < n; i++)
+        {
+            si.set_start_goal(scenarios[i].start, scenarios[i].goal);
+            si.search();
+            popped += si.nodes_popped;
+            generated += si.nodes_generated;
+            micro += si.get_search_micro();
+            // Leave out unreachable and trivial queries.
+            if (optimal[i] > 0)
+            {
+                const double ratio = si.get_cost() / optimal[i];
+                ratio_sum += ratio;
+                ratio_max = max(ratio_max, ratio);
+                num_ratios++;
+            }
+        }
+        cout << w << ";" << n << ";" << popped << ";" << generated << ";"
+             << micro << ";"
+             << setprecision(8) << (num_ratios ? ratio_sum / num_ratios : 1)
+             << ";" << ratio_max << setprecision(6) << endl;
+    }
+    total_stats.merge(si.get_stats());
+}
+
+// Runs every scenario with search_anytime(), printing the usual line for
+// the final path, followed by each solution it found on the way as
+// cost,bound,micro,popped.
+template<typename OpenList>
+void run_anytime(Mesh* m, const vector<Scenario>& scenarios)
+{
+    SearchInstanceBase<OpenList> si(m);
+    if (verbose)
+    {
+        si.verbose = true;
+    }
+    for (int i = 0; i < (int) scenarios.size(); i++)
+    {
+        const Scenario& scen = scenarios[i];
+        si.set_start_goal(scen.start, scen.goal);
+        si.search_anytime(anytime_weights, time_limit);
+        print_result(i, scen, get_result(si));
+
+        cout << "anytime " << i << ";";
+        for (const AnytimeSolution& s : si.get_anytime_solutions())
+        {
+            cout << " " << setprecision(16) << s.cost << setprecision(6)
+                 << "," << s.bound << "," << s.micro << "," << s.nodes_popped;
+        }
+        cout << endl;
+    }
+    total_stats.merge(si.get_stats());
+}
+
+// Weighted meshes have their own search (see weightedsearchinstance.h).
+void run_weighted(Mesh* m, const vector<Scenario>& scenarios)
+{
+    WeightedSearchInstance si(m);
+    if (verbose)
+    {
+        si.verbose = true;
+    }
+    if (crossing_spacing > 0)
+    {
+        si.set_crossing_spacing(crossing_spacing);
+    }
+    for (int i = 0; i < (int) scenarios.size(); i++)
+    {
+        const Scenario& scen = scenarios[i];
+        si.set_start_goal(scen.start, scen.goal);
+        si.search();
+        output_result(i, scen, get_result(si));
+    }
+}
+
+template<typename OpenList>
+void run(Mesh* m, int num_threads, const vector<Scenario>& scenarios)
+{
+    if (!sweep_weights.empty())
+    {
+        run_sweep<OpenList>(m, scenarios);
+    }
+    else if (!anytime_weights.empty())
+    {
+        run_anytime<OpenList>(m, scenarios);
+    }
+    else if (num_threads)
+    {
+        run_threaded<OpenList>(m, num_threads, scenarios);
+    }
+    else
+    {
+        run_serial<OpenList>(m, scenarios);
     }
 }
 
@@ -82,6 +495,20 @@ int main(int argc, char* argv[])
     {
         {"path", no_argument, &get_path, 1},
         {"verbose", no_argument, &verbose, 1},
+        {"grid-index", no_argument, &grid_index, 1},
+        {"compact", no_argument, &compact, 1},
+        {"threads", required_argument, 0, 1},
+        {"open-list", required_argument, 0, 1},
+        {"cache", required_argument, 0, 1},
+        {"cache-tolerance", required_argument, 0, 1},
+        {"weight", required_argument, 0, 1},
+        {"sweep-weights", required_argument, 0, 1},
+        {"anytime", required_argument, 0, 1},
+        {"time-limit", required_argument, 0, 1},
+        {"crossing-spacing", required_argument, 0, 1},
+        {"batch-output", required_argument, 0, 1},
+        {"stats", required_argument, 0, 1},
+        {0, 0, 0, 0}
     };
 
     warthog::util::cfg cfg;
@@ -89,49 +516,258 @@ int main(int argc, char* argv[])
 
     if (argc - optind != 2)
     {
-        cerr << "usage: " << argv[0] << "[--path] [--verbose]"
-             << "<mesh> <scenario>" << endl;
+        cerr << "usage: " << argv[0] << " [--path] [--verbose] [--grid-index]"
+             << " [--compact]"
+             << " [--threads N] [--open-list binary|4ary|pairing]"
+             << " [--cache N] [--cache-tolerance X]"
+             << " [--weight W | --sweep-weights W,... |"
+             << " --anytime W,... [--time-limit MICRO]]"
+             << " [--crossing-spacing X] [--batch-output FILE]"
+             << " [--stats csv|json]"
+             << " <mesh> <scenario>" << endl;
+        return 1;
+    }
+
+    int num_threads = 0;
+    const string threads_str = cfg.get_param_value("threads");
+    if (threads_str != "")
+    {
+        num_threads = atoi(threads_str.c_str());
+        if (num_threads < 1)
+        {
+            cerr << "--threads must be at least 1" << endl;
+            return 1;
+        }
+    }
+
+    const string cache_str = cfg.get_param_value("cache");
+    if (cache_str != "")
+    {
+        const int capacity = atoi(cache_str.c_str());
+        if (capacity < 0)
+        {
+            cerr << "--cache must not be negative" << endl;
+            return 1;
+        }
+        cache_capacity = capacity;
+    }
+    const string tolerance_str = cfg.get_param_value("cache-tolerance");
+    if (tolerance_str != "")
+    {
+        cache_tolerance = atof(tolerance_str.c_str());
+        if (cache_tolerance < 0)
+        {
+            cerr << "--cache-tolerance must not be negative" << endl;
+            return 1;
+        }
+    }
+
+    const string weight_str = cfg.get_param_value("weight");
+    if (weight_str != "")
+    {
+        weight = atof(weight_str.c_str());
+        if (!(weight >= 1))
+        {
+            cerr << "--weight must be at least 1" << endl;
+            return 1;
+        }
+    }
+    const string sweep_str = cfg.get_param_value("sweep-weights");
+    if (sweep_str != "" && !parse_weights(sweep_str, sweep_weights))
+    {
+        cerr << "--sweep-weights must be a comma separated list of weights"
+             << " of at least 1" << endl;
+        return 1;
+    }
+    const string anytime_str = cfg.get_param_value("anytime");
+    if (anytime_str != "" && !parse_weights(anytime_str, anytime_weights))
+    {
+        cerr << "--anytime must be a comma separated list of weights"
+             << " of at least 1" << endl;
+        return 1;
+    }
+    const string time_limit_str = cfg.get_param_value("time-limit");
+    if (time_limit_str != "")
+    {
+        time_limit = atof(time_limit_str.c_str());
+        if (time_limit <= 0 || anytime_weights.empty())
+        {
+            cerr << "--time-limit must be positive, and needs --anytime"
+                 << endl;
+            return 1;
+        }
+    }
+    if ((!sweep_weights.empty() || !anytime_weights.empty()) &&
+        (num_threads || cache_capacity || weight_str != "" ||
+         (!sweep_weights.empty() && !anytime_weights.empty())))
+    {
+        cerr << "--sweep-weights and --anytime can't be combined with each"
+             << " other or with --threads, --cache or --weight" << endl;
         return 1;
     }
 
-    string temp = argv[optind];;
-    ifstream meshfile(temp);
-    if (!meshfile.is_open())
+    const string spacing_str = cfg.get_param_value("crossing-spacing");
+    if (spacing_str != "")
+    {
+        crossing_spacing = atof(spacing_str.c_str());
+        if (!(crossing_spacing > 0))
+        {
+            cerr << "--crossing-spacing must be positive" << endl;
+            return 1;
+        }
+    }
+
+    batch_output = cfg.get_param_value("batch-output");
+    if (batch_output != "" &&
+        (!sweep_weights.empty() || !anytime_weights.empty()))
     {
-        cerr << "Unable to open mesh" << endl;
+        cerr << "--batch-output can't be combined with --sweep-weights or"
+             << " --anytime" << endl;
         return 1;
     }
-    Mesh* m = new Mesh(meshfile);
-    meshfile.close();
 
-    si = new SearchInstance(m);
+    stats_format = cfg.get_param_value("stats");
+    if (stats_format != "" && stats_format != "csv" && stats_format != "json")
+    {
+        cerr << "--stats must be csv or json" << endl;
+        return 1;
+    }
+    if (stats_format != "" && !SearchStats::enabled)
+    {
+        cerr << "--stats needs a build with POLYANYA_STATS (make stats)"
+             << endl;
+        return 1;
+    }
 
-    if (verbose)
+    string open_list = cfg.get_param_value("open-list");
+    if (open_list == "")
+    {
+        open_list = BinaryHeapOpenList::name();
+    }
+    if (open_list != BinaryHeapOpenList::name() &&
+        open_list != QuaternaryHeapOpenList::name() &&
+        open_list != PairingHeapOpenList::name())
     {
-        si->verbose = true;
+        cerr << "Unknown open list " << open_list << endl;
+        return 1;
     }
 
+    string temp = argv[optind];
+    Mesh* m;
+    if (Mesh::is_binary_file(temp))
+    {
+        m = new Mesh(temp);
+    }
+    else
+    {
+        ifstream meshfile(temp);
+        if (!meshfile.is_open())
+        {
+            cerr << "Unable to open mesh" << endl;
+            return 1;
+        }
+        m = new Mesh(meshfile, grid_index ? PointLocationMethod::GRID :
+                                            PointLocationMethod::SLAB);
+        meshfile.close();
+    }
+    if (compact)
+    {
+        const size_t before = m->memory_usage();
+        if (!m->compact())
+        {
+            cerr << "Unable to compact the mesh" << endl;
+            return 1;
+        }
+        cerr << "Compacted the mesh from " << before << " to "
+             << m->memory_usage() << " bytes" << endl;
+    }
+    #ifndef NDEBUG
+    path_mesh = m;
+    #endif
+
     vector<Scenario> scenarios;
     temp = argv[optind+1];
-    ifstream scenfile(temp);
-    if (!scenfile.is_open())
+    if (is_batch_queries_file(temp))
     {
-        cerr << "Unable to open scenarios" << endl;
+        if (!load_batch_queries(temp, scenarios))
+        {
+            return 1;
+        }
+    }
+    else
+    {
+        ifstream scenfile(temp);
+        if (!scenfile.is_open())
+        {
+            cerr << "Unable to open scenarios" << endl;
+            return 1;
+        }
+        load_scenarios(scenfile, scenarios);
+        scenfile.close();
+    }
+
+    if (batch_output != "" &&
+        !batch_writer.open(batch_output, max(num_threads, 1), get_path))
+    {
+        cerr << "Unable to open " << batch_output << endl;
         return 1;
     }
-    load_scenarios(scenfile, scenarios);
-    scenfile.close();
 
-    if (!get_path)
+    if (m->is_weighted())
     {
-        print_header();
+        if (num_threads || cache_capacity || weight != 1 ||
+            !sweep_weights.empty() || !anytime_weights.empty() ||
+            stats_format != "")
+        {
+            cerr << "Weighted meshes can't be searched with --threads,"
+                 << " --cache, --weight, --sweep-weights, --anytime or"
+                 << " --stats" << endl;
+            return 1;
+        }
+        if (!get_path && batch_output == "")
+        {
+            print_header();
+        }
+        run_weighted(m, scenarios);
     }
-    for (int i = 0; i < (int) scenarios.size(); i++)
+    else
+    {
+        if (!get_path && sweep_weights.empty() && batch_output == "")
+        {
+            print_header();
+        }
+        if (open_list == QuaternaryHeapOpenList::name())
+        {
+            run<QuaternaryHeapOpenList>(m, num_threads, scenarios);
+        }
+        else if (open_list == PairingHeapOpenList::name())
+        {
+            run<PairingHeapOpenList>(m, num_threads, scenarios);
+        }
+        else
+        {
+            run<BinaryHeapOpenList>(m, num_threads, scenarios);
+        }
+    }
+    if (stats_format != "")
     {
-        run_scenario(i, scenarios[i]);
+        // On stderr, like the other summaries.
+        cout.flush();
+        if (stats_format == "json")
+        {
+            total_stats.print_json(cerr);
+        }
+        else
+        {
+            total_stats.print_csv(cerr);
+        }
     }
 
-    delete si;
     delete m;
+    if (!batch_writer.close())
+    {
+        cerr << "Error writing " << batch_output << endl;
+        return 1;
+    }
     return 0;
 }
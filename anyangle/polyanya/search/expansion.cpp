@@ -85,15 +85,41 @@ double get_h_value(const Point& root, Point goal,
     }
 }
 
+// Gets the distance from root to the closest point on interval l-r.
+// Every point past the interval is at least this far from root, so it is
+// a lower bound on the h value for any goal.
+double get_interval_h_value(const Point& root, const Point& l,
+                            const Point& r)
+{
+    const Point lr = r - l;
+    const Point lroot = root - l;
+    const double len_sq = lr.x * lr.x + lr.y * lr.y;
+    if (len_sq < EPSILON * EPSILON)
+    {
+        return root.distance(l);
+    }
+    // Project root onto the line through l and r, clamped to the interval.
+    const double t = (lroot.x * lr.x + lroot.y * lr.y) / len_sq;
+    if (t <= 0)
+    {
+        return root.distance(l);
+    }
+    if (t >= 1)
+    {
+        return root.distance(r);
+    }
+    return root.distance(get_point_on_line(l, r, t));
+}
+
 // Internal binary search helper.
 // All indices must be within the range [0, 2 * N - 1] to make binary search
 // easier. You can normalise an index with this macro:
 #define normalise(index) (index) - ((index) >= N ? N : 0)
 // Assume that there exists at least one element within the range which
 // satisifies the predicate.
-template<typename Type, typename Pred>
-inline int binary_search(const std::vector<int>& arr, const int N,
-                         const std::vector<Type>& objects, int lower, int upper,
+template<typename Objects, typename Pred>
+inline int binary_search(const int* arr, const int N,
+                         const Objects& objects, int lower, int upper,
                          const Pred pred, const bool is_upper_bound)
 {
     if (lower == upper) return lower;
@@ -131,21 +157,28 @@ inline int binary_search(const std::vector<int>& arr, const int N,
 
 // TODO: Wrap this in a class so we don't have to keep passing the same params
 // over and over again
-// Generates the successors of the search node and sets them in the successor
-// vector. Returns number of successors generated.
-int get_successors(SearchNode& node, const Point& start, const Mesh& mesh,
-                   Successor* successors)
+// get_successors, with the vertex points read through mesh_points: either
+// the mesh's doubles or one width of its quantised points.
+template<bool Triangles, typename Points>
+int get_successors_with(SearchNode& node, const Point& start,
+                        const Mesh& mesh, const Points& mesh_points,
+                        Successor* successors)
 {
     // If the next polygon is -1, we did a bad job at pruning...
     assert(node.next_polygon != -1);
 
-    const Polygon& polygon = mesh.mesh_polygons[node.next_polygon];
-    const std::vector<Vertex>& mesh_vertices = mesh.mesh_vertices;
+    // Read the packed arrays directly: the polygon's vertex indices are
+    // contiguous, as are all vertex points.
+    const PolygonArrays& mesh_polygons = mesh.mesh_polygons;
+    const VertexArrays& mesh_vertices = mesh.mesh_vertices;
     // V, P and N are solely used for conciseness
-    const std::vector<int>& V = polygon.vertices;
-    const int N = (int) V.size();
+    const int* V = mesh_polygons.vertices +
+                   mesh_polygons.offsets[node.next_polygon];
+    // A constant for triangles, so the loops below are unrolled.
+    const int N = Triangles ? 3 : mesh_polygons.num_sides(node.next_polygon);
+    assert(N == mesh_polygons.num_sides(node.next_polygon));
 
-    const Point& root = (node.root == -1 ? start : mesh_vertices[node.root].p);
+    const Point& root = (node.root == -1 ? start : mesh_points[node.root]);
 
     int out = 0;
 
@@ -177,7 +210,7 @@ int get_successors(SearchNode& node, const Point& start, const Mesh& mesh,
                 )))
             {
                 // We should turn at L... if we can!
-                if (!mesh_vertices[node.left_vertex].is_corner)
+                if (!mesh_vertices.is_corner(node.left_vertex))
                 {
                     return 0;
                 }
@@ -186,7 +219,7 @@ int get_successors(SearchNode& node, const Point& start, const Mesh& mesh,
             else
             {
                 // We should turn at R... if we can!
-                if (!mesh_vertices[node.right_vertex].is_corner)
+                if (!mesh_vertices.is_corner(node.right_vertex))
                 {
                     return 0;
                 }
@@ -195,7 +228,7 @@ int get_successors(SearchNode& node, const Point& start, const Mesh& mesh,
 
             // We can be lazy and start iterating from any point.
             // We still need to exclude the current interval as a successor.
-            int last_vertex = V.back();
+            int last_vertex = V[N - 1];
 
             for (int i = 0; i < N; i++)
             {
@@ -207,8 +240,8 @@ int get_successors(SearchNode& node, const Point& start, const Mesh& mesh,
                     last_vertex = this_vertex;
                     continue;
                 }
-                const Point& left = mesh_vertices[this_vertex].p;
-                const Point& right = mesh_vertices[last_vertex].p;
+                const Point& left = mesh_points[this_vertex];
+                const Point& right = mesh_points[last_vertex];
                 successors[out++] = {succ_type, left, right, i};
                 last_vertex = this_vertex;
             }
@@ -217,16 +250,16 @@ int get_successors(SearchNode& node, const Point& start, const Mesh& mesh,
     }
 
 
-    if (N == 3)
+    if (Triangles || N == 3)
     {
         int p1; // V[p1] = t2. Used for poly_left_ind for 1-2 successors.
         int p2; // V[p2] = t3. Used for poly_left_ind for 2-3 successors.
         // Note that p3 is redundant, as that's the polygon we came from.
 
         // The right point of the triangle.
-        const Point& t1 = mesh_vertices[node.right_vertex].p;
+        const Point& t1 = mesh_points[node.right_vertex];
         // The middle point of the triangle.
-        const Point& t2 = [&]() -> const Point&
+        const Point t2 = [&]() -> Point
         {
             // horrible hacky lambda which also sets p1/p2
 
@@ -236,25 +269,25 @@ int get_successors(SearchNode& node, const Point& start, const Mesh& mesh,
                 // t1 = V[0], t2 = V[1], t3 = V[2]
                 p1 = 1;
                 p2 = 2;
-                return mesh_vertices[V[1]].p;
+                return mesh_points[V[1]];
             }
             else if (V[0] == node.left_vertex)
             {
                 // t1 = V[1], t2 = V[2], t3 = V[0]
                 p1 = 2;
                 p2 = 0;
-                return mesh_vertices[V[2]].p;
+                return mesh_points[V[2]];
             }
             else
             {
                 // t1 = V[2], t2 = V[0], t3 = V[1]
                 p1 = 0;
                 p2 = 1;
-                return mesh_vertices[V[0]].p;
+                return mesh_points[V[0]];
             }
         }();
         // The left point of the triangle.
-        const Point& t3 = mesh_vertices[node.left_vertex].p;
+        const Point& t3 = mesh_points[node.left_vertex];
 
 
 
@@ -285,7 +318,7 @@ int get_successors(SearchNode& node, const Point& start, const Mesh& mesh,
                 };
 
                 // if we can turn left
-                if (mesh_vertices[node.left_vertex].is_corner && L == t3)
+                if (mesh_vertices.is_corner(node.left_vertex) && L == t3)
                 {
                     // left_non_observable(LI, 2)
                     successors[1] = {
@@ -321,7 +354,7 @@ int get_successors(SearchNode& node, const Point& start, const Mesh& mesh,
                 };
 
                 // if we can turn left
-                if (mesh_vertices[node.left_vertex].is_corner && L == t3)
+                if (mesh_vertices.is_corner(node.left_vertex) && L == t3)
                 {
                     // left_collinear(2, 3)
                     successors[1] = {
@@ -351,7 +384,7 @@ int get_successors(SearchNode& node, const Point& start, const Mesh& mesh,
                         const Point RI = line_intersect(t2, t3, root, R);
 
                         // if we can turn right
-                        if (mesh_vertices[node.right_vertex].is_corner &&
+                        if (mesh_vertices.is_corner(node.right_vertex) &&
                             R == t1)
                         {
                             // right_collinear(1, 2)
@@ -392,7 +425,7 @@ int get_successors(SearchNode& node, const Point& start, const Mesh& mesh,
                     {
                         // RI = 2
                         // if we can turn right
-                        if (mesh_vertices[node.right_vertex].is_corner &&
+                        if (mesh_vertices.is_corner(node.right_vertex) &&
                             R == t1)
                         {
                             // right_collinear(1, 2)
@@ -453,6 +486,8 @@ int get_successors(SearchNode& node, const Point& start, const Mesh& mesh,
             default:
                 assert(false);
         }
+        // Unreachable. This lets the code below be left out for triangles.
+        return out;
     }
 
 
@@ -482,16 +517,17 @@ int get_successors(SearchNode& node, const Point& start, const Mesh& mesh,
     assert(V[normalise(left_ind)] == node.left_vertex);
 
     // Find whether we can turn at either endpoint.
-    const Vertex& right_vertex_obj = mesh_vertices[node.right_vertex];
-    const Vertex& left_vertex_obj  = mesh_vertices[V[normalise(left_ind)]];
+    const int left_vertex = V[normalise(left_ind)];
+    const bool right_is_corner = mesh_vertices.is_corner(node.right_vertex);
+    const bool left_is_corner  = mesh_vertices.is_corner(left_vertex);
 
-    const Point& right_p = right_vertex_obj.p;
-    const Point& left_p  = left_vertex_obj.p;
+    const Point& right_p = mesh_points[node.right_vertex];
+    const Point& left_p  = mesh_points[left_vertex];
     const bool right_lies_vertex = right_p == node.right;
     const bool left_lies_vertex  = left_p == node.left;
 
     // Macro for getting a point from a polygon point index.
-    #define index2point(index) mesh_vertices[V[index]].p
+    #define index2point(index) mesh_points[V[index]]
 
     // find the transition between non-observable-right and observable.
     // we will call this A, defined by:
@@ -515,11 +551,11 @@ int get_successors(SearchNode& node, const Point& start, const Mesh& mesh,
                 return right_ind + 1;
             }
         }
-        return binary_search(V, N, mesh_vertices, right_ind + 1, left_ind,
-            [&root_right, &node](const Vertex& v)
+        return binary_search(V, N, mesh_points, right_ind + 1, left_ind,
+            [&root_right, &node](const Point& p)
             {
                 // STRICTLY CCW.
-                return root_right * (v.p - node.right) > EPSILON;
+                return root_right * (p - node.right) > EPSILON;
             }, false
         );
     }();
@@ -552,11 +588,11 @@ int get_successors(SearchNode& node, const Point& start, const Mesh& mesh,
                 return left_ind - 1;
             }
         }
-        return binary_search(V, N, mesh_vertices, A - 1, left_ind - 1,
-            [&root_left, &node](const Vertex& v)
+        return binary_search(V, N, mesh_points, A - 1, left_ind - 1,
+            [&root_left, &node](const Point& p)
             {
                 // STRICTLY CW.
-                return root_left * (v.p - node.left) < -EPSILON;
+                return root_left * (p - node.left) < -EPSILON;
             }, true
         );
     }();
@@ -569,7 +605,7 @@ int get_successors(SearchNode& node, const Point& start, const Mesh& mesh,
 
     // Macro to update this_inde/last_ind.
     #define update_ind() last_ind = cur_ind++; if (cur_ind == N) cur_ind = 0
-    if (right_lies_vertex && right_vertex_obj.is_corner)
+    if (right_lies_vertex && right_is_corner)
     {
         // Generate non-observable.
 
@@ -677,7 +713,7 @@ int get_successors(SearchNode& node, const Point& start, const Mesh& mesh,
         };
     }
 
-    if (left_lies_vertex && left_vertex_obj.is_corner)
+    if (left_lies_vertex && left_is_corner)
     {
         // Generate non-observable from left_intersect to Bp1_p
         // if left_intersect != Bp1_p.
@@ -716,6 +752,36 @@ int get_successors(SearchNode& node, const Point& start, const Mesh& mesh,
     return out;
 }
 
+// Generates the successors of the search node and sets them in the successor
+// vector. Returns number of successors generated.
+template<bool Triangles>
+int get_successors(SearchNode& node, const Point& start, const Mesh& mesh,
+                   Successor* successors)
+{
+    // Check how the points are stored once, not on every read.
+    const VertexPoints& points = mesh.mesh_vertices.points;
+    if (points.doubles)
+    {
+        return get_successors_with<Triangles>(node, start, mesh,
+                                              points.doubles, successors);
+    }
+    if (points.coords16)
+    {
+        const QuantisedPoints<int16_t> coords16 =
+            {points.coords16, points.unit};
+        return get_successors_with<Triangles>(node, start, mesh, coords16,
+                                              successors);
+    }
+    const QuantisedPoints<int32_t> coords32 = {points.coords32, points.unit};
+    return get_successors_with<Triangles>(node, start, mesh, coords32,
+                                          successors);
+}
+
+template int get_successors<false>(SearchNode& node, const Point& start,
+                                   const Mesh& mesh, Successor* successors);
+template int get_successors<true>(SearchNode& node, const Point& start,
+                                  const Mesh& mesh, Successor* successors);
+
 #undef normalise
 
 }
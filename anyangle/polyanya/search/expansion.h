@@ -12,8 +12,17 @@ namespace polyanya
 double get_h_value(const Point& root, Point goal,
                    const Point& l, const Point& r);
 
+// Gets a lower bound on the h value of a search node with interval l-r and
+// root "root" which holds for every goal past the interval.
+double get_interval_h_value(const Point& root, const Point& l,
+                            const Point& r);
+
 // Generates the successors of the search node and sets them in the successor
 // vector. Returns number of successors generated.
+// With Triangles, every polygon of the mesh must be a triangle
+// (max_poly_sides == 3), which lets the general polygon code be left out.
+// Instantiated for both in expansion.cpp.
+template<bool Triangles = false>
 int get_successors(SearchNode& node, const Point& start, const Mesh& mesh,
                    Successor* successors);
 }
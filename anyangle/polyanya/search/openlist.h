@@ -0,0 +1,265 @@
+#pragma once
+#include "searchnode.h"
+#include <vector>
+#include <algorithm>
+#include <cassert>
+
+// Open lists for SearchInstance.
+// All of them pop the node with the smallest f, breaking ties on the largest
+// g (see SearchNode::operator<), and keep their memory between searches:
+// clear() empties the list without giving back its capacity.
+//
+// An open list provides:
+//   void push(SearchNodePtr);
+//   SearchNodePtr top() const;
+//   void pop();
+//   bool empty() const;
+//   size_t size() const;
+//   size_t capacity() const; // changes only when the list reallocates
+//   void clear();
+
+namespace polyanya
+{
+
+// A binary heap of node pointers.
+// Uses std::push_heap/std::pop_heap, so nodes come out in exactly the same
+// order as they did from std::priority_queue.
+class BinaryHeapOpenList
+{
+    private:
+        struct Compare
+        {
+            bool operator()(const SearchNode* x, const SearchNode* y) const
+            {
+                return *x > *y;
+            }
+        };
+        std::vector<SearchNodePtr> heap;
+
+    public:
+        static const char* name() { return "binary"; }
+
+        void push(SearchNodePtr node)
+        {
+            heap.push_back(node);
+            std::push_heap(heap.begin(), heap.end(), Compare());
+        }
+
+        SearchNodePtr top() const
+        {
+            assert(!heap.empty());
+            return heap.front();
+        }
+
+        void pop()
+        {
+            std::pop_heap(heap.begin(), heap.end(), Compare());
+            heap.pop_back();
+        }
+
+        bool empty() const { return heap.empty(); }
+        size_t size() const { return heap.size(); }
+        size_t capacity() const { return heap.capacity(); }
+        void clear() { heap.clear(); }
+};
+
+// A D-ary heap which stores the f and g keys inline next to the node
+// pointer, so sifting never dereferences a node.
+template<int D>
+class DaryHeapOpenList
+{
+    private:
+        struct Entry
+        {
+            double f, g;
+            SearchNodePtr node;
+
+            // Whether this should be popped before other.
+            bool before(const Entry& other) const
+            {
+                if (f == other.f)
+                {
+                    return g > other.g;
+                }
+                return f < other.f;
+            }
+        };
+        std::vector<Entry> heap;
+
+    public:
+        static const char* name() { return D == 4 ? "4ary" : "dary"; }
+
+        void push(SearchNodePtr node)
+        {
+            const Entry e = {node->f, node->g, node};
+            size_t i = heap.size();
+            heap.push_back(e);
+            // Sift up.
+            while (i > 0)
+            {
+                const size_t parent = (i - 1) / D;
+                if (!e.before(heap[parent]))
+                {
+                    break;
+                }
+                heap[i] = heap[parent];
+                i = parent;
+            }
+            heap[i] = e;
+        }
+
+        SearchNodePtr top() const
+        {
+            assert(!heap.empty());
+            return heap.front().node;
+        }
+
+        void pop()
+        {
+            assert(!heap.empty());
+            const Entry e = heap.back();
+            heap.pop_back();
+            const size_t n = heap.size();
+            if (n == 0)
+            {
+                return;
+            }
+            // Sift the last entry down from the root.
+            size_t i = 0;
+            while (true)
+            {
+                const size_t first = D * i + 1;
+                if (first >= n)
+                {
+                    break;
+                }
+                const size_t last = std::min(first + D, n);
+                size_t best = first;
+                for (size_t c = first + 1; c < last; c++)
+                {
+                    if (heap[c].before(heap[best]))
+                    {
+                        best = c;
+                    }
+                }
+                if (!heap[best].before(e))
+                {
+                    break;
+                }
+                heap[i] = heap[best];
+                i = best;
+            }
+            heap[i] = e;
+        }
+
+        bool empty() const { return heap.empty(); }
+        size_t size() const { return heap.size(); }
+        size_t capacity() const { return heap.capacity(); }
+        void clear() { heap.clear(); }
+};
+
+typedef DaryHeapOpenList<4> QuaternaryHeapOpenList;
+
+// A pairing heap whose entries live in a pooled array and refer to each
+// other by index. Push is O(1); pop uses the two-pass pairing.
+class PairingHeapOpenList
+{
+    private:
+        struct Entry
+        {
+            double f, g;
+            SearchNodePtr node;
+            int child;   // first child, -1 if none
+            int sibling; // next sibling, -1 if none
+
+            bool before(const Entry& other) const
+            {
+                if (f == other.f)
+                {
+                    return g > other.g;
+                }
+                return f < other.f;
+            }
+        };
+        // Entries are never reused within a search; clear() resets the pool.
+        std::vector<Entry> pool;
+        int root;
+        size_t num_entries;
+        // Scratch space for pop().
+        std::vector<int> pairs;
+
+        // Makes the loser a child of the winner and returns the winner.
+        int meld(int a, int b)
+        {
+            if (a == -1) return b;
+            if (b == -1) return a;
+            if (pool[b].before(pool[a]))
+            {
+                std::swap(a, b);
+            }
+            pool[b].sibling = pool[a].child;
+            pool[a].child = b;
+            return a;
+        }
+
+    public:
+        PairingHeapOpenList() : root(-1), num_entries(0) { }
+
+        static const char* name() { return "pairing"; }
+
+        void push(SearchNodePtr node)
+        {
+            pool.push_back({node->f, node->g, node, -1, -1});
+            root = meld(root, (int) pool.size() - 1);
+            num_entries++;
+        }
+
+        SearchNodePtr top() const
+        {
+            assert(root != -1);
+            return pool[root].node;
+        }
+
+        void pop()
+        {
+            assert(root != -1);
+            // First pass: meld the children in pairs, left to right.
+            pairs.clear();
+            int child = pool[root].child;
+            while (child != -1)
+            {
+                const int next = pool[child].sibling;
+                pool[child].sibling = -1;
+                if (next == -1)
+                {
+                    pairs.push_back(child);
+                    break;
+                }
+                const int after = pool[next].sibling;
+                pool[next].sibling = -1;
+                pairs.push_back(meld(child, next));
+                child = after;
+            }
+            // Second pass: meld the pairs right to left.
+            int new_root = -1;
+            for (int i = (int) pairs.size() - 1; i >= 0; i--)
+            {
+                new_root = meld(new_root, pairs[i]);
+            }
+            root = new_root;
+            num_entries--;
+        }
+
+        bool empty() const { return root == -1; }
+        size_t size() const { return num_entries; }
+        size_t capacity() const { return pool.capacity() + pairs.capacity(); }
+
+        void clear()
+        {
+            pool.clear();
+            root = -1;
+            num_entries = 0;
+        }
+};
+
+}
@@ -0,0 +1,53 @@
+#include "pathcache.h"
+#include <list>
+#include <unordered_map>
+#include <iterator>
+#include <cassert>
+
+namespace polyanya
+{
+
+const PathCache::Entry* PathCache::find(int start_polygon, int goal_polygon)
+{
+    const auto it = index.find(get_key(start_polygon, goal_polygon));
+    if (it == index.end())
+    {
+        return nullptr;
+    }
+    // Move to the front.
+    items.splice(items.begin(), items, it->second);
+    return &it->second->entry;
+}
+
+PathCache::Entry& PathCache::insert(int start_polygon, int goal_polygon)
+{
+    assert(capacity > 0);
+    const uint64_t key = get_key(start_polygon, goal_polygon);
+    const auto it = index.find(key);
+    if (it != index.end())
+    {
+        items.splice(items.begin(), items, it->second);
+        return it->second->entry;
+    }
+    if (items.size() < capacity)
+    {
+        items.emplace_front();
+    }
+    else
+    {
+        // Reuse the least recently used item (and its turns buffer).
+        index.erase(items.back().key);
+        items.splice(items.begin(), items, std::prev(items.end()));
+    }
+    items.front().key = key;
+    index[key] = items.begin();
+    return items.front().entry;
+}
+
+void PathCache::clear()
+{
+    items.clear();
+    index.clear();
+}
+
+}
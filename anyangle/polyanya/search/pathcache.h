@@ -0,0 +1,79 @@
+#pragma once
+#include "point.h"
+#include <list>
+#include <unordered_map>
+#include <vector>
+#include <cstddef>
+#include <stdint.h>
+
+namespace polyanya
+{
+
+// A bounded, least recently used cache of search results, keyed by the
+// polygons the start and goal were in.
+// SearchInstance stores the turning vertices of every path it searches for,
+// and later tries to reuse them for new points in the same polygons.
+class PathCache
+{
+    public:
+        struct Entry
+        {
+            // The query which was searched for.
+            Point start, goal;
+            double cost; // -1 if there was no path
+            // Vertices the path turns at, from start to goal.
+            std::vector<int> turns;
+        };
+
+    private:
+        struct Item
+        {
+            uint64_t key;
+            Entry entry;
+        };
+        size_t capacity;
+        // Most recently used first.
+        std::list<Item> items;
+        std::unordered_map<uint64_t, std::list<Item>::iterator> index;
+
+        static uint64_t get_key(int start_polygon, int goal_polygon)
+        {
+            return ((uint64_t) (uint32_t) start_polygon << 32) |
+                   (uint32_t) goal_polygon;
+        }
+
+    public:
+        // Hits and misses are counted by whoever uses the cache, along with
+        // the total time spent answering them.
+        int hits, misses;
+        double hit_micro, miss_micro;
+
+        PathCache(size_t cap) : capacity(cap) { reset_stats(); }
+
+        // Returns nullptr if the pair isn't cached.
+        const Entry* find(int start_polygon, int goal_polygon);
+        // Returns the entry for the pair to be filled in, making room by
+        // evicting the least recently used entry if needed.
+        Entry& insert(int start_polygon, int goal_polygon);
+        void clear();
+
+        void reset_stats()
+        {
+            hits = 0;
+            misses = 0;
+            hit_micro = 0;
+            miss_micro = 0;
+        }
+
+        double hit_rate() const
+        {
+            return hits + misses ? hits / (double) (hits + misses) : 0;
+        }
+
+        size_t size() const
+        {
+            return items.size();
+        }
+};
+
+}
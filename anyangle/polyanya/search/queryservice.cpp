@@ -0,0 +1,193 @@
+#include "queryservice.h"
+#include "searchinstance.h"
+#include "openlist.h"
+#include "workqueue.h"
+#include "mesh.h"
+#include "point.h"
+#include <vector>
+#include <thread>
+#include <cassert>
+
+namespace polyanya
+{
+
+template<typename OpenList>
+QueryServiceBase<OpenList>::QueryServiceBase(MeshPtr m, int num_threads) :
+    mesh(m), queue(num_threads)
+{
+    assert(mesh != nullptr);
+    assert(num_threads > 0);
+    instances.resize(num_threads);
+    for (Instance*& si : instances)
+    {
+        si = new Instance(mesh);
+    }
+}
+
+template<typename OpenList>
+QueryServiceBase<OpenList>::~QueryServiceBase()
+{
+    for (Instance* si : instances)
+    {
+        delete si;
+    }
+}
+
+template<typename OpenList>
+void QueryServiceBase<OpenList>::fill_result(Instance& si, QueryResult& r,
+                                             bool get_path)
+{
+    r.cost = si.get_cost();
+    r.micro = si.get_search_micro();
+    r.successor_calls = si.successor_calls;
+    r.nodes_generated = si.nodes_generated;
+    r.nodes_pushed = si.nodes_pushed;
+    r.nodes_popped = si.nodes_popped;
+    r.nodes_pruned_post_pop = si.nodes_pruned_post_pop;
+    r.cache_hit = si.cache_hit;
+    r.path.clear();
+    if (get_path)
+    {
+        si.get_path_points(r.path);
+    }
+}
+
+template<typename OpenList>
+void QueryServiceBase<OpenList>::work(
+    int worker, const std::vector<Query>& queries,
+    std::vector<QueryResult>& results, bool get_path
+)
+{
+    Instance& si = *instances[worker];
+    int index;
+    while (queue.pop(worker, index))
+    {
+        const Query& q = queries[index];
+        // Each index is handed out exactly once, so no two threads ever
+        // write to the same result.
+        si.set_start_goal(q.start, q.goal);
+        si.search();
+        fill_result(si, results[index], get_path);
+    }
+}
+
+template<typename OpenList>
+void QueryServiceBase<OpenList>::work_streamed(
+    int worker, const std::vector<Query>& queries,
+    const ResultCallback& on_result, bool get_path
+)
+{
+    Instance& si = *instances[worker];
+    // Reused, so that its path doesn't allocate once it has grown.
+    QueryResult r;
+    int index;
+    while (queue.pop(worker, index))
+    {
+        const Query& q = queries[index];
+        si.set_start_goal(q.start, q.goal);
+        si.search();
+        fill_result(si, r, get_path);
+        on_result(worker, index, r);
+    }
+}
+
+template<typename OpenList>
+template<typename Fn>
+void QueryServiceBase<OpenList>::run_workers(const Fn& fn)
+{
+    const int T = num_threads();
+    std::vector<std::thread> threads;
+    threads.reserve(T - 1);
+    for (int i = 1; i < T; i++)
+    {
+        threads.emplace_back(fn, i);
+    }
+    // The calling thread is worker 0.
+    fn(0);
+    for (std::thread& t : threads)
+    {
+        t.join();
+    }
+}
+
+template<typename OpenList>
+void QueryServiceBase<OpenList>::run(const std::vector<Query>& queries,
+                                     std::vector<QueryResult>& results,
+                                     bool get_path)
+{
+    results.resize(queries.size());
+    timer.start();
+    queue.fill((int) queries.size());
+    run_workers([&](int worker)
+    {
+        work(worker, queries, results, get_path);
+    });
+    timer.stop();
+}
+
+template<typename OpenList>
+void QueryServiceBase<OpenList>::run(const std::vector<Query>& queries,
+                                     const ResultCallback& on_result,
+                                     bool get_path)
+{
+    timer.start();
+    queue.fill((int) queries.size());
+    run_workers([&](int worker)
+    {
+        work_streamed(worker, queries, on_result, get_path);
+    });
+    timer.stop();
+}
+
+template<typename OpenList>
+void QueryServiceBase<OpenList>::work_table(
+    int worker, const std::vector<Point>& sources,
+    const std::vector<Point>& targets, std::vector<double>& table,
+    std::vector<std::vector<Point>>* paths
+)
+{
+    Instance& si = *instances[worker];
+    const int num_targets = (int) targets.size();
+    int row;
+    while (queue.pop(worker, row))
+    {
+        si.set_start_targets(sources[row], targets);
+        si.search_many();
+        for (int j = 0; j < num_targets; j++)
+        {
+            const int index = row * num_targets + j;
+            table[index] = si.get_target_cost(j);
+            if (paths)
+            {
+                (*paths)[index].clear();
+                si.get_target_path_points(j, (*paths)[index]);
+            }
+        }
+    }
+}
+
+template<typename OpenList>
+void QueryServiceBase<OpenList>::run_table(
+    const std::vector<Point>& sources, const std::vector<Point>& targets,
+    std::vector<double>& table, std::vector<std::vector<Point>>* paths
+)
+{
+    table.resize(sources.size() * targets.size());
+    if (paths)
+    {
+        paths->resize(table.size());
+    }
+    timer.start();
+    queue.fill((int) sources.size());
+    run_workers([&](int worker)
+    {
+        work_table(worker, sources, targets, table, paths);
+    });
+    timer.stop();
+}
+
+template class QueryServiceBase<BinaryHeapOpenList>;
+template class QueryServiceBase<QuaternaryHeapOpenList>;
+template class QueryServiceBase<PairingHeapOpenList>;
+
+}
@@ -0,0 +1,134 @@
+#pragma once
+#include "searchinstance.h"
+#include "workqueue.h"
+#include "mesh.h"
+#include "point.h"
+#include "timer.h"
+#include <vector>
+#include <functional>
+
+namespace polyanya
+{
+
+struct Query
+{
+    Point start, goal;
+};
+
+// The outcome of a single query, mirroring the getters of SearchInstance.
+struct QueryResult
+{
+    double cost;  // -1 if there is no path
+    double micro; // time spent in SearchInstance::search()
+    int successor_calls;
+    int nodes_generated;
+    int nodes_pushed;
+    int nodes_popped;
+    int nodes_pruned_post_pop;
+    bool cache_hit;
+    std::vector<Point> path; // only filled in if paths are requested
+};
+
+// Called with each result of QueryServiceBase::run() as it is found. worker
+// is the index (from 0) of the thread calling it.
+typedef std::function<void(int worker, int index, const QueryResult& result)>
+    ResultCallback;
+
+// Answers batches of queries on a single mesh using several threads.
+// The mesh is shared read-only between the threads, and each thread owns a
+// SearchInstance (and therefore its own node pool, open list and root pruning
+// arrays) which is reused across queries and batches.
+// Like SearchInstanceBase, this is explicitly instantiated for each open list.
+template<typename OpenList = BinaryHeapOpenList>
+class QueryServiceBase
+{
+    typedef SearchInstanceBase<OpenList> Instance;
+    private:
+        MeshPtr mesh;
+        std::vector<Instance*> instances;
+        WorkStealingQueue queue;
+        warthog::timer timer;
+
+        static void fill_result(Instance& si, QueryResult& r, bool get_path);
+        void work(int worker, const std::vector<Query>& queries,
+                  std::vector<QueryResult>& results, bool get_path);
+        void work_streamed(int worker, const std::vector<Query>& queries,
+                           const ResultCallback& on_result, bool get_path);
+        void work_table(int worker, const std::vector<Point>& sources,
+                        const std::vector<Point>& targets,
+                        std::vector<double>& table,
+                        std::vector<std::vector<Point>>* paths);
+        // Runs fn(worker) on every thread, the calling one being worker 0.
+        template<typename Fn>
+        void run_workers(const Fn& fn);
+
+    public:
+        QueryServiceBase(MeshPtr m, int num_threads);
+        QueryServiceBase(QueryServiceBase const &) = delete;
+        void operator=(QueryServiceBase const &x) = delete;
+        ~QueryServiceBase();
+
+        // Runs every query, blocking until all of them are done.
+        // results[i] is the answer to queries[i].
+        void run(const std::vector<Query>& queries,
+                 std::vector<QueryResult>& results, bool get_path = false);
+        // As above, but hands each result to on_result as soon as it is
+        // found instead of keeping them all. Different threads call
+        // on_result at the same time.
+        void run(const std::vector<Query>& queries,
+                 const ResultCallback& on_result, bool get_path = false);
+
+        // Fills in a distance table: table[i * targets.size() + j] is the
+        // cost from sources[i] to targets[j], or -1 if there is no path.
+        // Each row is a single one-to-many search, and the rows are shared
+        // out between the threads. Paths are filled in the same order if
+        // requested.
+        void run_table(const std::vector<Point>& sources,
+                       const std::vector<Point>& targets,
+                       std::vector<double>& table,
+                       std::vector<std::vector<Point>>* paths = nullptr);
+
+        // Gives every thread its own cache (see SearchInstance).
+        void enable_cache(size_t capacity, double tolerance = 0)
+        {
+            for (Instance* si : instances)
+            {
+                si->enable_cache(capacity, tolerance);
+            }
+        }
+
+        // Makes every thread's searches weighted (see SearchInstance).
+        void set_weight(double w)
+        {
+            for (Instance* si : instances)
+            {
+                si->set_weight(w);
+            }
+        }
+
+        // The stats of every thread added up (see SearchInstance).
+        SearchStats get_stats() const
+        {
+            SearchStats out;
+            for (const Instance* si : instances)
+            {
+                out.merge(si->get_stats());
+            }
+            return out;
+        }
+
+        // Wallclock time of the last call to run() or run_table().
+        double get_batch_micro()
+        {
+            return timer.elapsed_time_micro();
+        }
+
+        int num_threads() const
+        {
+            return (int) instances.size();
+        }
+};
+
+typedef QueryServiceBase<> QueryService;
+
+}
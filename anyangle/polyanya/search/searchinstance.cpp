@@ -7,18 +7,20 @@
 #include "mesh.h"
 #include "point.h"
 #include "consts.h"
-#include <queue>
 #include <vector>
 #include <cassert>
 #include <iostream>
 #include <algorithm>
+#include <limits>
 #include <ctime>
 
 namespace polyanya
 {
 
-PointLocation SearchInstance::get_point_location(Point p)
+template<typename OpenList>
+PointLocation SearchInstanceBase<OpenList>::get_point_location(Point p)
 {
+    STATS_SCOPE(stats, POINT_LOCATION);
     assert(mesh != nullptr);
     PointLocation out = mesh->get_point_location(p);
     if (out.type == PointLocation::ON_CORNER_VERTEX_AMBIG)
@@ -74,17 +76,25 @@ PointLocation SearchInstance::get_point_location(Point p)
     return out;
 }
 
-int SearchInstance::succ_to_node(
+template<typename OpenList>
+template<bool Triangles>
+int SearchInstanceBase<OpenList>::succ_to_node(
     SearchNodePtr parent, Successor* successors, int num_succ,
     SearchNode* nodes
 )
 {
     assert(mesh != nullptr);
-    const Polygon& polygon = mesh->mesh_polygons[parent->next_polygon];
-    const std::vector<int>& V = polygon.vertices;
-    const std::vector<int>& P = polygon.polygons;
+    const PolygonArrays& polygons = mesh->mesh_polygons;
+    const int first = polygons.offsets[parent->next_polygon];
+    const int* V = polygons.vertices + first;
+    const int* P = polygons.neighbours + first;
+    const int N = Triangles ? 3 : polygons.num_sides(parent->next_polygon);
 
     double right_g = -1, left_g = -1;
+    // Read once for all the successors, as reading a compact mesh decodes.
+    const Point parent_root = (parent->root == -1 ?
+                               start :
+                               mesh->mesh_vertices.points[parent->root]);
 
     int out = 0;
     for (int i = 0; i < num_succ; i++)
@@ -98,15 +108,15 @@ int SearchInstance::succ_to_node(
 
         // If the successor we're about to push pushes into a one-way polygon,
         // and the polygon isn't the end polygon, just continue.
-        if (mesh->mesh_polygons[next_polygon].is_one_way &&
-            next_polygon != end_polygon)
+        if ((polygons.flags[next_polygon] & POLYGON_ONE_WAY) &&
+            next_polygon != end_polygon && !is_target_polygon(next_polygon))
         {
             continue;
         }
         const int left_vertex  = V[succ.poly_left_ind];
         const int right_vertex = succ.poly_left_ind ?
                                  V[succ.poly_left_ind - 1] :
-                                 V.back();
+                                 V[N - 1];
 
         // Note that g is evaluated twice here. (But this is a lambda!)
         // Always try to precompute before using this macro.
@@ -140,12 +150,9 @@ int SearchInstance::succ_to_node(
                 }
             }
             nodes[out++] = {nullptr, root, succ.left, succ.right, left_vertex,
-                right_vertex, next_polygon, g, g};
+                right_vertex, parent->next_polygon, next_polygon, g, g};
         };
 
-        const Point& parent_root = (parent->root == -1 ?
-                                    start :
-                                    mesh->mesh_vertices[parent->root].p);
         #define get_g(new_root) parent->g + parent_root.distance(new_root)
 
         switch (succ.type)
@@ -181,24 +188,74 @@ int SearchInstance::succ_to_node(
     return out;
 }
 
-void SearchInstance::set_end_polygon()
+template<typename OpenList>
+void SearchInstanceBase<OpenList>::set_end_polygon()
 {
+    if (many_targets)
+    {
+        end_polygon = -1;
+        set_target_polygons();
+        return;
+    }
     // Any polygon is fine.
     end_polygon = get_point_location(goal).poly1;
 }
 
-void SearchInstance::gen_initial_nodes()
+template<typename OpenList>
+void SearchInstanceBase<OpenList>::set_target_polygons()
+{
+    const int num_targets = (int) targets.size();
+    target_polygons.resize(num_targets);
+    target_order.resize(num_targets);
+    target_costs.assign(num_targets, -1);
+    target_final_nodes.assign(num_targets, nullptr);
+    polygon_target_ids.resize(mesh->mesh_polygons.size());
+    polygon_first_target.resize(mesh->mesh_polygons.size());
+    num_targets_reached = 0;
+    num_targets_on_mesh = 0;
+
+    for (int i = 0; i < num_targets; i++)
+    {
+        // Any polygon is fine, as for a single goal.
+        target_polygons[i] = get_point_location(targets[i]).poly1;
+        target_order[i] = i;
+    }
+    std::sort(target_order.begin(), target_order.end(),
+              [&](int a, int b)
+              {
+                  return target_polygons[a] < target_polygons[b];
+              });
+    for (int i = 0; i < num_targets; i++)
+    {
+        const int poly = target_polygons[target_order[i]];
+        if (poly == -1)
+        {
+            continue;
+        }
+        num_targets_on_mesh++;
+        if (polygon_target_ids[poly] != search_id)
+        {
+            polygon_target_ids[poly] = search_id;
+            polygon_first_target[poly] = i;
+        }
+    }
+}
+
+template<typename OpenList>
+void SearchInstanceBase<OpenList>::gen_initial_nodes()
 {
     // {parent, root, left, right, next_polygon, right_vertex, f, g}
     // be VERY lazy and abuse how our function expands collinear search nodes
     // if right_vertex is not valid, it will generate EVERYTHING
     // and we can set right_vertex if we want to omit generating an interval.
+    STATS_SCOPE(stats, INITIAL_NODES);
     const PointLocation pl = get_point_location(start);
     const double h = start.distance(goal);
     #define get_lazy(next, left, right) new (node_pool->allocate()) SearchNode \
-        {nullptr, -1, start, start, left, right, next, h, 0}
+        {nullptr, -1, start, start, left, right, next, next, h, 0}
 
     #define v(vertex) mesh->mesh_vertices[vertex]
+    #define vertex_point(vertex) mesh->mesh_vertices.points[vertex]
 
     const auto push_lazy = [&](SearchNodePtr lazy)
     {
@@ -207,6 +264,12 @@ void SearchInstance::gen_initial_nodes()
         {
             return;
         }
+        if (is_target_polygon(poly))
+        {
+            // Targets in here can be seen from start, but others may be
+            // further on, so keep going.
+            reach_targets(lazy);
+        }
         if (poly == end_polygon)
         {
             // Trivial case - we can see the goal from start!
@@ -221,9 +284,10 @@ void SearchInstance::gen_initial_nodes()
             return;
         }
         // iterate over poly, throwing away vertices if needed
-        const std::vector<int>& vertices =
-            mesh->mesh_polygons[poly].vertices;
-        Successor* successors = new Successor [vertices.size()];
+        // The main loop hasn't started yet, so its scratch buffers are free.
+        const IndexRange vertices = mesh->mesh_polygons[poly].vertices;
+        assert((int) vertices.size() <= mesh->max_poly_sides);
+        Successor* successors = search_successors;
         int last_vertex = vertices.back();
         int num_succ = 0;
         for (int i = 0; i < (int) vertices.size(); i++)
@@ -236,21 +300,29 @@ void SearchInstance::gen_initial_nodes()
                 continue;
             }
             successors[num_succ++] =
-                {Successor::OBSERVABLE, v(vertex).p,
-                 v(last_vertex).p, i};
+                {Successor::OBSERVABLE, vertex_point(vertex),
+                 vertex_point(last_vertex), i};
             last_vertex = vertex;
         }
-        SearchNode* nodes = new SearchNode [num_succ];
-        const int num_nodes = succ_to_node(lazy, successors,
-                                           num_succ, nodes);
-        delete[] successors;
+        SearchNode* nodes = search_nodes_to_push;
+        int num_nodes;
+        {
+            STATS_SCOPE(stats, NODES);
+            num_nodes = succ_to_node(lazy, successors, num_succ, nodes);
+        }
         for (int i = 0; i < num_nodes; i++)
         {
             SearchNodePtr n = new (node_pool->allocate())
                 SearchNode(nodes[i]);
             const Point& n_root = (n->root == -1 ? start :
-                                   mesh->mesh_vertices[n->root].p);
-            n->f += get_h_value(n_root, goal, n->left, n->right);
+                                   vertex_point(n->root));
+            {
+                STATS_SCOPE(stats, H_VALUE);
+                n->f += many_targets ?
+                    get_interval_h_value(n_root, n->left, n->right) :
+                    heuristic_weight * get_h_value(n_root, goal, n->left,
+                                                   n->right);
+            }
             n->parent = lazy;
             #ifndef NDEBUG
             if (verbose)
@@ -260,9 +332,9 @@ void SearchInstance::gen_initial_nodes()
                 std::cerr << std::endl;
             }
             #endif
+            STATS_SCOPE(stats, OPEN_LIST);
             open_list.push(n);
         }
-        delete[] nodes;
         nodes_generated += num_nodes;
         nodes_pushed += num_nodes;
     };
@@ -310,7 +382,7 @@ void SearchInstance::gen_initial_nodes()
 
         case PointLocation::ON_NON_CORNER_VERTEX:
         {
-            for (int& poly : v(pl.vertex1).polygons)
+            for (int poly : v(pl.vertex1).polygons)
             {
                 SearchNodePtr lazy = get_lazy(poly, pl.vertex1, pl.vertex1);
                 push_lazy(lazy);
@@ -329,31 +401,290 @@ void SearchInstance::gen_initial_nodes()
             break;
     }
 
+    #undef vertex_point
     #undef v
     #undef get_lazy
 }
 
-#define root_to_point(root) ((root) == -1 ? start : mesh->mesh_vertices[root].p)
+#define root_to_point(root) ((root) == -1 ? start : \
+                             mesh->mesh_vertices.points[root])
+
+template<typename OpenList>
+SearchNodePtr SearchInstanceBase<OpenList>::make_final_node(
+    SearchNodePtr node, Point end, double cost
+)
+{
+    // We need to find whether we need to turn left/right to ge
+    // to the goal, so we do an orientation check like how we
+    // special case triangle successors.
+
+    const int final_root = [&]()
+    {
+        const Point& root = root_to_point(node->root);
+        const Point root_goal = end - root;
+        // If root-left-goal is not CW, use left.
+        if (root_goal * (node->left - root) < -EPSILON)
+        {
+            return node->left_vertex;
+        }
+        // If root-right-goal is not CCW, use right.
+        if ((node->right - root) * root_goal < -EPSILON)
+        {
+            return node->right_vertex;
+        }
+        // Use the normal root.
+        return node->root;
+    }();
+
+    return new (node_pool->allocate()) SearchNode
+        {node, final_root, end, end, -1, -1, node->next_polygon,
+         node->next_polygon, cost, node->g};
+}
+
+template<typename OpenList>
+void SearchInstanceBase<OpenList>::reach_targets(SearchNodePtr node)
+{
+    const int poly = node->next_polygon;
+    const Point& root = root_to_point(node->root);
+    const int num_targets = (int) targets.size();
+    for (int i = polygon_first_target[poly];
+         i < num_targets && target_polygons[target_order[i]] == poly; i++)
+    {
+        const int target = target_order[i];
+        const double cost = node->g + get_h_value(root, targets[target],
+                                                  node->left, node->right);
+        if (target_costs[target] == -1)
+        {
+            num_targets_reached++;
+        }
+        else if (target_costs[target] <= cost)
+        {
+            continue;
+        }
+        target_costs[target] = cost;
+        target_final_nodes[target] = make_final_node(node, targets[target],
+                                                     cost);
+        nodes_generated++;
+    }
+}
 
-bool SearchInstance::search()
+template<typename OpenList>
+bool SearchInstanceBase<OpenList>::search()
 {
     timer.start();
+    STATS_DO(stats.searches++);
+    STATS_SCOPE(stats, OTHER);
+    many_targets = false;
+    cache_hit = false;
+    bool found;
+    // Cached costs are assumed to be optimal, so a weighted search can
+    // neither use nor fill the cache.
+    const bool use_cache = cache && heuristic_weight == 1;
+    if (use_cache && lookup_cache())
+    {
+        cache_hit = true;
+        found = final_node != nullptr;
+    }
+    else
+    {
+        found = run_search();
+        if (use_cache)
+        {
+            store_in_cache();
+        }
+    }
+    timer.stop();
+
+    if (use_cache)
+    {
+        if (cache_hit)
+        {
+            cache->hits++;
+            cache->hit_micro += timer.elapsed_time_micro();
+        }
+        else
+        {
+            cache->misses++;
+            cache->miss_micro += timer.elapsed_time_micro();
+        }
+    }
+    return found;
+}
+
+template<typename OpenList>
+bool SearchInstanceBase<OpenList>::lookup_cache()
+{
+    // Only points within (or on the edge of) a polygon are cached. Points
+    // on vertices can be in several polygons, so leave them to the search.
+    const auto cacheable_polygon = [&](const Point& p)
+    {
+        const PointLocation loc = get_point_location(p);
+        switch (loc.type)
+        {
+            case PointLocation::IN_POLYGON:
+            case PointLocation::ON_MESH_BORDER:
+            case PointLocation::ON_EDGE:
+                return loc.poly1;
+
+            default:
+                return -1;
+        }
+    };
+    if (cache_mesh_version != mesh->get_version())
+    {
+        cache->clear();
+        cache_mesh_version = mesh->get_version();
+    }
+    cache_start_polygon = cacheable_polygon(start);
+    cache_goal_polygon = cacheable_polygon(goal);
+    if (cache_start_polygon == -1 || cache_goal_polygon == -1)
+    {
+        return false;
+    }
+    const PathCache::Entry* entry = cache->find(cache_start_polygon,
+                                                cache_goal_polygon);
+    if (entry == nullptr)
+    {
+        return false;
+    }
+
+    // Polygons which were disconnected still are, whatever the points.
+    double cost = -1;
+    if (entry->cost != -1)
+    {
+        // Reconnect the new start and goal to the ends of the cached path.
+        if (entry->turns.empty())
+        {
+            if (!mesh->is_visible(cache_start_polygon, start, goal))
+            {
+                return false;
+            }
+            cost = start.distance(goal);
+        }
+        else
+        {
+            const Point& first = mesh->mesh_vertices.points[entry->turns[0]];
+            const Point& last =
+                mesh->mesh_vertices.points[entry->turns.back()];
+            if (!mesh->is_visible(cache_start_polygon, start, first) ||
+                !mesh->is_visible(cache_goal_polygon, goal, last))
+            {
+                return false;
+            }
+            cost = entry->cost - entry->start.distance(first) -
+                   entry->goal.distance(last) + start.distance(first) +
+                   goal.distance(last);
+        }
+        // The cached cost was optimal, and moving the endpoints within
+        // their polygons changes the optimal cost by at most the distance
+        // they moved.
+        const double lower_bound = std::max(
+            start.distance(goal),
+            entry->cost - start.distance(entry->start) -
+                goal.distance(entry->goal)
+        );
+        if (cost > lower_bound + cache_tolerance + EPSILON)
+        {
+            return false;
+        }
+    }
+
+    // Hit: rebuild the path as a chain of nodes so the usual getters work.
+    node_pool->reclaim();
+    pool_chunks_at_start = node_pool->num_chunks();
+    open_capacity_at_start = open_list.capacity();
+    final_node = nullptr;
+    nodes_generated = 0;
+    nodes_pushed = 0;
+    nodes_popped = 0;
+    nodes_pruned_post_pop = 0;
+    successor_calls = 0;
+    if (cost == -1)
+    {
+        return true;
+    }
+    SearchNodePtr node = new (node_pool->allocate()) SearchNode
+        {nullptr, -1, start, start, -1, -1, cache_start_polygon,
+         cache_start_polygon, 0, 0};
+    for (int vertex : entry->turns)
+    {
+        const Point& p = mesh->mesh_vertices.points[vertex];
+        node = new (node_pool->allocate()) SearchNode
+            {node, vertex, p, p, -1, -1, -1, -1, 0, 0};
+    }
+    node->f = cost;
+    final_node = node;
+    return true;
+}
+
+template<typename OpenList>
+void SearchInstanceBase<OpenList>::store_in_cache()
+{
+    if (cache_start_polygon == -1 || cache_goal_polygon == -1)
+    {
+        return;
+    }
+    PathCache::Entry& entry = cache->insert(cache_start_polygon,
+                                            cache_goal_polygon);
+    entry.start = start;
+    entry.goal = goal;
+    entry.cost = get_cost();
+    entry.turns.clear();
+    for (SearchNodePtr n = final_node; n != nullptr; n = n->parent)
+    {
+        if (n->root != -1 &&
+            (entry.turns.empty() || entry.turns.back() != n->root))
+        {
+            entry.turns.push_back(n->root);
+        }
+    }
+    std::reverse(entry.turns.begin(), entry.turns.end());
+}
+
+template<typename OpenList>
+bool SearchInstanceBase<OpenList>::run_search()
+{
     init_search();
     if (mesh == nullptr || end_polygon == -1)
     {
-        timer.stop();
         return false;
     }
 
     if (final_node != nullptr)
     {
-        timer.stop();
         return true;
     }
 
+    // Triangle meshes (such as the CDTs from poly2mesh) get a copy of the
+    // search loop which only has the triangle code for expanding nodes.
+    if (mesh->max_poly_sides == 3)
+    {
+        return expand_until_goal<true>();
+    }
+    return expand_until_goal<false>();
+}
+
+template<typename OpenList>
+template<bool Triangles>
+bool SearchInstanceBase<OpenList>::expand_until_goal()
+{
     while (!open_list.empty())
     {
-        SearchNodePtr node = open_list.top(); open_list.pop();
+        if (time_limit_micro > 0 && (nodes_popped & 255) == 0)
+        {
+            timer.stop();
+            if (timer.elapsed_time_micro() > time_limit_micro)
+            {
+                timed_out = true;
+                return false;
+            }
+        }
+        SearchNodePtr node;
+        {
+            STATS_DO(stats.open_list_size.add(open_list.size()));
+            STATS_SCOPE(stats, OPEN_LIST);
+            node = open_list.top(); open_list.pop();
+        }
 
         #ifndef NDEBUG
         if (verbose)
@@ -372,37 +703,16 @@ bool SearchInstance::search()
             // (We usually push it onto the open list, but we know it's going
             // to be immediately popped off anyway.)
 
-            // We need to find whether we need to turn left/right to ge
-            // to the goal, so we do an orientation check like how we
-            // special case triangle successors.
-
-            const int final_root = [&]()
-            {
-                const Point& root = root_to_point(node->root);
-                const Point root_goal = goal - root;
-                // If root-left-goal is not CW, use left.
-                if (root_goal * (node->left - root) < -EPSILON)
-                {
-                    return node->left_vertex;
-                }
-                // If root-right-goal is not CCW, use right.
-                if ((node->right - root) * root_goal < -EPSILON)
-                {
-                    return node->right_vertex;
-                }
-                // Use the normal root.
-                return node->root;
-            }();
-
+            // With a weighted heuristic f is not the cost, but h is exact
+            // now that the goal can be seen.
+            const double cost = heuristic_weight == 1 ? node->f :
+                node->g + get_h_value(root_to_point(node->root), goal,
+                                      node->left, node->right);
             const SearchNodePtr true_final =
-                new (node_pool->allocate()) SearchNode
-                {node, final_root, goal, goal, -1, -1, end_polygon,
-                 node->f, node->g};
+                make_final_node(node, goal, cost);
 
             nodes_generated++;
 
-            timer.stop();
-
             #ifndef NDEBUG
             if (verbose)
             {
@@ -451,11 +761,20 @@ bool SearchInstance::search()
             {
                 break;
             }
-            int num_succ = get_successors(cur_node, start, *mesh,
-                                          search_successors);
+            int num_succ;
+            {
+                STATS_SCOPE(stats, SUCCESSORS);
+                num_succ = get_successors<Triangles>(cur_node, start, *mesh,
+                                                     search_successors);
+            }
+            STATS_DO(stats.successors.add(num_succ));
             successor_calls++;
-            num_nodes = succ_to_node(&cur_node, search_successors,
-                                     num_succ, search_nodes_to_push);
+            {
+                STATS_SCOPE(stats, NODES);
+                num_nodes = succ_to_node<Triangles>(
+                    &cur_node, search_successors, num_succ,
+                    search_nodes_to_push);
+            }
             if (num_nodes == 1)
             {
                 // Did we turn?
@@ -507,9 +826,19 @@ bool SearchInstance::search()
                 n = new (node_pool->allocate()) SearchNode(cur_node);
                 n->parent = node;
             }
-            const Point& n_root = (n->root == -1 ? start :
-                                   mesh->mesh_vertices[n->root].p);
-            n->f += get_h_value(n_root, goal, n->left, n->right);
+            const Point& n_root = root_to_point(n->root);
+            double h;
+            {
+                STATS_SCOPE(stats, H_VALUE);
+                h = get_h_value(n_root, goal, n->left, n->right);
+            }
+            if (n->g + h >= upper_bound)
+            {
+                // Can't beat the best path found so far.
+                nodes_pushed--;
+                continue;
+            }
+            n->f += heuristic_weight * h;
 
             #ifndef NDEBUG
             if (verbose)
@@ -520,17 +849,256 @@ bool SearchInstance::search()
             }
             #endif
 
+            STATS_SCOPE(stats, OPEN_LIST);
             open_list.push(n);
         }
         nodes_generated += num_nodes;
         nodes_pushed += num_nodes;
     }
 
-    timer.stop();
     return false;
 }
 
-void SearchInstance::print_node(SearchNodePtr node, std::ostream& outfile)
+template<typename OpenList>
+bool SearchInstanceBase<OpenList>::search_many()
+{
+    // This is search() without a goal: nodes are ordered by a lower bound
+    // on the cost to anything past them, and every node which reaches a
+    // target's polygon offers that target a path. A target's cost is final
+    // once the open list has nothing cheaper left.
+    timer.start();
+    STATS_DO(stats.searches++);
+    STATS_SCOPE(stats, OTHER);
+    many_targets = true;
+    init_search();
+    if (mesh == nullptr)
+    {
+        timer.stop();
+        return false;
+    }
+
+    // The largest target cost, which only ever shrinks. This is only
+    // refreshed when the search looks like it could be done.
+    double max_cost = std::numeric_limits<double>::infinity();
+    while (!open_list.empty())
+    {
+        SearchNodePtr node = open_list.top();
+        if (num_targets_reached == num_targets_on_mesh && node->f >= max_cost)
+        {
+            max_cost = *std::max_element(target_costs.begin(),
+                                         target_costs.end());
+            if (node->f >= max_cost)
+            {
+                break;
+            }
+        }
+        {
+            STATS_DO(stats.open_list_size.add(open_list.size()));
+            STATS_SCOPE(stats, OPEN_LIST);
+            open_list.pop();
+        }
+
+        #ifndef NDEBUG
+        if (verbose)
+        {
+            std::cerr << "popped off: ";
+            print_node(node, std::cerr);
+            std::cerr << std::endl;
+        }
+        #endif
+
+        nodes_popped++;
+        // We will never update our root list here.
+        const int root = node->root;
+        if (root != -1)
+        {
+            assert(root >= 0 && root < (int) root_g_values.size());
+            if (root_search_ids[root] == search_id)
+            {
+                if (root_g_values[root] + EPSILON < node->g)
+                {
+                    nodes_pruned_post_pop++;
+                    continue;
+                }
+            }
+        }
+        if (is_target_polygon(node->next_polygon))
+        {
+            reach_targets(node);
+        }
+
+        int num_nodes = 1;
+        search_nodes_to_push[0] = *node;
+        bool first = true;
+        do
+        {
+            SearchNode cur_node = search_nodes_to_push[0];
+            // Stop at target polygons so the node gets pushed (and offers
+            // its targets a path when popped), unless it was just popped.
+            if (!first && is_target_polygon(cur_node.next_polygon))
+            {
+                break;
+            }
+            first = false;
+            int num_succ;
+            {
+                STATS_SCOPE(stats, SUCCESSORS);
+                num_succ = get_successors(cur_node, start, *mesh,
+                                          search_successors);
+            }
+            STATS_DO(stats.successors.add(num_succ));
+            successor_calls++;
+            {
+                STATS_SCOPE(stats, NODES);
+                num_nodes = succ_to_node(&cur_node, search_successors,
+                                         num_succ, search_nodes_to_push);
+            }
+            if (num_nodes == 1)
+            {
+                // Did we turn?
+                if (cur_node.g != search_nodes_to_push[0].g)
+                {
+                    search_nodes_to_push[0].parent = node;
+                    node = new (node_pool->allocate())
+                        SearchNode(search_nodes_to_push[0]);
+                    nodes_generated++;
+                }
+            }
+        }
+        while (num_nodes == 1);
+
+        for (int i = 0; i < num_nodes; i++)
+        {
+            const SearchNode &cur_node = search_nodes_to_push[i];
+            // As in search(): a parent pointer means cur_node is node.
+            SearchNodePtr n = nullptr;
+            if (cur_node.parent)
+            {
+                n = node;
+                nodes_generated--;
+            }
+            else
+            {
+                n = new (node_pool->allocate()) SearchNode(cur_node);
+                n->parent = node;
+            }
+            const Point& n_root = root_to_point(n->root);
+            {
+                STATS_SCOPE(stats, H_VALUE);
+                n->f += get_interval_h_value(n_root, n->left, n->right);
+            }
+
+            #ifndef NDEBUG
+            if (verbose)
+            {
+                std::cerr << "\tpushing: ";
+                print_node(n, std::cerr);
+                std::cerr << std::endl;
+            }
+            #endif
+
+            STATS_SCOPE(stats, OPEN_LIST);
+            open_list.push(n);
+        }
+        nodes_generated += num_nodes;
+        nodes_pushed += num_nodes;
+    }
+
+    timer.stop();
+    return num_targets_reached == num_targets_on_mesh;
+}
+
+template<typename OpenList>
+bool SearchInstanceBase<OpenList>::search_anytime(
+    const std::vector<double>& weights, double time_limit
+)
+{
+    // Polyanya has no closed list for ARA*-style repairs to work from, so
+    // each iteration is a fresh search, pruned by the best path so far.
+    timer.start();
+    STATS_DO(stats.searches++);
+    STATS_SCOPE(stats, OTHER);
+    many_targets = false;
+    cache_hit = false;
+    anytime_solutions.clear();
+    timed_out = false;
+    time_limit_micro = time_limit;
+    keep_nodes = true;
+    node_pool->reclaim();
+    const double original_weight = heuristic_weight;
+
+    SearchNodePtr best = nullptr;
+    double bound = std::numeric_limits<double>::infinity();
+    int total_generated = 0, total_pushed = 0, total_popped = 0,
+        total_pruned_post_pop = 0, total_successor_calls = 0;
+    for (const double w : weights)
+    {
+        assert(w >= 1);
+        heuristic_weight = w;
+        upper_bound = best ? best->f :
+                      std::numeric_limits<double>::infinity();
+        const bool found = run_search();
+        total_generated += nodes_generated;
+        total_pushed += nodes_pushed;
+        total_popped += nodes_popped;
+        total_pruned_post_pop += nodes_pruned_post_pop;
+        total_successor_calls += successor_calls;
+        if (timed_out)
+        {
+            break;
+        }
+
+        double new_bound = bound;
+        if (found && (best == nullptr || final_node->f < best->f))
+        {
+            // A weighted search finds a path within w of the optimal, or
+            // else the optimal path was pruned, so best was optimal.
+            best = final_node;
+            new_bound = std::min(bound, w);
+        }
+        else if (best != nullptr)
+        {
+            // Nothing cheaper survived the pruning, so best is optimal.
+            // (Finding an equal path only happens in the trivial case.)
+            new_bound = 1;
+        }
+        else
+        {
+            // No path at all.
+            break;
+        }
+        if (best != nullptr && new_bound < bound)
+        {
+            bound = new_bound;
+            timer.stop();
+            anytime_solutions.push_back({best->f, bound,
+                                         timer.elapsed_time_micro(),
+                                         total_popped});
+        }
+        if (bound <= 1)
+        {
+            break;
+        }
+    }
+
+    heuristic_weight = original_weight;
+    upper_bound = std::numeric_limits<double>::infinity();
+    keep_nodes = false;
+    time_limit_micro = 0;
+    final_node = best;
+    nodes_generated = total_generated;
+    nodes_pushed = total_pushed;
+    nodes_popped = total_popped;
+    nodes_pruned_post_pop = total_pruned_post_pop;
+    successor_calls = total_successor_calls;
+    timer.stop();
+    return best != nullptr;
+}
+
+template<typename OpenList>
+void SearchInstanceBase<OpenList>::print_node(
+    SearchNodePtr node, std::ostream& outfile
+)
 {
     outfile << "root=" << root_to_point(node->root) << "; left=" << node->left
             << "; right=" << node->right << "; f=" << node->f << ", g="
@@ -555,15 +1123,19 @@ void SearchInstance::print_node(SearchNodePtr node, std::ostream& outfile)
     */
 }
 
-void SearchInstance::get_path_points(std::vector<Point>& out)
+template<typename OpenList>
+void SearchInstanceBase<OpenList>::get_path_points(
+    SearchNodePtr end_node, Point end, std::vector<Point>& out
+)
 {
-    if (final_node == nullptr)
+    if (end_node == nullptr)
     {
         return;
     }
+    STATS_SCOPE(stats, PATH);
     out.clear();
-    out.push_back(goal);
-    SearchNodePtr cur_node = final_node;
+    out.push_back(end);
+    SearchNodePtr cur_node = end_node;
 
     while (cur_node != nullptr)
     {
@@ -576,7 +1148,8 @@ void SearchInstance::get_path_points(std::vector<Point>& out)
     std::reverse(out.begin(), out.end());
 }
 
-void SearchInstance::print_search_nodes(std::ostream& outfile)
+template<typename OpenList>
+void SearchInstanceBase<OpenList>::print_search_nodes(std::ostream& outfile)
 {
     if (final_node == nullptr)
     {
@@ -595,4 +1168,8 @@ void SearchInstance::print_search_nodes(std::ostream& outfile)
 
 #undef root_to_point
 
+template class SearchInstanceBase<BinaryHeapOpenList>;
+template class SearchInstanceBase<QuaternaryHeapOpenList>;
+template class SearchInstanceBase<PairingHeapOpenList>;
+
 }
@@ -1,33 +1,37 @@
 #pragma once
 #include "searchnode.h"
+#include "openlist.h"
+#include "pathcache.h"
 #include "successor.h"
 #include "mesh.h"
 #include "point.h"
 #include "cpool.h"
 #include "timer.h"
-#include <queue>
+#include "searchstats.h"
 #include <vector>
+#include <memory>
+#include <limits>
 #include <ctime>
 
 namespace polyanya
 {
 
-template<typename T, typename Compare = std::greater<T> >
-struct PointerComp
+typedef Mesh* MeshPtr;
+
+// An improvement reported by SearchInstance::search_anytime().
+struct AnytimeSolution
 {
-    bool operator()(const T* x,
-                    const T* y) const
-    {
-        return Compare()(*x, *y);
-    }
+    double cost;
+    double bound;     // the cost is at most this many times the optimal
+    double micro;     // time since the search started
+    int nodes_popped; // in total since the search started
 };
 
-typedef Mesh* MeshPtr;
-
-class SearchInstance
+// OpenList is one of the open lists in openlist.h. SearchInstanceBase is
+// explicitly instantiated for each of them in searchinstance.cpp.
+template<typename OpenList = BinaryHeapOpenList>
+class SearchInstanceBase
 {
-    typedef std::priority_queue<SearchNodePtr, std::vector<SearchNodePtr>,
-                                PointerComp<SearchNode> > pq;
     private:
         warthog::mem::cpool* node_pool;
         MeshPtr mesh;
@@ -35,7 +39,7 @@ class SearchInstance
 
         SearchNodePtr final_node;
         int end_polygon; // set by init_search
-        pq open_list;
+        OpenList open_list;
 
         // Best g value for a specific vertex.
         std::vector<double> root_g_values;
@@ -45,6 +49,47 @@ class SearchInstance
         int search_id;
 
         warthog::timer timer;
+        #ifdef POLYANYA_STATS
+        SearchStats stats; // see searchstats.h
+        #endif
+
+        // Sizes of the node pool and open list when the search started.
+        size_t pool_chunks_at_start;
+        size_t open_capacity_at_start;
+
+        // State for search_many(), which has no single goal.
+        // Targets are grouped by the polygon they lie in: if
+        // polygon_target_ids[p] is the current search id, the targets in p
+        // are target_order[polygon_first_target[p]] onwards.
+        bool many_targets;
+        std::vector<Point> targets;
+        std::vector<int> target_polygons;
+        std::vector<int> target_order;
+        std::vector<int> polygon_target_ids;
+        std::vector<int> polygon_first_target;
+        std::vector<double> target_costs;
+        std::vector<SearchNodePtr> target_final_nodes;
+        int num_targets_on_mesh;
+        int num_targets_reached;
+
+        // Optional cache of earlier results, see enable_cache().
+        std::unique_ptr<PathCache> cache;
+        double cache_tolerance;
+        int cache_mesh_version; // entries are dropped when the mesh changes
+        // Polygons of the current start and goal, or -1 if the query can't
+        // be cached.
+        int cache_start_polygon, cache_goal_polygon;
+
+        // Bounded suboptimal and anytime search.
+        double heuristic_weight; // see set_weight()
+        // Nodes which cannot lead to a path cheaper than this aren't pushed.
+        double upper_bound;
+        // search_anytime() keeps the nodes of earlier iterations, as its
+        // best path may come from any of them.
+        bool keep_nodes;
+        double time_limit_micro; // 0 for none
+        bool timed_out;
+        std::vector<AnytimeSolution> anytime_solutions;
 
         // Pre-initialised variables to use in search().
         Successor* search_successors;
@@ -53,6 +98,14 @@ class SearchInstance
         void init()
         {
             verbose = false;
+            many_targets = false;
+            cache_hit = false;
+            cache_tolerance = 0;
+            heuristic_weight = 1;
+            upper_bound = std::numeric_limits<double>::infinity();
+            keep_nodes = false;
+            time_limit_micro = 0;
+            timed_out = false;
             search_successors = new Successor [mesh->max_poly_sides + 2];
             search_nodes_to_push = new SearchNode [mesh->max_poly_sides + 2];
             node_pool = new warthog::mem::cpool(sizeof(SearchNode));
@@ -69,9 +122,14 @@ class SearchInstance
         void init_search()
         {
             assert(node_pool);
-            node_pool->reclaim();
+            if (!keep_nodes)
+            {
+                node_pool->reclaim();
+            }
             search_id++;
-            open_list = pq();
+            open_list.clear();
+            pool_chunks_at_start = node_pool->num_chunks();
+            open_capacity_at_start = open_list.capacity();
             final_node = nullptr;
             nodes_generated = 0;
             nodes_pushed = 0;
@@ -83,11 +141,29 @@ class SearchInstance
         }
         PointLocation get_point_location(Point p);
         void set_end_polygon();
+        void set_target_polygons();
+        bool is_target_polygon(int polygon)
+        {
+            return many_targets && polygon_target_ids[polygon] == search_id;
+        }
         void gen_initial_nodes();
+        bool run_search();
+        // The main loop of run_search(). Triangles is whether every
+        // polygon of the mesh is a triangle.
+        template<bool Triangles>
+        bool expand_until_goal();
+        bool lookup_cache();
+        void store_in_cache();
+        template<bool Triangles = false>
         int succ_to_node(
             SearchNodePtr parent, Successor* successors,
             int num_succ, SearchNode* nodes
         );
+        SearchNodePtr make_final_node(SearchNodePtr node, Point end,
+                                      double cost);
+        void reach_targets(SearchNodePtr node);
+        void get_path_points(SearchNodePtr end_node, Point end,
+                             std::vector<Point>& out);
         void print_node(SearchNodePtr node, std::ostream& outfile);
 
     public:
@@ -96,15 +172,16 @@ class SearchInstance
         int nodes_popped;           // Nodes popped off open
         int nodes_pruned_post_pop;  // Nodes we prune right after popping off
         int successor_calls;        // Times we call get_successors
+        bool cache_hit;             // Whether the cache answered the search
         bool verbose;
 
-        SearchInstance() { }
-        SearchInstance(MeshPtr m) : mesh(m) { init(); }
-        SearchInstance(MeshPtr m, Point s, Point g) :
+        SearchInstanceBase() { }
+        SearchInstanceBase(MeshPtr m) : mesh(m) { init(); }
+        SearchInstanceBase(MeshPtr m, Point s, Point g) :
             mesh(m), start(s), goal(g) { init(); }
-        SearchInstance(SearchInstance const &) = delete;
-        void operator=(SearchInstance const &x) = delete;
-        ~SearchInstance()
+        SearchInstanceBase(SearchInstanceBase const &) = delete;
+        void operator=(SearchInstanceBase const &x) = delete;
+        ~SearchInstanceBase()
         {
             if (node_pool)
             {
@@ -122,6 +199,71 @@ class SearchInstance
         }
 
         bool search();
+
+        // Makes search() order nodes by g + w * h, so that it finds a path
+        // costing at most w times the optimal with fewer expansions.
+        // A weight of 1 (the default) is the usual optimal search.
+        void set_weight(double w)
+        {
+            assert(w >= 1);
+            heuristic_weight = w;
+        }
+        double get_weight() const
+        {
+            return heuristic_weight;
+        }
+
+        // Anytime search: searches with each weight in turn (they should
+        // decrease, ending with 1), each time only keeping nodes which could
+        // lead to a cheaper path than the best so far. Every improvement to
+        // the best path or to the bound on its suboptimality is recorded in
+        // get_anytime_solutions(). Stops early once the path is known to be
+        // optimal, or once time_limit (in microseconds, if positive) runs
+        // out. Afterwards get_cost() and get_path_points() give the best
+        // path, and the node counters are totals over every iteration.
+        bool search_anytime(const std::vector<double>& weights,
+                            double time_limit = 0);
+        const std::vector<AnytimeSolution>& get_anytime_solutions() const
+        {
+            return anytime_solutions;
+        }
+
+        // Makes search() keep the last capacity results, by start and goal
+        // polygon, and try to reuse them: a cached path is reused for a new
+        // start and goal if its first and last legs are still unobstructed
+        // and it provably costs at most tolerance more than the optimal
+        // path. Otherwise search() falls back to a normal search.
+        // A capacity of 0 turns the cache off.
+        void enable_cache(size_t capacity, double tolerance = 0)
+        {
+            cache.reset(capacity ? new PathCache(capacity) : nullptr);
+            cache_tolerance = tolerance;
+            cache_mesh_version = mesh->get_version();
+        }
+        PathCache* get_cache()
+        {
+            return cache.get();
+        }
+
+        // One-to-many search: finds the cost from s to every point in ts
+        // with a single search, which keeps going until no cheaper path to
+        // any of them can be found.
+        void set_start_targets(Point s, const std::vector<Point>& ts)
+        {
+            start = s;
+            targets.assign(ts.begin(), ts.end());
+        }
+        // Returns whether every target on the mesh was reached.
+        bool search_many();
+        // Cost from the start to targets[i], or -1 if it is unreachable.
+        double get_target_cost(int i)
+        {
+            return target_costs[i];
+        }
+        void get_target_path_points(int i, std::vector<Point>& out)
+        {
+            get_path_points(target_final_nodes[i], targets[i], out);
+        }
         double get_cost()
         {
             if (final_node == nullptr)
@@ -137,9 +279,38 @@ class SearchInstance
             return timer.elapsed_time_micro();
         }
 
-        void get_path_points(std::vector<Point>& out);
+        // Where the time went, summed over every search since the last
+        // reset_stats(). Always zero unless SearchStats::enabled.
+        SearchStats get_stats() const
+        {
+            #ifdef POLYANYA_STATS
+            return stats;
+            #else
+            return SearchStats();
+            #endif
+        }
+        void reset_stats()
+        {
+            STATS_DO(stats.reset());
+        }
+
+        // Times the last search had to grow the node pool or the open list.
+        // Nothing else allocates during a search, so once both have grown to
+        // fit the largest query this stays at zero.
+        int get_allocations()
+        {
+            return (int) (node_pool->num_chunks() - pool_chunks_at_start) +
+                   (open_list.capacity() != open_capacity_at_start);
+        }
+
+        void get_path_points(std::vector<Point>& out)
+        {
+            get_path_points(final_node, goal, out);
+        }
         void print_search_nodes(std::ostream& outfile);
 
 };
 
+typedef SearchInstanceBase<> SearchInstance;
+
 }
@@ -0,0 +1,138 @@
+#include "searchstats.h"
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+
+namespace polyanya
+{
+
+void SearchStats::reset()
+{
+    searches = 0;
+    std::memset(cycles, 0, sizeof(cycles));
+    std::memset(calls, 0, sizeof(calls));
+    std::memset(&successors, 0, sizeof(successors));
+    std::memset(&open_list_size, 0, sizeof(open_list_size));
+    phase = NONE;
+    last = 0;
+}
+
+static void merge_histogram(StatsHistogram& into, const StatsHistogram& h)
+{
+    for (int b = 0; b < StatsHistogram::NUM_BUCKETS; b++)
+    {
+        into.buckets[b] += h.buckets[b];
+    }
+    into.count += h.count;
+    into.sum += h.sum;
+    into.max = std::max(into.max, h.max);
+}
+
+void SearchStats::merge(const SearchStats& other)
+{
+    searches += other.searches;
+    for (int p = 0; p < NUM_PHASES; p++)
+    {
+        cycles[p] += other.cycles[p];
+        calls[p] += other.calls[p];
+    }
+    merge_histogram(successors, other.successors);
+    merge_histogram(open_list_size, other.open_list_size);
+}
+
+const char* SearchStats::phase_name(int p)
+{
+    static const char* names[NUM_PHASES] =
+    {
+        "other", "point_location", "initial_nodes", "successors", "nodes",
+        "h_value", "open_list", "path"
+    };
+    return names[p];
+}
+
+const char* SearchStats::cycle_unit()
+{
+    #if defined(__x86_64__) || defined(__i386__)
+    return "tsc";
+    #else
+    return "nano";
+    #endif
+}
+
+void SearchStats::print_csv(std::ostream& out) const
+{
+    out << "unit;searches";
+    for (int p = 0; p < NUM_PHASES; p++)
+    {
+        out << ";" << phase_name(p) << "_calls;" << phase_name(p) << "_cycles";
+    }
+    out << std::endl << cycle_unit() << ";" << searches;
+    for (int p = 0; p < NUM_PHASES; p++)
+    {
+        out << ";" << calls[p] << ";" << cycles[p];
+    }
+    out << std::endl;
+
+    // Bucket columns go as far as either histogram needs.
+    const int num_buckets = std::max(successors.num_used_buckets(),
+                                     open_list_size.num_used_buckets());
+    out << "histogram;count;mean;max";
+    for (int b = 0; b < num_buckets; b++)
+    {
+        out << ";" << StatsHistogram::bucket_min(b);
+        if (b > 1)
+        {
+            out << "-" << StatsHistogram::bucket_max(b);
+        }
+    }
+    out << std::endl;
+    const auto print_histogram = [&](const char* name,
+                                     const StatsHistogram& h)
+    {
+        out << name << ";" << h.count << ";"
+            << (h.count ? h.sum / (double) h.count : 0) << ";" << h.max;
+        for (int b = 0; b < num_buckets; b++)
+        {
+            out << ";" << h.buckets[b];
+        }
+        out << std::endl;
+    };
+    print_histogram("successors", successors);
+    print_histogram("open_list_size", open_list_size);
+}
+
+void SearchStats::print_json(std::ostream& out) const
+{
+    out << "{" << std::endl
+        << "  \"unit\": \"" << cycle_unit() << "\"," << std::endl
+        << "  \"searches\": " << searches << "," << std::endl
+        << "  \"phases\": {" << std::endl;
+    for (int p = 0; p < NUM_PHASES; p++)
+    {
+        out << "    \"" << phase_name(p) << "\": {\"calls\": " << calls[p]
+            << ", \"cycles\": " << cycles[p] << "}"
+            << (p + 1 < NUM_PHASES ? "," : "") << std::endl;
+    }
+    out << "  }," << std::endl;
+    const auto print_histogram = [&](const char* name,
+                                     const StatsHistogram& h, bool last)
+    {
+        out << "  \"" << name << "\": {\"count\": " << h.count
+            << ", \"mean\": " << (h.count ? h.sum / (double) h.count : 0)
+            << ", \"max\": " << h.max << ", \"buckets\": [";
+        const int n = h.num_used_buckets();
+        for (int b = 0; b < n; b++)
+        {
+            out << (b ? ", " : "") << "{\"min\": "
+                << StatsHistogram::bucket_min(b) << ", \"max\": "
+                << StatsHistogram::bucket_max(b) << ", \"count\": "
+                << h.buckets[b] << "}";
+        }
+        out << "]}" << (last ? "" : ",") << std::endl;
+    };
+    print_histogram("successors", successors, false);
+    print_histogram("open_list_size", open_list_size, true);
+    out << "}" << std::endl;
+}
+
+}
@@ -0,0 +1,171 @@
+#pragma once
+#include <stdint.h>
+#include <iostream>
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#else
+#include <chrono>
+#endif
+
+namespace polyanya
+{
+
+// Optional instrumentation of the search, for finding out where the time
+// goes. It is compiled in by defining POLYANYA_STATS (`make stats`);
+// otherwise the STATS_ macros below expand to nothing, and a SearchStats is
+// never touched.
+//
+// Time is split into phases. Each cycle spent searching is charged to
+// exactly one phase: the innermost one running, so that the time spent
+// computing h values while generating the initial nodes counts as H_VALUE
+// and not INITIAL_NODES. OTHER is whatever a search does outside of the
+// named phases.
+
+// A histogram with power of two buckets: bucket 0 counts 0, and bucket b
+// counts b-1 bit numbers (2^(b-1) to 2^b - 1).
+struct StatsHistogram
+{
+    static const int NUM_BUCKETS = 33;
+    uint64_t buckets[NUM_BUCKETS];
+    uint64_t count;
+    uint64_t sum;
+    uint64_t max;
+
+    static uint64_t bucket_min(int b)
+    {
+        return b == 0 ? 0 : (uint64_t) 1 << (b - 1);
+    }
+    static uint64_t bucket_max(int b)
+    {
+        return b == 0 ? 0 : ((uint64_t) 1 << b) - 1;
+    }
+
+    void add(uint32_t x)
+    {
+        const int b = x == 0 ? 0 : 32 - __builtin_clz(x);
+        buckets[b]++;
+        count++;
+        sum += x;
+        if (x > max)
+        {
+            max = x;
+        }
+    }
+    // One past the last bucket with anything in it.
+    int num_used_buckets() const
+    {
+        int n = NUM_BUCKETS;
+        while (n > 0 && buckets[n - 1] == 0)
+        {
+            n--;
+        }
+        return n;
+    }
+};
+
+struct SearchStats
+{
+    enum Phase
+    {
+        NONE = -1,          // not searching: nothing is charged
+        OTHER,
+        POINT_LOCATION,     // locating the start and goal
+        INITIAL_NODES,      // generating the nodes around the start
+        SUCCESSORS,         // get_successors
+        NODES,              // turning successors into search nodes
+        H_VALUE,            // get_h_value
+        OPEN_LIST,          // pushing and popping
+        PATH,               // extracting the path
+        NUM_PHASES
+    };
+
+#ifdef POLYANYA_STATS
+    static const bool enabled = true;
+#else
+    static const bool enabled = false;
+#endif
+
+    uint64_t searches;
+    uint64_t cycles[NUM_PHASES];
+    uint64_t calls[NUM_PHASES]; // times each phase was entered
+    StatsHistogram successors;     // successors per get_successors call
+    StatsHistogram open_list_size; // size of the open list at each pop
+
+    // The phase being charged, and when it was last charged.
+    int phase;
+    uint64_t last;
+
+    SearchStats() { reset(); }
+    void reset();
+    // Adds the counts of other to these.
+    void merge(const SearchStats& other);
+
+    static const char* phase_name(int p);
+    // The name of the unit cycles are counted in.
+    static const char* cycle_unit();
+    static uint64_t now()
+    {
+        #if defined(__x86_64__) || defined(__i386__)
+        return __rdtsc();
+        #else
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count();
+        #endif
+    }
+
+    // Charges the time since the last switch to the current phase, then
+    // starts charging p instead.
+    void switch_to(int p)
+    {
+        const uint64_t t = now();
+        if (phase != NONE)
+        {
+            cycles[phase] += t - last;
+        }
+        last = t;
+        phase = p;
+    }
+
+    // print_csv prints a header line and a line of values for the phases,
+    // then for the histograms, separated by semicolons like the rest of
+    // scenariorunner's output. print_json prints the same as one object.
+    void print_csv(std::ostream& out) const;
+    void print_json(std::ostream& out) const;
+};
+
+// Charges its scope to a phase, going back to the enclosing phase after.
+class StatsScope
+{
+    private:
+        SearchStats& stats;
+        int previous;
+
+    public:
+        StatsScope(SearchStats& s, int p) : stats(s), previous(s.phase)
+        {
+            stats.calls[p]++;
+            stats.switch_to(p);
+        }
+        StatsScope(StatsScope const &) = delete;
+        void operator=(StatsScope const &x) = delete;
+        ~StatsScope()
+        {
+            stats.switch_to(previous);
+        }
+};
+
+#ifdef POLYANYA_STATS
+#define STATS_CONCAT_(a, b) a ## b
+#define STATS_CONCAT(a, b) STATS_CONCAT_(a, b)
+// Charges the rest of the enclosing scope to SearchStats::phase.
+#define STATS_SCOPE(stats, phase) \
+    polyanya::StatsScope STATS_CONCAT(stats_scope_, __LINE__)( \
+        stats, polyanya::SearchStats::phase)
+// Runs statement only when the stats are compiled in.
+#define STATS_DO(statement) do { statement; } while (0)
+#else
+#define STATS_SCOPE(stats, phase)
+#define STATS_DO(statement) do { } while (0)
+#endif
+
+}
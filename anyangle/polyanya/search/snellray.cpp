@@ -1,15 +1,178 @@
 #include "snellray.h"
+#include "consts.h"
+#include <cmath>
+#include <cassert>
+#include <limits>
 
 namespace polyanya
 {
-   Point projectRay(Point start, Point middle, int poly2Leave,int poly2Pass, Mesh* mesh)
-   {
+    Point projectRay(Point start, Point middle, int poly2Leave,int poly2Pass, Mesh* mesh)
+    {
+        const PolygonArrays& polygons = mesh->mesh_polygons;
+        const VertexPoints points = mesh->mesh_vertices.points;
+        const int first = polygons.offsets[poly2Pass];
+        const int* V = polygons.vertices + first;
+        const int* N = polygons.neighbours + first;
+        const int n = polygons.num_sides(poly2Pass);
 
-        return middle-start;
-   }    
+        // Find the edge middle is on. poly2Pass is on the left of r -> l.
+        int edge = -1;
+        for (int i = 0; i < n; i++)
+        {
+            const Point& r = points[V[i ? i - 1 : n - 1]];
+            const Point& l = points[V[i]];
+            if (N[i] == poly2Leave &&
+                std::abs((l - r) * (middle - r)) < EPSILON * r.distance(l))
+            {
+                edge = i;
+                break;
+            }
+        }
+        if (edge == -1)
+        {
+            return middle;
+        }
+        const Point& r = points[V[edge ? edge - 1 : n - 1]];
+        const Point& l = points[V[edge]];
+        const Point e = (l - r) * (1 / r.distance(l));
+        const Point normal = {-e.y, e.x}; // into poly2Pass
+        const Point d = (middle - start) * (1 / start.distance(middle));
 
-   Point computeAngle(Point start, Point target,int poly2Leave, int poly2Pass, Mesh* mesh)
-   {
-        return target-start;
-   }
-}
\ No newline at end of file
+        // Snell's law: w1 sin(a1) = w2 sin(a2), with the angles measured
+        // from the normal.
+        const double sin_in = d.x * e.x + d.y * e.y;
+        const double sin_out = polygons.weight(poly2Leave) * sin_in /
+                               polygons.weight(poly2Pass);
+        if (std::abs(sin_out) >= 1)
+        {
+            return middle;
+        }
+        const Point out = e * sin_out +
+                          normal * std::sqrt(1 - sin_out * sin_out);
+
+        // Leave poly2Pass through the nearest other edge.
+        double best = std::numeric_limits<double>::infinity();
+        for (int i = 0; i < n; i++)
+        {
+            if (i == edge)
+            {
+                continue;
+            }
+            const Point& a = points[V[i ? i - 1 : n - 1]];
+            const Point& b = points[V[i]];
+            const double denom = out * (b - a);
+            if (std::abs(denom) < EPSILON)
+            {
+                continue;
+            }
+            const double s = ((a - middle) * (b - a)) / denom;
+            const double u = ((a - middle) * out) / denom;
+            if (s > EPSILON && u > -EPSILON && u < 1 + EPSILON && s < best)
+            {
+                best = s;
+            }
+        }
+        if (best == std::numeric_limits<double>::infinity())
+        {
+            return middle;
+        }
+        return middle + out * best;
+    }
+
+    Point computeAngle(Point start, Point target,int poly2Leave, int poly2Pass, Mesh* mesh)
+    {
+        const PolygonArrays& polygons = mesh->mesh_polygons;
+        const VertexPoints points = mesh->mesh_vertices.points;
+        const int first = polygons.offsets[poly2Leave];
+        const int* V = polygons.vertices + first;
+        const int* N = polygons.neighbours + first;
+        const int n = polygons.num_sides(poly2Leave);
+        const double w_leave = polygons.weight(poly2Leave);
+        const double w_pass = polygons.weight(poly2Pass);
+
+        // The polygons usually share one edge, but take the best if not.
+        Point out = start;
+        double best = std::numeric_limits<double>::infinity();
+        for (int i = 0; i < n; i++)
+        {
+            if (N[i] != poly2Pass)
+            {
+                continue;
+            }
+            const Point p = get_snell_point(start, target,
+                                            points[V[i ? i - 1 : n - 1]],
+                                            points[V[i]], w_leave, w_pass);
+            const double cost = w_leave * start.distance(p) +
+                                w_pass * p.distance(target);
+            if (cost < best)
+            {
+                best = cost;
+                out = p;
+            }
+        }
+        assert(best != std::numeric_limits<double>::infinity());
+        return out;
+    }
+
+    Point get_snell_point(const Point& start, const Point& target,
+                          const Point& r, const Point& l,
+                          double start_weight, double target_weight)
+    {
+        // The cost is convex along the segment, so its slope,
+        // start_weight * sin(a1) - target_weight * sin(a2) with the angles
+        // measured from the normal, only grows from r to l. Bisecting on
+        // its sign finds the minimum to within rounding, where a search on
+        // the cost itself stalls at the square root of that.
+        const Point rl = l - r;
+        const auto slope = [&](double t) -> double
+        {
+            const Point p = r + rl * t;
+            const Point from_start = p - start;
+            const Point to_target = target - p;
+            const double to_start_length = start.distance(p);
+            const double to_target_length = p.distance(target);
+            double out = 0;
+            if (to_start_length > 0)
+            {
+                out += start_weight * (from_start.x * rl.x +
+                                       from_start.y * rl.y) /
+                       to_start_length;
+            }
+            if (to_target_length > 0)
+            {
+                out -= target_weight * (to_target.x * rl.x +
+                                        to_target.y * rl.y) /
+                       to_target_length;
+            }
+            return out;
+        };
+        // The ends are where the cost is often lowest.
+        if (slope(0) >= 0)
+        {
+            return r;
+        }
+        if (slope(1) <= 0)
+        {
+            return l;
+        }
+        double lo = 0, hi = 1;
+        for (int i = 0; i < 100; i++)
+        {
+            const double mid = (lo + hi) / 2;
+            if (mid <= lo || mid >= hi)
+            {
+                break;
+            }
+            if (slope(mid) < 0)
+            {
+                lo = mid;
+            }
+            else
+            {
+                hi = mid;
+            }
+        }
+        const double t = (lo + hi) / 2;
+        return r + (l - r) * t;
+    }
+}
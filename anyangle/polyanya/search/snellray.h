@@ -5,7 +5,19 @@
 namespace polyanya
 {
     //Throw snell ray, and return the point on the edge of mesh2Pass
+    //(where the ray through middle, refracted into poly2Pass, leaves it).
+    //Returns middle if the ray can't enter poly2Pass (total internal
+    //reflection).
     Point projectRay(Point start, Point middle, int poly2Leave,int poly2Pass, Mesh* mesh);
     //Find the snell ray from start point reaching target point, return the point where snellray meets the middle edge
+    //(the edge shared by poly2Leave and poly2Pass).
     Point computeAngle(Point start, Point target,int poly2Leave, int poly2Pass, Mesh* mesh);
+
+    // Finds the point p on segment r-l minimising
+    // start_weight * |start - p| + target_weight * |p - target|, which is
+    // where a path from start to target should cross an edge between
+    // polygons of those weights. Inside the segment this obeys Snell's law.
+    Point get_snell_point(const Point& start, const Point& target,
+                          const Point& r, const Point& l,
+                          double start_weight, double target_weight);
 }
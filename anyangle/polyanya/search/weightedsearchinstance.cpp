@@ -0,0 +1,819 @@
+#include "weightedsearchinstance.h"
+#include "snellray.h"
+#include "expansion.h"
+#include "searchnode.h"
+#include "successor.h"
+#include "vertex.h"
+#include "mesh.h"
+#include "point.h"
+#include "consts.h"
+#include <vector>
+#include <unordered_map>
+#include <cassert>
+#include <cmath>
+#include <iostream>
+#include <algorithm>
+#include <stdint.h>
+
+namespace polyanya
+{
+
+void WeightedSearchInstance::build_crossings()
+{
+    const PolygonArrays& polygons = mesh->mesh_polygons;
+    const VertexPoints points = mesh->mesh_vertices.points;
+    const int P = polygons.size();
+    crossings.clear();
+    slot_first_crossing.assign(polygons.offsets[P], 0);
+    slot_last_crossing.assign(polygons.offsets[P], 0);
+
+    // Both sides of an edge share its crossings. An edge is keyed by its
+    // vertices in the order the first side to be seen has them.
+    const auto key = [](int a, int b) -> uint64_t
+    {
+        return ((uint64_t) (uint32_t) a << 32) | (uint32_t) b;
+    };
+    std::unordered_map<uint64_t, int> first_side;
+    for (int p = 0; p < P; p++)
+    {
+        const int first = polygons.offsets[p];
+        const int* V = polygons.vertices + first;
+        const int* N = polygons.neighbours + first;
+        const int n = polygons.num_sides(p);
+        for (int i = 0; i < n; i++)
+        {
+            const int q = N[i];
+            if (q == -1 || polygons.weight(p) == polygons.weight(q))
+            {
+                continue;
+            }
+            const int right_vertex = V[i ? i - 1 : n - 1];
+            const int left_vertex = V[i];
+            const auto seen = first_side.find(key(left_vertex, right_vertex));
+            if (seen != first_side.end())
+            {
+                slot_first_crossing[first + i] =
+                    slot_first_crossing[seen->second];
+                slot_last_crossing[first + i] =
+                    slot_last_crossing[seen->second];
+                continue;
+            }
+            first_side[key(right_vertex, left_vertex)] = first + i;
+
+            const Point& r = points[right_vertex];
+            const Point& l = points[left_vertex];
+            const int num_gaps = std::max(1,
+                (int) std::ceil(r.distance(l) / crossing_spacing - EPSILON));
+            slot_first_crossing[first + i] = (int) crossings.size();
+            for (int j = 1; j < num_gaps; j++)
+            {
+                crossings.push_back({r + (l - r) * (j / (double) num_gaps),
+                                     p, q, right_vertex, left_vertex,
+                                     first + i});
+            }
+            slot_last_crossing[first + i] = (int) crossings.size();
+        }
+    }
+
+    const size_t num_roots = mesh->mesh_vertices.size() + crossings.size();
+    root_g_values.resize(num_roots);
+    root_search_ids.resize(num_roots);
+    root_arrived.resize(num_roots);
+    crossings_mesh_version = mesh->get_version();
+    min_weight = mesh->get_min_weight();
+}
+
+PointLocation WeightedSearchInstance::get_point_location(Point p)
+{
+    // As SearchInstance::get_point_location: nudge ambiguous points off
+    // the vertex they lie on to pick a polygon.
+    PointLocation out = mesh->get_point_location(p);
+    if (out.type == PointLocation::ON_CORNER_VERTEX_AMBIG)
+    {
+        static const Point CORRECTOR = {EPSILON * 10, EPSILON * 10};
+        const PointLocation corrected =
+            mesh->get_point_location(p + CORRECTOR);
+        switch (corrected.type)
+        {
+            case PointLocation::IN_POLYGON:
+            case PointLocation::ON_MESH_BORDER:
+            case PointLocation::ON_EDGE:
+                out.poly1 = corrected.poly1;
+                break;
+
+            default:
+                break;
+        }
+    }
+    return out;
+}
+
+void WeightedSearchInstance::init_search()
+{
+    if (mesh->get_version() != crossings_mesh_version)
+    {
+        build_crossings();
+    }
+    node_pool->reclaim();
+    search_id++;
+    open_list.clear();
+    final_node = nullptr;
+    path.clear();
+    path_roots.clear();
+    path_segment_costs.clear();
+    path_cost = -1;
+    nodes_generated = 0;
+    nodes_pushed = 0;
+    nodes_popped = 0;
+    nodes_pruned_post_pop = 0;
+    successor_calls = 0;
+
+    // The goal can be reached through any polygon it touches.
+    end_polygons.clear();
+    const PointLocation pl = get_point_location(goal);
+    switch (pl.type)
+    {
+        case PointLocation::NOT_ON_MESH:
+            break;
+
+        case PointLocation::ON_CORNER_VERTEX_AMBIG:
+            // As for the start, only the polygon it was nudged into.
+            if (pl.poly1 != -1)
+            {
+                end_polygons.push_back(pl.poly1);
+            }
+            break;
+
+        case PointLocation::IN_POLYGON:
+        case PointLocation::ON_MESH_BORDER:
+            end_polygons.push_back(pl.poly1);
+            break;
+
+        case PointLocation::ON_EDGE:
+            end_polygons.push_back(pl.poly1);
+            end_polygons.push_back(pl.poly2);
+            break;
+
+        case PointLocation::ON_CORNER_VERTEX_UNAMBIG:
+        case PointLocation::ON_NON_CORNER_VERTEX:
+            for (int poly : mesh->mesh_vertices[pl.vertex1].polygons)
+            {
+                if (poly != -1)
+                {
+                    end_polygons.push_back(poly);
+                }
+            }
+            break;
+
+        default:
+            assert(false);
+            break;
+    }
+}
+
+bool WeightedSearchInstance::reach_root(int root, double g, bool arrival)
+{
+    assert(root >= 0 && root < (int) root_g_values.size());
+    if (root_search_ids[root] != search_id ||
+        g < root_g_values[root] - EPSILON)
+    {
+        root_search_ids[root] = search_id;
+        root_g_values[root] = g;
+        root_arrived[root] = arrival;
+        return true;
+    }
+    if (root_g_values[root] + EPSILON < g)
+    {
+        return false;
+    }
+    if (arrival)
+    {
+        // An arrival expands every polygon around the root, so a second
+        // one at the same cost adds nothing. Edges between weights meet at
+        // many vertices, and paths along them which tie would otherwise
+        // each be expanded again.
+        if (root_arrived[root])
+        {
+            return false;
+        }
+        root_arrived[root] = true;
+    }
+    root_g_values[root] = g;
+    return true;
+}
+
+void WeightedSearchInstance::push(
+    SearchNodePtr parent, int root, const Point& left, const Point& right,
+    int left_vertex, int right_vertex, int cur_polygon, int next_polygon,
+    double f, double g
+)
+{
+    SearchNodePtr n = new (node_pool->allocate()) SearchNode
+        {parent, root, left, right, left_vertex, right_vertex, cur_polygon,
+         next_polygon, f, g};
+    nodes_generated++;
+    nodes_pushed++;
+    open_list.push(n);
+}
+
+// Node kinds, as pushed onto the open list:
+// - Final nodes reach the goal. They are the only nodes with a left_vertex
+//   of -1 and a next_polygon.
+// - Arrivals reach a crossing or a vertex on an edge between weights, and
+//   expand into every polygon around it but the one they came through (their
+//   cur_polygon). They have no next_polygon.
+// - Everything else is a normal Polyanya node.
+void WeightedSearchInstance::push_final(SearchNodePtr parent, int root,
+                                        int poly, double cost, double g)
+{
+    push(parent, root, goal, goal, -1, -1, poly, poly, cost, g);
+}
+
+void WeightedSearchInstance::expand_from_point(
+    SearchNodePtr parent, int root, double g, int poly, int left_vertex,
+    int right_vertex
+)
+{
+    const PolygonArrays& polygons = mesh->mesh_polygons;
+    const VertexPoints points = mesh->mesh_vertices.points;
+    const Point& root_point = root_to_point(root);
+    const double w = polygons.weight(poly);
+    if (is_end_polygon(poly))
+    {
+        push_final(parent, root, poly, g + w * root_point.distance(goal), g);
+    }
+
+    const int first = polygons.offsets[poly];
+    const int* V = polygons.vertices + first;
+    const int* N = polygons.neighbours + first;
+    const int n = polygons.num_sides(poly);
+    int last_vertex = V[n - 1];
+    for (int i = 0; i < n; i++)
+    {
+        const int vertex = V[i];
+        const int next_polygon = N[i];
+        if (vertex == right_vertex || last_vertex == left_vertex ||
+            next_polygon == -1 ||
+            ((polygons.flags[next_polygon] & POLYGON_ONE_WAY) &&
+             !is_end_polygon(next_polygon)))
+        {
+            last_vertex = vertex;
+            continue;
+        }
+        const Point& l = points[vertex];
+        const Point& r = points[last_vertex];
+        if (polygons.weight(next_polygon) == w)
+        {
+            push(parent, root, l, r, vertex, last_vertex, poly, next_polygon,
+                 g + min_weight * get_h_value(root_point, goal, l, r), g);
+        }
+        else
+        {
+            cross_edge(parent, root, g, poly, first + i, r, l, last_vertex,
+                       vertex);
+        }
+        last_vertex = vertex;
+    }
+}
+
+void WeightedSearchInstance::slide_along_edge(
+    SearchNodePtr parent, int root, double g, int poly, int slot
+)
+{
+    // Running along the edge costs as much as running just inside the
+    // cheaper polygon, which the search would otherwise only approach
+    // from its interior.
+    const PolygonArrays& polygons = mesh->mesh_polygons;
+    const VertexPoints points = mesh->mesh_vertices.points;
+    const int first = polygons.offsets[poly];
+    const int right_vertex = polygons.vertices[
+        slot == first ? polygons.offsets[poly + 1] - 1 : slot - 1];
+    const int left_vertex = polygons.vertices[slot];
+    const double w = std::min(polygons.weight(poly),
+                              polygons.weight(polygons.neighbours[slot]));
+    const Point& r = points[right_vertex];
+    const Point& l = points[left_vertex];
+    const Point rl = l - r;
+    const double length = r.distance(l);
+    const auto along = [&](const Point& p) -> double
+    {
+        return ((p.x - r.x) * rl.x + (p.y - r.y) * rl.y) / (length * length);
+    };
+
+    // The nearest of the edge's ends and crossings on either side.
+    const Point& root_point = root_to_point(root);
+    const double t = along(root_point);
+    const double margin = EPSILON / length;
+    int below = -1, above = -1;
+    double t_below = -1, t_above = 2;
+    const auto consider = [&](int id, double t_id)
+    {
+        if (t_id < t - margin && t_id > t_below)
+        {
+            below = id;
+            t_below = t_id;
+        }
+        else if (t_id > t + margin && t_id < t_above)
+        {
+            above = id;
+            t_above = t_id;
+        }
+    };
+    consider(right_vertex, 0);
+    consider(left_vertex, 1);
+    const int V = mesh->mesh_vertices.size();
+    for (int c = slot_first_crossing[slot]; c < slot_last_crossing[slot];
+         c++)
+    {
+        consider(V + c, along(crossings[c].p));
+    }
+
+    for (int id : {below, above})
+    {
+        if (id == -1 || id == root)
+        {
+            continue;
+        }
+        const Point& p = root_to_point(id);
+        const double arrival_g = g + w * root_point.distance(p);
+        if (reach_root(id, arrival_g, true))
+        {
+            // Neither polygon was passed through, so the arrival expands
+            // into both.
+            push(parent, id, p, p, -1, -1, -1, -1,
+                 arrival_g + min_weight * p.distance(goal), arrival_g);
+        }
+    }
+}
+
+void WeightedSearchInstance::slide_from_vertex(
+    SearchNodePtr parent, int root, double g, int vertex
+)
+{
+    const PolygonArrays& polygons = mesh->mesh_polygons;
+    for (int poly : mesh->mesh_vertices[vertex].polygons)
+    {
+        if (poly == -1)
+        {
+            continue;
+        }
+        const int first = polygons.offsets[poly];
+        const int* V = polygons.vertices + first;
+        const int* N = polygons.neighbours + first;
+        const int n = polygons.num_sides(poly);
+        int last_vertex = V[n - 1];
+        for (int i = 0; i < n; i++)
+        {
+            // Each edge is slid along from the cheaper of its polygons.
+            if ((V[i] == vertex || last_vertex == vertex) && N[i] != -1 &&
+                polygons.weight(poly) < polygons.weight(N[i]))
+            {
+                slide_along_edge(parent, root, g, poly, first + i);
+            }
+            last_vertex = V[i];
+        }
+    }
+}
+
+void WeightedSearchInstance::expand_arrival(SearchNodePtr node)
+{
+    // The path never needs to go back into the polygon it arrived through:
+    // that polygon is convex, so going straight from where the path entered
+    // it is no more expensive.
+    const int root = node->root;
+    const int V = mesh->mesh_vertices.size();
+    if (root < V)
+    {
+        for (int poly : mesh->mesh_vertices[root].polygons)
+        {
+            if (poly != -1 && poly != node->cur_polygon)
+            {
+                expand_from_point(node, root, node->g, poly, root, root);
+            }
+        }
+        slide_from_vertex(node, root, node->g, root);
+    }
+    else
+    {
+        const Crossing& c = crossings[root - V];
+        if (c.poly != node->cur_polygon)
+        {
+            expand_from_point(node, root, node->g, c.poly, c.right_vertex,
+                              c.left_vertex);
+        }
+        if (c.other_poly != node->cur_polygon)
+        {
+            expand_from_point(node, root, node->g, c.other_poly,
+                              c.left_vertex, c.right_vertex);
+        }
+        slide_along_edge(node, root, node->g, c.poly, c.slot);
+    }
+}
+
+void WeightedSearchInstance::expand_node(SearchNodePtr node)
+{
+    const PolygonArrays& polygons = mesh->mesh_polygons;
+    const int poly = node->next_polygon;
+    const double w = polygons.weight(poly);
+    const Point& root_point = root_to_point(node->root);
+
+    if (is_end_polygon(poly))
+    {
+        // As SearchInstance::make_final_node, but the goal may still be
+        // cheaper to reach some other way, so this goes on the open list.
+        const Point root_goal = goal - root_point;
+        int final_root = node->root;
+        double final_g = node->g;
+        if (root_goal * (node->left - root_point) < -EPSILON)
+        {
+            final_root = node->left_vertex;
+            final_g += w * root_point.distance(node->left);
+        }
+        else if ((node->right - root_point) * root_goal < -EPSILON)
+        {
+            final_root = node->right_vertex;
+            final_g += w * root_point.distance(node->right);
+        }
+        push_final(node, final_root, poly,
+                   node->g + w * get_h_value(root_point, goal, node->left,
+                                             node->right),
+                   final_g);
+    }
+
+    // get_successors finds the root of a node with a root of -1 from its
+    // start argument, which lets crossings be roots too.
+    SearchNode copy = *node;
+    copy.root = -1;
+    const int num_succ = get_successors(copy, root_point, *mesh,
+                                        search_successors);
+    successor_calls++;
+
+    const int first = polygons.offsets[poly];
+    const int* V = polygons.vertices + first;
+    const int* N = polygons.neighbours + first;
+    const int n = polygons.num_sides(poly);
+    // Nodes for the turns at either end of the interval, so crossings seen
+    // past a turn have the turn in their path.
+    SearchNodePtr right_turn = nullptr, left_turn = nullptr;
+    for (int i = 0; i < num_succ; i++)
+    {
+        const Successor& succ = search_successors[i];
+        const int next_polygon = N[succ.poly_left_ind];
+        if (next_polygon == -1 ||
+            ((polygons.flags[next_polygon] & POLYGON_ONE_WAY) &&
+             !is_end_polygon(next_polygon)))
+        {
+            continue;
+        }
+        const int left_vertex = V[succ.poly_left_ind];
+        const int right_vertex = succ.poly_left_ind ?
+                                 V[succ.poly_left_ind - 1] :
+                                 V[n - 1];
+
+        int root = node->root;
+        double g = node->g;
+        SearchNodePtr* turn = nullptr;
+        switch (succ.type)
+        {
+            case Successor::RIGHT_NON_OBSERVABLE:
+                root = node->right_vertex;
+                g += w * root_point.distance(node->right);
+                turn = &right_turn;
+                break;
+
+            case Successor::OBSERVABLE:
+                break;
+
+            case Successor::LEFT_NON_OBSERVABLE:
+                root = node->left_vertex;
+                g += w * root_point.distance(node->left);
+                turn = &left_turn;
+                break;
+
+            default:
+                assert(false);
+                break;
+        }
+        if (turn && !reach_root(root, g, false))
+        {
+            continue;
+        }
+
+        if (polygons.weight(next_polygon) == w)
+        {
+            push(node, root, succ.left, succ.right, left_vertex,
+                 right_vertex, poly, next_polygon,
+                 g + min_weight * get_h_value(root_to_point(root), goal,
+                                              succ.left, succ.right),
+                 g);
+            continue;
+        }
+        SearchNodePtr parent = node;
+        if (turn)
+        {
+            if (*turn == nullptr)
+            {
+                *turn = new (node_pool->allocate()) SearchNode
+                    {node, root, succ.left, succ.right, left_vertex,
+                     right_vertex, poly, next_polygon, g, g};
+                nodes_generated++;
+            }
+            parent = *turn;
+        }
+        cross_edge(parent, root, g, poly, first + succ.poly_left_ind,
+                   succ.right, succ.left, right_vertex, left_vertex);
+    }
+}
+
+void WeightedSearchInstance::cross_edge(
+    SearchNodePtr parent, int root, double g, int poly, int slot,
+    const Point& right, const Point& left, int right_vertex, int left_vertex
+)
+{
+    const Point& root_point = root_to_point(root);
+    const double w = mesh->mesh_polygons.weight(poly);
+    const Point& r = mesh->mesh_vertices.points[right_vertex];
+    const Point& l = mesh->mesh_vertices.points[left_vertex];
+    const Point rl = l - r;
+    const double length_sq = rl.x * rl.x + rl.y * rl.y;
+    const auto along = [&](const Point& p) -> double
+    {
+        return ((p.x - r.x) * rl.x + (p.y - r.y) * rl.y) / length_sq;
+    };
+
+    const auto arrive = [&](int id, const Point& p)
+    {
+        if (id == root)
+        {
+            return;
+        }
+        const double arrival_g = g + w * root_point.distance(p);
+        if (reach_root(id, arrival_g, true))
+        {
+            push(parent, id, p, p, -1, -1, poly, -1,
+                 arrival_g + min_weight * p.distance(goal), arrival_g);
+        }
+    };
+
+    if (right.distance(r) < EPSILON)
+    {
+        arrive(right_vertex, r);
+    }
+    const double lo = along(right) - EPSILON;
+    const double hi = along(left) + EPSILON;
+    const int V = mesh->mesh_vertices.size();
+    for (int c = slot_first_crossing[slot]; c < slot_last_crossing[slot];
+         c++)
+    {
+        const double t = along(crossings[c].p);
+        if (t >= lo && t <= hi)
+        {
+            arrive(V + c, crossings[c].p);
+        }
+    }
+    if (left.distance(l) < EPSILON)
+    {
+        arrive(left_vertex, l);
+    }
+}
+
+bool WeightedSearchInstance::search()
+{
+    timer.start();
+    init_search();
+
+    SearchNodePtr start_node = new (node_pool->allocate()) SearchNode
+        {nullptr, -1, start, start, -1, -1, -1, -1,
+         min_weight * start.distance(goal), 0};
+    nodes_generated++;
+    const PolygonArrays& polygons = mesh->mesh_polygons;
+    const PointLocation pl = get_point_location(start);
+    switch (pl.type)
+    {
+        case PointLocation::NOT_ON_MESH:
+            break;
+
+        case PointLocation::ON_CORNER_VERTEX_AMBIG:
+            if (pl.poly1 == -1)
+            {
+                break;
+            }
+        case PointLocation::IN_POLYGON:
+        case PointLocation::ON_MESH_BORDER:
+            expand_from_point(start_node, -1, 0, pl.poly1, -1, -1);
+            break;
+
+        case PointLocation::ON_EDGE:
+        {
+            expand_from_point(start_node, -1, 0, pl.poly2, pl.vertex1,
+                              pl.vertex2);
+            expand_from_point(start_node, -1, 0, pl.poly1, pl.vertex2,
+                              pl.vertex1);
+            if (polygons.weight(pl.poly1) == polygons.weight(pl.poly2))
+            {
+                break;
+            }
+            // The start can also run along the edge.
+            const int first = polygons.offsets[pl.poly1];
+            const int n = polygons.num_sides(pl.poly1);
+            for (int i = 0; i < n; i++)
+            {
+                if (polygons.neighbours[first + i] == pl.poly2)
+                {
+                    slide_along_edge(start_node, -1, 0, pl.poly1, first + i);
+                    break;
+                }
+            }
+            break;
+        }
+
+        case PointLocation::ON_CORNER_VERTEX_UNAMBIG:
+        case PointLocation::ON_NON_CORNER_VERTEX:
+            for (int poly : mesh->mesh_vertices[pl.vertex1].polygons)
+            {
+                if (poly != -1)
+                {
+                    expand_from_point(start_node, -1, 0, poly, pl.vertex1,
+                                      pl.vertex1);
+                }
+            }
+            slide_from_vertex(start_node, -1, 0, pl.vertex1);
+            break;
+
+        default:
+            assert(false);
+            break;
+    }
+
+    while (!open_list.empty())
+    {
+        SearchNodePtr node = open_list.top(); open_list.pop();
+        nodes_popped++;
+
+        #ifndef NDEBUG
+        if (verbose)
+        {
+            std::cerr << "popped off: root=" << root_to_point(node->root)
+                      << "; left=" << node->left << "; right="
+                      << node->right << "; next=" << node->next_polygon
+                      << "; f=" << node->f << "; g=" << node->g
+                      << std::endl;
+        }
+        #endif
+
+        if (node->left_vertex == -1 && node->next_polygon != -1)
+        {
+            final_node = node;
+            break;
+        }
+        const int root = node->root;
+        if (root != -1 && root_search_ids[root] == search_id &&
+            root_g_values[root] + EPSILON < node->g)
+        {
+            nodes_pruned_post_pop++;
+            continue;
+        }
+        if (node->next_polygon == -1)
+        {
+            expand_arrival(node);
+        }
+        else
+        {
+            expand_node(node);
+        }
+    }
+
+    if (final_node != nullptr)
+    {
+        build_path();
+        refine_path();
+    }
+    timer.stop();
+    return final_node != nullptr;
+}
+
+void WeightedSearchInstance::build_path()
+{
+    std::vector<double> g_values;
+    path.assign(1, goal);
+    path_roots.assign(1, -1);
+    g_values.assign(1, final_node->f);
+    for (SearchNodePtr node = final_node; node != nullptr;
+         node = node->parent)
+    {
+        const Point& p = root_to_point(node->root);
+        if (p != path.back())
+        {
+            path.push_back(p);
+            path_roots.push_back(node->root);
+            g_values.push_back(node->g);
+        }
+    }
+    std::reverse(path.begin(), path.end());
+    std::reverse(path_roots.begin(), path_roots.end());
+    std::reverse(g_values.begin(), g_values.end());
+
+    path_segment_costs.resize(path.size() - 1);
+    for (int i = 0; i + 1 < (int) path.size(); i++)
+    {
+        path_segment_costs[i] = g_values[i + 1] - g_values[i];
+    }
+    path_cost = final_node->f;
+}
+
+void WeightedSearchInstance::refine_path()
+{
+    const PolygonArrays& polygons = mesh->mesh_polygons;
+    const VertexPoints points = mesh->mesh_vertices.points;
+    const int V = mesh->mesh_vertices.size();
+    const int n = (int) path.size();
+    for (int iteration = 0; iteration < refine_iterations; iteration++)
+    {
+        bool improved = false;
+        for (int i = 1; i + 1 < n; i++)
+        {
+            if (path_roots[i] < V)
+            {
+                // Only crossings can slide.
+                continue;
+            }
+            const Crossing& c = crossings[path_roots[i] - V];
+            const Point& a = path[i - 1];
+            const Point& b = path[i + 1];
+            const Point& r = points[c.right_vertex];
+            const Point& l = points[c.left_vertex];
+            // Which side of the edge is the path coming from?
+            const double side_a = (l - r) * (a - r);
+            const double side_b = (l - r) * (b - r);
+            double w_a, w_b;
+            if (side_a > EPSILON && side_b < -EPSILON)
+            {
+                w_a = polygons.weight(c.poly);
+                w_b = polygons.weight(c.other_poly);
+            }
+            else if (side_a < -EPSILON && side_b > EPSILON)
+            {
+                w_a = polygons.weight(c.other_poly);
+                w_b = polygons.weight(c.poly);
+            }
+            else
+            {
+                continue;
+            }
+            const Point p = get_snell_point(a, b, r, l, w_a, w_b);
+            if (p.distance(path[i]) < EPSILON)
+            {
+                continue;
+            }
+            // The new segments can run into other polygons, so take their
+            // actual cost.
+            const double cost_a = get_segment_cost(a, p);
+            const double cost_b = get_segment_cost(p, b);
+            if (cost_a < 0 || cost_b < 0 ||
+                cost_a + cost_b >= path_segment_costs[i - 1] +
+                                   path_segment_costs[i] - EPSILON)
+            {
+                continue;
+            }
+            path[i] = p;
+            path_segment_costs[i - 1] = cost_a;
+            path_segment_costs[i] = cost_b;
+            improved = true;
+        }
+        if (!improved)
+        {
+            break;
+        }
+    }
+    path_cost = 0;
+    for (double cost : path_segment_costs)
+    {
+        path_cost += cost;
+    }
+}
+
+double WeightedSearchInstance::get_segment_cost(const Point& a,
+                                                const Point& b) const
+{
+    if (a.distance(b) < EPSILON)
+    {
+        return 0;
+    }
+    // Walk both ways from the middle, which is (almost always) inside a
+    // polygon, unlike the ends.
+    const Point middle = (a + b) * 0.5;
+    const PointLocation loc = mesh->get_point_location(middle);
+    if (loc.type != PointLocation::IN_POLYGON)
+    {
+        return -1;
+    }
+    const double to_a = mesh->get_segment_cost(loc.poly1, middle, a);
+    const double to_b = mesh->get_segment_cost(loc.poly1, middle, b);
+    if (to_a < 0 || to_b < 0)
+    {
+        return -1;
+    }
+    return to_a + to_b;
+}
+
+}
@@ -0,0 +1,208 @@
+#pragma once
+#include "searchnode.h"
+#include "openlist.h"
+#include "successor.h"
+#include "mesh.h"
+#include "point.h"
+#include "cpool.h"
+#include "timer.h"
+#include <vector>
+#include <algorithm>
+
+namespace polyanya
+{
+
+// Polyanya on a weighted mesh, where the cost of a path is the sum of its
+// length through each polygon times the polygon's weight.
+//
+// Within a region of equally weighted polygons this is the usual search.
+// Where the weight changes, shortest paths bend (following Snell's law), so
+// a node stops at such an edge instead of passing through it: the path
+// crosses at one of a set of evenly spaced points along the edge, or at one
+// of its ends, each of which becomes a root which expands into the polygons
+// on both sides. A path can also run along such an edge, at the smaller of
+// the two weights, from one of these points to the next. Each crossing on
+// the path found is then slid along its edge to where the bend obeys
+// Snell's law (see snellray.h).
+//
+// This is an approximate search, not an exact propagation of intervals
+// across such edges: the path is optimal up to the spacing of the crossing
+// points, and only then refined.
+// The heuristic is the usual one times the smallest weight on the mesh,
+// which keeps it admissible.
+class WeightedSearchInstance
+{
+    private:
+        // A point where paths can cross an edge between polygons of
+        // different weights. Roots count these after the mesh's vertices.
+        struct Crossing
+        {
+            Point p;
+            // poly is on the left of right_vertex -> left_vertex, and
+            // other_poly on its right. slot is that side of poly, as an
+            // index into the mesh's packed polygon arrays.
+            int poly, other_poly;
+            int right_vertex, left_vertex;
+            int slot;
+        };
+
+        warthog::mem::cpool* node_pool;
+        Mesh* mesh;
+        Point start, goal;
+
+        SearchNodePtr final_node;
+        // Every polygon the goal is in or on the boundary of.
+        std::vector<int> end_polygons;
+        BinaryHeapOpenList open_list;
+
+        // Best g value for each root (vertices, then crossings), and
+        // whether an arrival has been pushed there at that g.
+        std::vector<double> root_g_values;
+        std::vector<int> root_search_ids;
+        std::vector<char> root_arrived;
+        int search_id;
+
+        warthog::timer timer;
+
+        // The crossings of the edge on side i of polygon p are
+        // crossings[slot_first_crossing[j]] to
+        // crossings[slot_last_crossing[j] - 1], where j is the index of the
+        // side in the mesh's packed polygon arrays.
+        double crossing_spacing;
+        std::vector<Crossing> crossings;
+        std::vector<int> slot_first_crossing;
+        std::vector<int> slot_last_crossing;
+        int crossings_mesh_version; // rebuilt when the mesh changes
+        double min_weight;
+
+        int refine_iterations;
+        // The last path found, and the cost of each of its segments.
+        std::vector<Point> path;
+        std::vector<int> path_roots;
+        std::vector<double> path_segment_costs;
+        double path_cost;
+
+        // Pre-initialised variables to use in search().
+        Successor* search_successors;
+
+        void init()
+        {
+            verbose = false;
+            search_id = 0;
+            crossing_spacing = 1;
+            refine_iterations = 8;
+            path_cost = -1;
+            search_successors = new Successor [mesh->max_poly_sides + 2];
+            node_pool = new warthog::mem::cpool(sizeof(SearchNode));
+            build_crossings();
+        }
+        void build_crossings();
+        PointLocation get_point_location(Point p);
+        void init_search();
+        bool is_end_polygon(int poly) const
+        {
+            return std::find(end_polygons.begin(), end_polygons.end(),
+                             poly) != end_polygons.end();
+        }
+        Point root_to_point(int root) const
+        {
+            if (root == -1)
+            {
+                return start;
+            }
+            const int V = mesh->mesh_vertices.size();
+            return root < V ? mesh->mesh_vertices.points[root] :
+                              crossings[root - V].p;
+        }
+        // Records g as the best way to reach root yet, unless it's worse,
+        // or it ties an earlier arrival and this is an arrival too.
+        bool reach_root(int root, double g, bool arrival);
+        void push(SearchNodePtr parent, int root, const Point& left,
+                  const Point& right, int left_vertex, int right_vertex,
+                  int cur_polygon, int next_polygon, double f, double g);
+        void push_final(SearchNodePtr parent, int root, int poly,
+                        double cost, double g);
+        // Pushes nodes for every side of poly seen from the root (which is
+        // on poly's boundary or inside it), except for those touching
+        // left_vertex and right_vertex, as the lazy nodes of SearchInstance.
+        void expand_from_point(SearchNodePtr parent, int root, double g,
+                               int poly, int left_vertex, int right_vertex);
+        // Pushes arrivals at the points next to the root (which is on the
+        // edge) along side slot of poly, an edge between two weights.
+        void slide_along_edge(SearchNodePtr parent, int root, double g,
+                              int poly, int slot);
+        // slide_along_edge for every edge between two weights which ends
+        // at vertex, where the root is.
+        void slide_from_vertex(SearchNodePtr parent, int root, double g,
+                               int vertex);
+        void expand_arrival(SearchNodePtr node);
+        void expand_node(SearchNodePtr node);
+        // Pushes the crossings of side slot of poly (from right to left),
+        // seen from the root through the interval right-left.
+        void cross_edge(SearchNodePtr parent, int root, double g, int poly,
+                        int slot, const Point& right, const Point& left,
+                        int right_vertex, int left_vertex);
+        void build_path();
+        void refine_path();
+        double get_segment_cost(const Point& a, const Point& b) const;
+
+    public:
+        int nodes_generated;        // Nodes stored in memory
+        int nodes_pushed;           // Nodes pushed onto open
+        int nodes_popped;           // Nodes popped off open
+        int nodes_pruned_post_pop;  // Nodes we prune right after popping off
+        int successor_calls;        // Times we call get_successors
+        bool verbose;
+
+        WeightedSearchInstance(Mesh* m) : mesh(m) { init(); }
+        WeightedSearchInstance(WeightedSearchInstance const &) = delete;
+        void operator=(WeightedSearchInstance const &x) = delete;
+        ~WeightedSearchInstance()
+        {
+            delete node_pool;
+            delete[] search_successors;
+        }
+
+        void set_start_goal(Point s, Point g)
+        {
+            start = s;
+            goal = g;
+            final_node = nullptr;
+            path_cost = -1;
+        }
+
+        // How far apart (at most) the points where a path may cross from
+        // one weight to another are. Smaller spacings give cheaper paths
+        // but slower searches.
+        void set_crossing_spacing(double spacing)
+        {
+            assert(spacing > 0);
+            crossing_spacing = spacing;
+            build_crossings();
+        }
+        // How many times the path is swept over, sliding each crossing to
+        // where it obeys Snell's law. 0 leaves the path as searched.
+        void set_refine_iterations(int iterations)
+        {
+            refine_iterations = iterations;
+        }
+
+        bool search();
+
+        double get_cost()
+        {
+            return path_cost;
+        }
+
+        double get_search_micro()
+        {
+            return timer.elapsed_time_micro();
+        }
+
+        void get_path_points(std::vector<Point>& out)
+        {
+            out = path;
+        }
+};
+
+}
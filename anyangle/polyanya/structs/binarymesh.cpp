@@ -0,0 +1,308 @@
+#include "binarymesh.h"
+#include "mesh.h"
+#include "mappedfile.h"
+#include <stdint.h>
+#include <vector>
+#include <iostream>
+#include <fstream>
+#include <string>
+#include <cstring>
+#include <cassert>
+
+namespace polyanya
+{
+
+// The mapped sections are used as these arrays directly.
+static_assert(sizeof(Point) == 2 * sizeof(double), "Point must be 2 doubles");
+static_assert(sizeof(PolygonBounds) == 4 * sizeof(double),
+              "PolygonBounds must be 4 doubles");
+
+Mesh::Mesh(const std::string& binary_filename) :
+    pl_method(PointLocationMethod::GRID), version(0)
+{
+    read_binary(binary_filename);
+}
+
+bool Mesh::is_binary_file(const std::string& filename)
+{
+    std::ifstream infile(filename, std::ios::in | std::ios::binary);
+    char magic[sizeof(BINARY_MESH_MAGIC)];
+    if (!infile.read(magic, sizeof(magic)))
+    {
+        return false;
+    }
+    return std::memcmp(magic, BINARY_MESH_MAGIC, sizeof(magic)) == 0;
+}
+
+void Mesh::read_binary(const std::string& filename)
+{
+    #define fail(message) std::cerr << message << std::endl; exit(1);
+    mapped.reset(new MappedFile);
+    // Nothing is copied out of the mapping until set_blocked() needs to.
+    vertex_points_storage.clear();
+    vertex_flags_storage.clear();
+    vertex_offsets_storage.clear();
+    vertex_polygons_storage.clear();
+    polygon_offsets_storage.clear();
+    polygon_vertices_storage.clear();
+    polygon_neighbours_storage.clear();
+    polygon_bounds_storage.clear();
+    polygon_flags_storage.clear();
+    polygon_weights_storage.clear();
+    min_weight = 1;
+    vertex_polygons_original.clear();
+    polygon_neighbours_original.clear();
+    version++;
+    if (!mapped->open(filename))
+    {
+        fail("Error mapping binary mesh");
+    }
+    const char* data = mapped->data();
+    const size_t size = mapped->size();
+
+    if (size < sizeof(BinaryMeshHeader))
+    {
+        fail("Error reading header");
+    }
+    const BinaryMeshHeader& header =
+        *reinterpret_cast<const BinaryMeshHeader*>(data);
+    if (std::memcmp(header.magic, BINARY_MESH_MAGIC,
+                    sizeof(BINARY_MESH_MAGIC)) != 0)
+    {
+        fail("Invalid header (expecting binary mesh)");
+    }
+    if (header.byte_order != BINARY_MESH_BYTE_ORDER)
+    {
+        fail("Binary mesh was written with a different byte order");
+    }
+    if (header.version != BINARY_MESH_VERSION)
+    {
+        std::cerr << "Got file with version " << header.version << std::endl;
+        fail("Invalid version (expecting 1)");
+    }
+
+    const int V = header.num_vertices;
+    const int P = header.num_polygons;
+    if (V < 1)
+    {
+        std::cerr << "Got " << V << " vertices" << std::endl;
+        fail("Invalid number of vertices");
+    }
+    if (P < 1)
+    {
+        std::cerr << "Got " << P << " polygons" << std::endl;
+        fail("Invalid number of polygons");
+    }
+    if (header.grid_width < 1 || header.grid_height < 1 ||
+        !(header.grid_cell_size > 0))
+    {
+        fail("Invalid point location grid");
+    }
+
+    // Gets a pointer to a section, checking that it fits in the file.
+    const auto section = [&](int index, uint64_t elem_size) -> const char*
+    {
+        const BinaryMeshSection& s = header.sections[index];
+        if (s.offset % 8 != 0 || s.offset > size ||
+            s.count > (size - s.offset) / elem_size)
+        {
+            std::cerr << "Section " << index << " is out of bounds"
+                      << std::endl;
+            fail("Invalid binary mesh");
+        }
+        return data + s.offset;
+    };
+    const auto expect_count = [&](int index, uint64_t count)
+    {
+        if (header.sections[index].count != count)
+        {
+            std::cerr << "Section " << index << " has "
+                      << header.sections[index].count << " elements, "
+                      << "expected " << count << std::endl;
+            fail("Invalid binary mesh");
+        }
+    };
+    // Offset arrays must start at 0 and end at the size of what they index.
+    const auto check_offsets = [&](const int32_t* offsets, int n,
+                                   int indexed_section)
+    {
+        if (offsets[0] != 0 ||
+            (uint64_t) offsets[n] != header.sections[indexed_section].count)
+        {
+            std::cerr << "Offsets into section " << indexed_section
+                      << " are inconsistent" << std::endl;
+            fail("Invalid binary mesh");
+        }
+    };
+    typedef BinaryMeshHeader H;
+    const int num_cells = header.grid_width * header.grid_height;
+
+    expect_count(H::VERTEX_POINTS, 2 * (uint64_t) V);
+    expect_count(H::VERTEX_FLAGS, V);
+    expect_count(H::VERTEX_POLY_OFFSETS, V + 1);
+    expect_count(H::POLY_OFFSETS, P + 1);
+    expect_count(H::POLY_NEIGHBOURS, header.sections[H::POLY_VERTICES].count);
+    expect_count(H::POLY_BOUNDS, 4 * (uint64_t) P);
+    expect_count(H::POLY_FLAGS, P);
+    expect_count(H::GRID_OFFSETS, num_cells + 1);
+
+    const double* vertex_points =
+        reinterpret_cast<const double*>(section(H::VERTEX_POINTS, 8));
+    const uint8_t* vertex_flags =
+        reinterpret_cast<const uint8_t*>(section(H::VERTEX_FLAGS, 1));
+    const int32_t* vertex_poly_offsets =
+        reinterpret_cast<const int32_t*>(section(H::VERTEX_POLY_OFFSETS, 4));
+    const int32_t* vertex_polys =
+        reinterpret_cast<const int32_t*>(section(H::VERTEX_POLYS, 4));
+    const int32_t* poly_offsets =
+        reinterpret_cast<const int32_t*>(section(H::POLY_OFFSETS, 4));
+    const int32_t* poly_vertices =
+        reinterpret_cast<const int32_t*>(section(H::POLY_VERTICES, 4));
+    const int32_t* poly_neighbours =
+        reinterpret_cast<const int32_t*>(section(H::POLY_NEIGHBOURS, 4));
+    const double* poly_bounds =
+        reinterpret_cast<const double*>(section(H::POLY_BOUNDS, 8));
+    const uint8_t* poly_flags =
+        reinterpret_cast<const uint8_t*>(section(H::POLY_FLAGS, 1));
+    const int32_t* cell_offsets =
+        reinterpret_cast<const int32_t*>(section(H::GRID_OFFSETS, 4));
+    const int32_t* cell_polys =
+        reinterpret_cast<const int32_t*>(section(H::GRID_POLYS, 4));
+
+    check_offsets(vertex_poly_offsets, V, H::VERTEX_POLYS);
+    check_offsets(poly_offsets, P, H::POLY_VERTICES);
+    check_offsets(cell_offsets, num_cells, H::GRID_POLYS);
+
+    // Everything is used straight out of the mapping.
+    // Only check what the search would trip over: bad sizes and indices.
+    for (int i = 0; i < V; i++)
+    {
+        if (vertex_poly_offsets[i + 1] - vertex_poly_offsets[i] < 2)
+        {
+            fail("Invalid number of neighbours around a point");
+        }
+    }
+    max_poly_sides = header.max_poly_sides;
+    for (int i = 0; i < P; i++)
+    {
+        const int n = poly_offsets[i + 1] - poly_offsets[i];
+        if (n < 3 || n > max_poly_sides)
+        {
+            fail("Invalid number of vertices in polygon");
+        }
+    }
+    const int num_poly_vertices = poly_offsets[P];
+    for (int j = 0; j < num_poly_vertices; j++)
+    {
+        if (poly_vertices[j] < 0 || poly_vertices[j] >= V)
+        {
+            fail("Invalid vertex index when getting polygon");
+        }
+        if (poly_neighbours[j] < -1 || poly_neighbours[j] >= P)
+        {
+            fail("Invalid polygon index when getting polygon");
+        }
+    }
+
+    mesh_vertices = {
+        V,
+        {reinterpret_cast<const Point*>(vertex_points), nullptr, nullptr, 1},
+        vertex_flags,
+        vertex_poly_offsets,
+        vertex_polys
+    };
+    mesh_polygons = {
+        P,
+        poly_offsets,
+        poly_vertices,
+        poly_neighbours,
+        reinterpret_cast<const PolygonBounds*>(poly_bounds),
+        poly_flags,
+        nullptr
+    };
+
+    min_x = header.min_x;
+    max_x = header.max_x;
+    min_y = header.min_y;
+    max_y = header.max_y;
+
+    pl_method = PointLocationMethod::GRID;
+    grid_width = header.grid_width;
+    grid_height = header.grid_height;
+    grid_cell_size = header.grid_cell_size;
+    grid_offsets = cell_offsets;
+    grid_polys = cell_polys;
+    #undef fail
+}
+
+void Mesh::write_binary(std::ostream& outfile) const
+{
+    assert(pl_method == PointLocationMethod::GRID);
+    assert(!is_weighted());
+    assert(!is_compact());
+    const int V = (int) mesh_vertices.size();
+    const int P = (int) mesh_polygons.size();
+    const int num_cells = grid_width * grid_height;
+
+    BinaryMeshHeader header;
+    std::memset(&header, 0, sizeof(header));
+    std::memcpy(header.magic, BINARY_MESH_MAGIC, sizeof(BINARY_MESH_MAGIC));
+    header.version = BINARY_MESH_VERSION;
+    header.byte_order = BINARY_MESH_BYTE_ORDER;
+    header.num_vertices = V;
+    header.num_polygons = P;
+    header.max_poly_sides = max_poly_sides;
+    header.grid_width = grid_width;
+    header.grid_height = grid_height;
+    header.min_x = min_x;
+    header.max_x = max_x;
+    header.min_y = min_y;
+    header.max_y = max_y;
+    header.grid_cell_size = grid_cell_size;
+
+    // Lay out the sections one after another, 8 byte aligned.
+    struct Chunk
+    {
+        const void* data;
+        uint64_t count;
+        uint64_t elem_size;
+    };
+    typedef BinaryMeshHeader H;
+    Chunk chunks[H::NUM_SECTIONS];
+    // The in-memory arrays are already laid out as the file expects.
+    const VertexArrays& vs = mesh_vertices;
+    const PolygonArrays& ps = mesh_polygons;
+    chunks[H::VERTEX_POINTS] = {vs.points.doubles, 2 * (uint64_t) V, 8};
+    chunks[H::VERTEX_FLAGS] = {vs.flags, (uint64_t) V, 1};
+    chunks[H::VERTEX_POLY_OFFSETS] = {vs.offsets, (uint64_t) V + 1, 4};
+    chunks[H::VERTEX_POLYS] = {vs.polygons, (uint64_t) vs.offsets[V], 4};
+    chunks[H::POLY_OFFSETS] = {ps.offsets, (uint64_t) P + 1, 4};
+    chunks[H::POLY_VERTICES] = {ps.vertices, (uint64_t) ps.offsets[P], 4};
+    chunks[H::POLY_NEIGHBOURS] = {ps.neighbours, (uint64_t) ps.offsets[P], 4};
+    chunks[H::POLY_BOUNDS] = {ps.bounds, 4 * (uint64_t) P, 8};
+    chunks[H::POLY_FLAGS] = {ps.flags, (uint64_t) P, 1};
+    chunks[H::GRID_OFFSETS] = {grid_offsets, (uint64_t) num_cells + 1, 4};
+    chunks[H::GRID_POLYS] =
+        {grid_polys, (uint64_t) grid_offsets[num_cells], 4};
+
+    uint64_t offset = sizeof(BinaryMeshHeader);
+    for (int i = 0; i < H::NUM_SECTIONS; i++)
+    {
+        offset = (offset + 7) & ~(uint64_t) 7;
+        header.sections[i] = {offset, chunks[i].count};
+        offset += chunks[i].count * chunks[i].elem_size;
+    }
+
+    outfile.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    uint64_t written = sizeof(BinaryMeshHeader);
+    const char zeros[8] = {0};
+    for (int i = 0; i < H::NUM_SECTIONS; i++)
+    {
+        outfile.write(zeros, header.sections[i].offset - written);
+        const uint64_t bytes = chunks[i].count * chunks[i].elem_size;
+        outfile.write(static_cast<const char*>(chunks[i].data), bytes);
+        written = header.sections[i].offset + bytes;
+    }
+}
+
+}
@@ -0,0 +1,55 @@
+#pragma once
+#include <stdint.h>
+
+namespace polyanya
+{
+
+// Layout of the binary mesh format. See utils/spec/mesh/binary.txt.
+// Every section starts on an 8 byte boundary so it can be used in place once
+// the file is memory mapped.
+
+const char BINARY_MESH_MAGIC[8] = {'p', 'o', 'l', 'y', 'm', 'e', 's', 'h'};
+const uint32_t BINARY_MESH_VERSION = 1;
+// Written as-is, so a file from a machine with another byte order is
+// detected instead of misread.
+const uint32_t BINARY_MESH_BYTE_ORDER = 0x01020304;
+
+struct BinaryMeshSection
+{
+    uint64_t offset; // in bytes, from the start of the file
+    uint64_t count;  // in elements
+};
+
+struct BinaryMeshHeader
+{
+    enum Section
+    {
+        VERTEX_POINTS,       // double[2V]: x, y
+        VERTEX_FLAGS,        // uint8[V]: VERTEX_CORNER | VERTEX_AMBIG
+        VERTEX_POLY_OFFSETS, // int32[V+1]
+        VERTEX_POLYS,        // int32[]
+        POLY_OFFSETS,        // int32[P+1], shared by vertices and neighbours
+        POLY_VERTICES,       // int32[]
+        POLY_NEIGHBOURS,     // int32[]
+        POLY_BOUNDS,         // double[4P]: min_x, max_x, min_y, max_y
+        POLY_FLAGS,          // uint8[P]: POLYGON_ONE_WAY
+        GRID_OFFSETS,        // int32[grid_width * grid_height + 1]
+        GRID_POLYS,          // int32[]
+        NUM_SECTIONS,
+    };
+
+    char magic[8];
+    uint32_t version;
+    uint32_t byte_order;
+    int32_t num_vertices;
+    int32_t num_polygons;
+    int32_t max_poly_sides;
+    int32_t grid_width;
+    int32_t grid_height;
+    int32_t padding;
+    double min_x, max_x, min_y, max_y;
+    double grid_cell_size;
+    BinaryMeshSection sections[NUM_SECTIONS];
+};
+
+}
@@ -0,0 +1,53 @@
+#pragma once
+#include <cassert>
+
+namespace polyanya
+{
+
+// A read-only view of a contiguous run of indices in one of a mesh's packed
+// arrays. Supports the subset of std::vector's interface the search uses.
+class IndexRange
+{
+    private:
+        const int* first;
+        int count;
+
+    public:
+        IndexRange() : first(nullptr), count(0) { }
+        IndexRange(const int* first, int count) : first(first), count(count)
+        { }
+
+        int size() const
+        {
+            return count;
+        }
+
+        bool empty() const
+        {
+            return count == 0;
+        }
+
+        int operator[](int i) const
+        {
+            assert(i >= 0 && i < count);
+            return first[i];
+        }
+
+        int back() const
+        {
+            assert(count > 0);
+            return first[count - 1];
+        }
+
+        const int* begin() const
+        {
+            return first;
+        }
+
+        const int* end() const
+        {
+            return first + count;
+        }
+};
+
+}
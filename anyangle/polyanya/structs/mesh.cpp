@@ -1,4 +1,5 @@
 #include "mesh.h"
+#include "geometry.h"
 #include <vector>
 #include <iostream>
 #include <map>
@@ -10,7 +11,8 @@
 namespace polyanya
 {
 
-Mesh::Mesh(std::istream& infile)
+Mesh::Mesh(std::istream& infile, PointLocationMethod method) :
+    pl_method(method), version(0)
 {
     read(infile);
     precalc_point_location();
@@ -20,25 +22,27 @@ void Mesh::read(std::istream& infile)
 {
     #define fail(message) std::cerr << message << std::endl; exit(1);
     std::string header;
-    int version;
+    int file_version;
 
     if (!(infile >> header))
     {
         fail("Error reading header");
     }
-    if (header != "mesh")
+    // A weighted mesh is a mesh with a weight after each polygon.
+    const bool weighted = header == "weighted_mesh";
+    if (header != "mesh" && !weighted)
     {
         std::cerr << "Got header '" << header << "'" << std::endl;
-        fail("Invalid header (expecting 'mesh')");
+        fail("Invalid header (expecting 'mesh' or 'weighted_mesh')");
     }
 
-    if (!(infile >> version))
+    if (!(infile >> file_version))
     {
         fail("Error getting version number");
     }
-    if (version != 2)
+    if (file_version != 2)
     {
-        std::cerr << "Got file with version " << version << std::endl;
+        std::cerr << "Got file with version " << file_version << std::endl;
         fail("Invalid version (expecting 2)");
     }
 
@@ -58,16 +62,31 @@ void Mesh::read(std::istream& infile)
         fail("Invalid number of polygons");
     }
 
-    mesh_vertices.resize(V);
-    mesh_polygons.resize(P);
+    mapped.reset();
+    vertex_points_storage.resize(V);
+    vertex_flags_storage.assign(V, 0);
+    vertex_offsets_storage.assign(1, 0);
+    vertex_polygons_storage.clear();
+    polygon_offsets_storage.assign(1, 0);
+    polygon_vertices_storage.clear();
+    polygon_neighbours_storage.clear();
+    polygon_bounds_storage.resize(P);
+    polygon_flags_storage.assign(P, 0);
+    polygon_weights_storage.clear();
+    min_weight = 1;
+    vertex_coords32_storage.clear();
+    vertex_coords16_storage.clear();
+    coord_unit = 1;
+    vertex_polygons_original.clear();
+    polygon_neighbours_original.clear();
+    version++;
 
 
     for (int i = 0; i < V; i++)
     {
-        Vertex& v = mesh_vertices[i];
-        v.is_corner = false;
-        v.is_ambig = false;
-        if (!(infile >> v.p.x >> v.p.y))
+        Point& point = vertex_points_storage[i];
+        uint8_t& flags = vertex_flags_storage[i];
+        if (!(infile >> point.x >> point.y))
         {
             fail("Error getting vertex point");
         }
@@ -81,7 +100,6 @@ void Mesh::read(std::istream& infile)
             std::cerr << "Got " << neighbours << " neighbours" << std::endl;
             fail("Invalid number of neighbours around a point");
         }
-        v.polygons.resize(neighbours);
         for (int j = 0; j < neighbours; j++)
         {
             int polygon_index;
@@ -95,29 +113,28 @@ void Mesh::read(std::istream& infile)
                           << polygon_index << std::endl;
                 fail("Invalid polygon index when getting vertex");
             }
-            v.polygons[j] = polygon_index;
+            vertex_polygons_storage.push_back(polygon_index);
             if (polygon_index == -1)
             {
-                if (v.is_corner)
+                if (flags & VERTEX_CORNER)
                 {
-                    if (!v.is_ambig)
-                    {
-                        v.is_ambig = true;
-                    }
+                    flags |= VERTEX_AMBIG;
                 }
                 else
                 {
-                    v.is_corner = true;
+                    flags |= VERTEX_CORNER;
                 }
             }
         }
+        vertex_offsets_storage.push_back(
+            (int) vertex_polygons_storage.size());
     }
 
 
     max_poly_sides = 0;
     for (int i = 0; i < P; i++)
     {
-        Polygon& p = mesh_polygons[i];
+        PolygonBounds& b = polygon_bounds_storage[i];
         int n;
         if (!(infile >> n))
         {
@@ -128,8 +145,6 @@ void Mesh::read(std::istream& infile)
             std::cerr << "Got " << n << " vertices" << std::endl;
             fail("Invalid number of vertices in polygon");
         }
-        p.vertices.resize(n);
-        p.polygons.resize(n);
         if (n > max_poly_sides)
         {
             max_poly_sides = n;
@@ -148,40 +163,40 @@ void Mesh::read(std::istream& infile)
                           << vertex_index << std::endl;
                 fail("Invalid vertex index when getting polygon");
             }
-            p.vertices[j] = vertex_index;
+            polygon_vertices_storage.push_back(vertex_index);
+            const Point& point = vertex_points_storage[vertex_index];
             if (j == 0)
             {
-                p.min_x = mesh_vertices[vertex_index].p.x;
-                p.min_y = mesh_vertices[vertex_index].p.y;
-                p.max_x = mesh_vertices[vertex_index].p.x;
-                p.max_y = mesh_vertices[vertex_index].p.y;
+                b.min_x = point.x;
+                b.min_y = point.y;
+                b.max_x = point.x;
+                b.max_y = point.y;
             }
             else
             {
-                p.min_x = std::min(p.min_x, mesh_vertices[vertex_index].p.x);
-                p.min_y = std::min(p.min_y, mesh_vertices[vertex_index].p.y);
-                p.max_x = std::max(p.max_x, mesh_vertices[vertex_index].p.x);
-                p.max_y = std::max(p.max_y, mesh_vertices[vertex_index].p.y);
+                b.min_x = std::min(b.min_x, point.x);
+                b.min_y = std::min(b.min_y, point.y);
+                b.max_x = std::max(b.max_x, point.x);
+                b.max_y = std::max(b.max_y, point.y);
             }
         }
         // mesh min/max
         if (i == 0)
         {
-            min_x = p.min_x;
-            min_y = p.min_y;
-            max_x = p.max_x;
-            max_y = p.max_y;
+            min_x = b.min_x;
+            min_y = b.min_y;
+            max_x = b.max_x;
+            max_y = b.max_y;
         }
         else
         {
-            min_x = std::min(min_x, p.min_x);
-            min_y = std::min(min_y, p.min_y);
-            max_x = std::max(max_x, p.max_x);
-            max_y = std::max(max_y, p.max_y);
+            min_x = std::min(min_x, b.min_x);
+            min_y = std::min(min_y, b.min_y);
+            max_x = std::max(max_x, b.max_x);
+            max_y = std::max(max_y, b.max_y);
         }
 
-        bool found_trav = false;
-        p.is_one_way = true;
+        int traversable = 0;
         for (int j = 0; j < n; j++)
         {
             int polygon_index;
@@ -197,21 +212,33 @@ void Mesh::read(std::istream& infile)
             }
             if (polygon_index != -1)
             {
-                if (found_trav)
-                {
-                    if (p.is_one_way)
-                    {
-                        p.is_one_way = false;
-                    }
-                }
-                else
-                {
-                    found_trav = true;
-                }
+                traversable++;
             }
-            p.polygons[j] = polygon_index;
+            polygon_neighbours_storage.push_back(polygon_index);
         }
+        if (traversable <= 1)
+        {
+            polygon_flags_storage[i] |= POLYGON_ONE_WAY;
+        }
+        if (weighted)
+        {
+            double weight;
+            if (!(infile >> weight))
+            {
+                fail("Error getting a polygon's weight");
+            }
+            if (!(weight > 0))
+            {
+                std::cerr << "Got a weight of " << weight << std::endl;
+                fail("Invalid polygon weight (expecting a positive number)");
+            }
+            min_weight = i == 0 ? weight : std::min(min_weight, weight);
+            polygon_weights_storage.push_back(weight);
+        }
+        polygon_offsets_storage.push_back(
+            (int) polygon_vertices_storage.size());
     }
+    use_storage();
 
     double temp;
     if (infile >> temp)
@@ -221,15 +248,67 @@ void Mesh::read(std::istream& infile)
     #undef fail
 }
 
+template<typename T>
+static const T* data_or_null(const std::vector<T>& v)
+{
+    return v.empty() ? nullptr : v.data();
+}
+
+void Mesh::use_storage()
+{
+    mesh_vertices = {
+        (int) vertex_flags_storage.size(),
+        {
+            data_or_null(vertex_points_storage),
+            data_or_null(vertex_coords32_storage),
+            data_or_null(vertex_coords16_storage),
+            coord_unit
+        },
+        vertex_flags_storage.data(),
+        vertex_offsets_storage.data(),
+        vertex_polygons_storage.data()
+    };
+    mesh_polygons = {
+        (int) polygon_flags_storage.size(),
+        polygon_offsets_storage.data(),
+        polygon_vertices_storage.data(),
+        polygon_neighbours_storage.data(),
+        data_or_null(polygon_bounds_storage),
+        polygon_flags_storage.data(),
+        polygon_weights_storage.empty() ? nullptr :
+                                          polygon_weights_storage.data()
+    };
+}
+
 void Mesh::precalc_point_location()
 {
-    for (Vertex& v : mesh_vertices)
+    switch (pl_method)
+    {
+        case PointLocationMethod::SLAB:
+            precalc_slab_point_location();
+            break;
+
+        case PointLocationMethod::GRID:
+            precalc_grid_point_location();
+            break;
+
+        default:
+            assert(false);
+            break;
+    }
+}
+
+void Mesh::precalc_slab_point_location()
+{
+    slabs.clear();
+    for (int i = 0; i < mesh_vertices.size(); i++)
     {
-        slabs[v.p.x] = std::vector<int>(0); // initialises the vector
+        // initialises the vector
+        slabs[mesh_vertices.points[i].x] = std::vector<int>(0);
     }
-    for (int i = 0; i < (int) mesh_polygons.size(); i++)
+    for (int i = 0; i < mesh_polygons.size(); i++)
     {
-        const Polygon& p = mesh_polygons[i];
+        const PolygonBounds p = get_bounds(i);
         const auto low_it = slabs.lower_bound(p.min_x);
         const auto high_it = slabs.upper_bound(p.max_x);
 
@@ -245,8 +324,8 @@ void Mesh::precalc_point_location()
             {
                 // Sorts based on the midpoints.
                 // If tied, sort based on width of poly.
-                const Polygon& ap = mesh_polygons[a];
-                const Polygon& bp = mesh_polygons[b];
+                const PolygonBounds ap = get_bounds(a);
+                const PolygonBounds bp = get_bounds(b);
                 const double as = ap.min_y + ap.max_y, bs = bp.min_y + ap.max_y;
                 if (as == bs) {
                     return (ap.max_y - ap.min_y) > (bp.max_y - bp.min_y);
@@ -257,8 +336,83 @@ void Mesh::precalc_point_location()
     }
 }
 
+void Mesh::precalc_grid_point_location()
+{
+    const int P = (int) mesh_polygons.size();
+    // Aim for roughly one cell per polygon, with square cells.
+    const double width = std::max(max_x - min_x, EPSILON);
+    const double height = std::max(max_y - min_y, EPSILON);
+    grid_cell_size = std::sqrt(width * height / P);
+    grid_width = std::max(1, (int) std::ceil(width / grid_cell_size));
+    grid_height = std::max(1, (int) std::ceil(height / grid_cell_size));
+
+    const auto cell_x = [&](double x) -> int
+    {
+        const int cx = (int) ((x - min_x) / grid_cell_size);
+        return std::max(0, std::min(grid_width - 1, cx));
+    };
+    const auto cell_y = [&](double y) -> int
+    {
+        const int cy = (int) ((y - min_y) / grid_cell_size);
+        return std::max(0, std::min(grid_height - 1, cy));
+    };
+
+    // Polygons are bucketed by their bounding box grown by EPSILON, as
+    // poly_contains_point accepts points up to EPSILON outside of it.
+    // Two passes: count, then fill, so the index ends up in two flat arrays.
+    // Polygons are visited in order, so every cell's list ends up sorted.
+    std::vector<int>& offsets = grid_offsets_storage;
+    std::vector<int>& polys = grid_polys_storage;
+    offsets.assign(grid_width * grid_height + 1, 0);
+    for (int pass = 0; pass < 2; pass++)
+    {
+        for (int i = 0; i < P; i++)
+        {
+            const PolygonBounds poly = get_bounds(i);
+            const int lo_x = cell_x(poly.min_x - EPSILON),
+                      hi_x = cell_x(poly.max_x + EPSILON),
+                      lo_y = cell_y(poly.min_y - EPSILON),
+                      hi_y = cell_y(poly.max_y + EPSILON);
+            for (int cy = lo_y; cy <= hi_y; cy++)
+            {
+                for (int cx = lo_x; cx <= hi_x; cx++)
+                {
+                    const int c = cy * grid_width + cx;
+                    if (pass == 0)
+                    {
+                        offsets[c + 1]++;
+                    }
+                    else
+                    {
+                        polys[offsets[c]++] = i;
+                    }
+                }
+            }
+        }
+        if (pass == 0)
+        {
+            for (int c = 0; c < grid_width * grid_height; c++)
+            {
+                offsets[c + 1] += offsets[c];
+            }
+            polys.resize(offsets.back());
+        }
+        else
+        {
+            // Filling moved every offset to the start of the next cell.
+            for (int c = grid_width * grid_height; c > 0; c--)
+            {
+                offsets[c] = offsets[c - 1];
+            }
+            offsets[0] = 0;
+        }
+    }
+    grid_offsets = offsets.data();
+    grid_polys = polys.data();
+}
+
 // Finds out whether the polygon specified by "poly" contains point P.
-PolyContainment Mesh::poly_contains_point(int poly, Point& p)
+PolyContainment Mesh::poly_contains_point(int poly, const Point& p) const
 {
     // The below is taken from
     // "An Efficient Test for a Point to Be in a Convex Polygon"
@@ -266,13 +420,32 @@ PolyContainment Mesh::poly_contains_point(int poly, Point& p)
     // demonstrations.wolfram.com/AnEfficientTestForAPointToBeInAConvexPolygon/
 
     // Assume points are in counterclockwise order.
-    const Polygon& poly_ref = mesh_polygons[poly];
+    const Polygon poly_ref = mesh_polygons[poly];
     if (p.x < poly_ref.min_x - EPSILON || p.x > poly_ref.max_x + EPSILON ||
         p.y < poly_ref.min_y - EPSILON || p.y > poly_ref.max_y + EPSILON)
     {
         return {PolyContainment::OUTSIDE, -1, -1, -1};
     }
-    const Point& last_point_in_poly = mesh_vertices[poly_ref.vertices.back()].p;
+    // Blocked polygons stay in the point location index, but are skipped.
+    if (mesh_polygons.flags[poly] & POLYGON_BLOCKED)
+    {
+        return {PolyContainment::OUTSIDE, -1, -1, -1};
+    }
+    if (is_compact())
+    {
+        // The unit is a power of two, so these are exact.
+        const double qx = p.x / coord_unit;
+        const double qy = p.y / coord_unit;
+        const double limit = 1 << 30;
+        if (qx == std::floor(qx) && qy == std::floor(qy) &&
+            std::abs(qx) < limit && std::abs(qy) < limit)
+        {
+            return poly_contains_point_exact(poly,
+                                             {(int64_t) qx, (int64_t) qy});
+        }
+    }
+    const Point& last_point_in_poly =
+        mesh_vertices.points[poly_ref.vertices.back()];
     const Point ZERO = {0, 0};
 
     Point last = last_point_in_poly - p;
@@ -285,7 +458,7 @@ PolyContainment Mesh::poly_contains_point(int poly, Point& p)
     for (int i = 0; i < (int) poly_ref.vertices.size(); i++)
     {
         const int point_index = poly_ref.vertices[i];
-        const Point cur = mesh_vertices[point_index].p - p;
+        const Point cur = mesh_vertices.points[point_index] - p;
         if (cur == ZERO)
         {
             return {PolyContainment::ON_VERTEX, -1, point_index, -1};
@@ -335,8 +508,300 @@ PolyContainment Mesh::poly_contains_point(int poly, Point& p)
     return {PolyContainment::INSIDE, -1, -1, -1};
 }
 
+PolyContainment Mesh::poly_contains_point_exact(int poly,
+                                                const IntPoint& p) const
+{
+    const VertexPoints& points = mesh_vertices.points;
+    const IndexRange vertices = mesh_polygons[poly].vertices;
+    const auto get_point = [&](int vertex) -> IntPoint
+    {
+        return {points.x(vertex), points.y(vertex)};
+    };
+
+    int last_index = vertices.back();
+    IntPoint last = get_point(last_index);
+    if (last == p)
+    {
+        return {PolyContainment::ON_VERTEX, -1, last_index, -1};
+    }
+    for (int i = 0; i < (int) vertices.size(); i++)
+    {
+        const int point_index = vertices[i];
+        const IntPoint cur = get_point(point_index);
+        if (cur == p)
+        {
+            return {PolyContainment::ON_VERTEX, -1, point_index, -1};
+        }
+        switch (get_orientation(p, last, cur))
+        {
+            case Orientation::CW:
+                // As in poly_contains_point, points are counterclockwise.
+                return {PolyContainment::OUTSIDE, -1, -1, -1};
+
+            case Orientation::COLLINEAR:
+                // On this edge if p is between last and cur. Otherwise the
+                // edge is collinear to an adjacent one.
+                if ((last.x - p.x) * (cur.x - p.x) +
+                    (last.y - p.y) * (cur.y - p.y) < 0)
+                {
+                    return {PolyContainment::ON_EDGE, mesh_polygons[poly].polygons[i],
+                            point_index, last_index};
+                }
+                break;
+
+            case Orientation::CCW:
+                break;
+        }
+        last = cur;
+        last_index = point_index;
+    }
+    return {PolyContainment::INSIDE, -1, -1, -1};
+}
+
+PolygonBounds Mesh::get_bounds(int poly) const
+{
+    if (mesh_polygons.bounds)
+    {
+        return mesh_polygons.bounds[poly];
+    }
+    const IndexRange vertices = mesh_polygons[poly].vertices;
+    const Point first = mesh_vertices.points[vertices[0]];
+    PolygonBounds b = {first.x, first.x, first.y, first.y};
+    for (int vertex : vertices)
+    {
+        const Point p = mesh_vertices.points[vertex];
+        b.min_x = std::min(b.min_x, p.x);
+        b.max_x = std::max(b.max_x, p.x);
+        b.min_y = std::min(b.min_y, p.y);
+        b.max_y = std::max(b.max_y, p.y);
+    }
+    return b;
+}
+
+bool Mesh::compact()
+{
+    if (mapped)
+    {
+        return false;
+    }
+    if (is_compact())
+    {
+        return true;
+    }
+    const int V = mesh_vertices.size();
+    const double limit = 1 << 30;
+    // Find the coarsest unit 2^-k which every coordinate is a multiple of.
+    int k = 0;
+    for (; k <= 16; k++)
+    {
+        const double scale = std::ldexp(1.0, k);
+        bool fits = true;
+        for (int i = 0; i < V && fits; i++)
+        {
+            const Point& p = vertex_points_storage[i];
+            const double qx = p.x * scale, qy = p.y * scale;
+            fits = qx == std::floor(qx) && qy == std::floor(qy) &&
+                   std::abs(qx) < limit && std::abs(qy) < limit;
+        }
+        if (fits)
+        {
+            break;
+        }
+    }
+    if (k > 16)
+    {
+        return false;
+    }
+    const double scale = std::ldexp(1.0, k);
+
+    // The grid index is built from the bounds, so build it before they go.
+    if (pl_method != PointLocationMethod::GRID)
+    {
+        pl_method = PointLocationMethod::GRID;
+        precalc_grid_point_location();
+    }
+    std::map<double, std::vector<int>>().swap(slabs);
+
+    bool small = true;
+    for (const Point& p : vertex_points_storage)
+    {
+        small = small && std::abs(p.x * scale) < 32768 &&
+                std::abs(p.y * scale) < 32768;
+    }
+    coord_unit = 1 / scale;
+    if (small)
+    {
+        vertex_coords16_storage.reserve(2 * V);
+    }
+    else
+    {
+        vertex_coords32_storage.reserve(2 * V);
+    }
+    for (const Point& p : vertex_points_storage)
+    {
+        if (small)
+        {
+            vertex_coords16_storage.push_back((int16_t) (p.x * scale));
+            vertex_coords16_storage.push_back((int16_t) (p.y * scale));
+        }
+        else
+        {
+            vertex_coords32_storage.push_back((int32_t) (p.x * scale));
+            vertex_coords32_storage.push_back((int32_t) (p.y * scale));
+        }
+    }
+    std::vector<Point>().swap(vertex_points_storage);
+    std::vector<PolygonBounds>().swap(polygon_bounds_storage);
+    // Reading leaves the arrays with room to grow, which they won't need.
+    vertex_flags_storage.shrink_to_fit();
+    vertex_offsets_storage.shrink_to_fit();
+    vertex_polygons_storage.shrink_to_fit();
+    polygon_offsets_storage.shrink_to_fit();
+    polygon_vertices_storage.shrink_to_fit();
+    polygon_neighbours_storage.shrink_to_fit();
+    polygon_flags_storage.shrink_to_fit();
+    polygon_weights_storage.shrink_to_fit();
+    vertex_polygons_original.shrink_to_fit();
+    polygon_neighbours_original.shrink_to_fit();
+    use_storage();
+    return true;
+}
+
+size_t Mesh::memory_usage() const
+{
+    size_t out = 0;
+    const auto add = [&](size_t count, size_t size)
+    {
+        out += count * size;
+    };
+    add(vertex_points_storage.capacity(), sizeof(Point));
+    add(vertex_coords32_storage.capacity(), sizeof(int32_t));
+    add(vertex_coords16_storage.capacity(), sizeof(int16_t));
+    add(vertex_flags_storage.capacity(), sizeof(uint8_t));
+    add(vertex_offsets_storage.capacity(), sizeof(int));
+    add(vertex_polygons_storage.capacity(), sizeof(int));
+    add(polygon_offsets_storage.capacity(), sizeof(int));
+    add(polygon_vertices_storage.capacity(), sizeof(int));
+    add(polygon_neighbours_storage.capacity(), sizeof(int));
+    add(polygon_bounds_storage.capacity(), sizeof(PolygonBounds));
+    add(polygon_flags_storage.capacity(), sizeof(uint8_t));
+    add(polygon_weights_storage.capacity(), sizeof(double));
+    add(vertex_polygons_original.capacity(), sizeof(int));
+    add(polygon_neighbours_original.capacity(), sizeof(int));
+    add(grid_offsets_storage.capacity(), sizeof(int));
+    add(grid_polys_storage.capacity(), sizeof(int));
+    for (const auto& slab : slabs)
+    {
+        // Roughly what a node of the map costs.
+        add(1, sizeof(slab) + 4 * sizeof(void*));
+        add(slab.second.capacity(), sizeof(int));
+    }
+    if (mapped)
+    {
+        add(mapped->size(), 1);
+    }
+    return out;
+}
+
+// Converts the result of poly_contains_point on a polygon which does not
+// have P outside of it to where P lies in the mesh.
+PointLocation Mesh::containment_to_location(
+    int polygon, const PolyContainment& result) const
+{
+    switch (result.type)
+    {
+        case PolyContainment::INSIDE:
+            // This one strictly contains the point.
+            return {PointLocation::IN_POLYGON, polygon, -1, -1, -1};
+
+        case PolyContainment::ON_EDGE:
+            // This one lies on the edge.
+            // Chek whether the other one is -1.
+            return {
+                (result.adjacent_poly == -1 ?
+                 PointLocation::ON_MESH_BORDER :
+                 PointLocation::ON_EDGE),
+                polygon, result.adjacent_poly,
+                result.vertex1, result.vertex2
+            };
+
+        case PolyContainment::ON_VERTEX:
+            // This one lies on a corner.
+        {
+            const Vertex v = mesh_vertices[result.vertex1];
+            if (v.is_corner)
+            {
+                if (v.is_ambig)
+                {
+                    return {PointLocation::ON_CORNER_VERTEX_AMBIG, -1, -1,
+                            result.vertex1, -1};
+                }
+                else
+                {
+                    return {PointLocation::ON_CORNER_VERTEX_UNAMBIG,
+                            polygon, -1, result.vertex1, -1};
+                }
+            }
+            else
+            {
+                return {PointLocation::ON_NON_CORNER_VERTEX,
+                        polygon, -1,
+                        result.vertex1, -1};
+            }
+        }
+
+        default:
+            // OUTSIDE should be handled by the caller.
+            assert(false);
+            return {PointLocation::NOT_ON_MESH, -1, -1, -1, -1};
+    }
+}
+
 // Finds where the point P lies in the mesh.
-PointLocation Mesh::get_point_location(Point& p)
+PointLocation Mesh::get_point_location(const Point& p) const
+{
+    switch (pl_method)
+    {
+        case PointLocationMethod::SLAB:
+            return get_point_location_slab(p);
+
+        case PointLocationMethod::GRID:
+            return get_point_location_grid(p);
+
+        default:
+            assert(false);
+            return get_point_location_naive(p);
+    }
+}
+
+PointLocation Mesh::get_point_location_grid(const Point& p) const
+{
+    if (p.x < min_x - EPSILON || p.x > max_x + EPSILON ||
+        p.y < min_y - EPSILON || p.y > max_y + EPSILON)
+    {
+        return {PointLocation::NOT_ON_MESH, -1, -1, -1, -1};
+    }
+    const int cx = std::max(0, std::min(grid_width - 1,
+                            (int) ((p.x - min_x) / grid_cell_size)));
+    const int cy = std::max(0, std::min(grid_height - 1,
+                            (int) ((p.y - min_y) / grid_cell_size)));
+    const int c = cy * grid_width + cx;
+    // The cell's polygons are sorted, so we return the same polygon as
+    // get_point_location_naive.
+    for (int i = grid_offsets[c]; i < grid_offsets[c + 1]; i++)
+    {
+        const int polygon = grid_polys[i];
+        const PolyContainment result = poly_contains_point(polygon, p);
+        if (result.type != PolyContainment::OUTSIDE)
+        {
+            return containment_to_location(polygon, result);
+        }
+    }
+    // Haven't returned yet, therefore P does not lie on the mesh.
+    return {PointLocation::NOT_ON_MESH, -1, -1, -1, -1};
+}
+
+PointLocation Mesh::get_point_location_slab(const Point& p) const
 {
     if (p.x < min_x - EPSILON || p.x > max_x + EPSILON ||
         p.y < min_y - EPSILON || p.y > max_y + EPSILON)
@@ -355,7 +820,7 @@ PointLocation Mesh::get_point_location(Point& p)
         {
             // Sorts based on the midpoints.
             // If tied, sort based on width of poly.
-            const Polygon& poly = mesh_polygons[poly_index];
+            const PolygonBounds poly = get_bounds(poly_index);
             return poly.min_y + poly.max_y < y_coord * 2;
         }
     );
@@ -373,55 +838,9 @@ PointLocation Mesh::get_point_location(Point& p)
     {
         const int polygon = polys[i];
         const PolyContainment result = poly_contains_point(polygon, p);
-        switch (result.type)
+        if (result.type != PolyContainment::OUTSIDE)
         {
-            case PolyContainment::OUTSIDE:
-                // Does not contain: try the next one.
-                break;
-
-            case PolyContainment::INSIDE:
-                // This one strictly contains the point.
-                return {PointLocation::IN_POLYGON, polygon, -1, -1, -1};
-
-            case PolyContainment::ON_EDGE:
-                // This one lies on the edge.
-                // Chek whether the other one is -1.
-                return {
-                    (result.adjacent_poly == -1 ?
-                     PointLocation::ON_MESH_BORDER :
-                     PointLocation::ON_EDGE),
-                    polygon, result.adjacent_poly,
-                    result.vertex1, result.vertex2
-                };
-
-            case PolyContainment::ON_VERTEX:
-                // This one lies on a corner.
-            {
-                const Vertex& v = mesh_vertices[result.vertex1];
-                if (v.is_corner)
-                {
-                    if (v.is_ambig)
-                    {
-                        return {PointLocation::ON_CORNER_VERTEX_AMBIG, -1, -1,
-                                result.vertex1, -1};
-                    }
-                    else
-                    {
-                        return {PointLocation::ON_CORNER_VERTEX_UNAMBIG,
-                                polygon, -1, result.vertex1, -1};
-                    }
-                }
-                else
-                {
-                    return {PointLocation::ON_NON_CORNER_VERTEX,
-                            polygon, -1,
-                            result.vertex1, -1};
-                }
-            }
-
-            default:
-                // This should not be reachable
-                assert(false);
+            return containment_to_location(polygon, result);
         }
 
 
@@ -455,64 +874,242 @@ PointLocation Mesh::get_point_location(Point& p)
     return {PointLocation::NOT_ON_MESH, -1, -1, -1, -1};
 }
 
-PointLocation Mesh::get_point_location_naive(Point& p)
+PointLocation Mesh::get_point_location_naive(const Point& p) const
 {
-    for (int polygon = 0; polygon < (int) mesh_polygons.size(); polygon++)
+    for (int polygon = 0; polygon < mesh_polygons.size(); polygon++)
     {
         const PolyContainment result = poly_contains_point(polygon, p);
-        switch (result.type)
+        if (result.type != PolyContainment::OUTSIDE)
         {
-            case PolyContainment::OUTSIDE:
-                // Does not contain: try the next one.
+            return containment_to_location(polygon, result);
+        }
+    }
+    // Haven't returned yet, therefore P does not lie on the mesh.
+    return {PointLocation::NOT_ON_MESH, -1, -1, -1, -1};
+}
+
+// Walks segment a-b across the mesh, starting from poly (which must contain
+// a), and returns whether it stays on the mesh the whole way.
+// This is conservative: a segment passing exactly through a vertex counts as
+// blocked.
+bool Mesh::is_visible(int poly, const Point& a, const Point& b) const
+{
+    return get_segment_cost(poly, a, b) >= 0;
+}
+
+double Mesh::get_segment_cost(int poly, const Point& a, const Point& b) const
+{
+    const Point ab = b - a;
+    const double length = std::sqrt(ab.x * ab.x + ab.y * ab.y);
+    const VertexPoints points = mesh_vertices.points;
+    int prev = -1;
+    // How far along a-b the walk has got, from 0 to 1.
+    double t = 0;
+    double cost = 0;
+    // Each step moves to another polygon, so this bounds the walk even if
+    // rounding sends it round in circles.
+    for (int step = 0; step < mesh_polygons.size() && poly != -1; step++)
+    {
+        if (poly_contains_point(poly, b).type != PolyContainment::OUTSIDE)
+        {
+            return cost + mesh_polygons.weight(poly) * (1 - t) * length;
+        }
+        // Find the edge the segment leaves through. As polygons are
+        // counterclockwise, edge V[i-1] -> V[i] has the polygon on its left.
+        const int first = mesh_polygons.offsets[poly];
+        const int* V = mesh_polygons.vertices + first;
+        const int* N = mesh_polygons.neighbours + first;
+        const int n = mesh_polygons.num_sides(poly);
+        int next = -2;
+        for (int i = 0; i < n; i++)
+        {
+            if (prev != -1 && N[i] == prev)
+            {
+                continue;
+            }
+            const Point& r = points[V[i ? i - 1 : n - 1]];
+            const Point& l = points[V[i]];
+            if ((l - r) * (b - r) > -EPSILON)
+            {
+                // b isn't past this edge.
+                continue;
+            }
+            const double cross_r = ab * (r - a);
+            const double cross_l = ab * (l - a);
+            if (std::abs(cross_r) < EPSILON || std::abs(cross_l) < EPSILON)
+            {
+                return -1;
+            }
+            if ((cross_r > 0) != (cross_l > 0))
+            {
+                next = N[i];
+                // Where a-b crosses the edge.
+                const double exit_t = ((r - a) * (l - r)) / (ab * (l - r));
+                const double clamped = std::max(t, std::min(1.0, exit_t));
+                cost += mesh_polygons.weight(poly) * (clamped - t) * length;
+                t = clamped;
                 break;
+            }
+        }
+        if (next == -2)
+        {
+            // Rounding trouble: a is not quite in poly.
+            return -1;
+        }
+        prev = poly;
+        poly = next;
+    }
+    return -1;
+}
 
-            case PolyContainment::INSIDE:
-                // This one strictly contains the point.
-                return {PointLocation::IN_POLYGON, polygon, -1, -1, -1};
-
-            case PolyContainment::ON_EDGE:
-                // This one lies on the edge.
-                // Chek whether the other one is -1.
-                return {
-                    (result.adjacent_poly == -1 ?
-                     PointLocation::ON_MESH_BORDER :
-                     PointLocation::ON_EDGE),
-                    polygon, result.adjacent_poly,
-                    result.vertex1, result.vertex2
-                };
-
-            case PolyContainment::ON_VERTEX:
-                // This one lies on a corner.
+void Mesh::make_mutable()
+{
+    if (mapped && polygon_flags_storage.empty())
+    {
+        // A mapped binary mesh is read-only, so copy what set_blocked()
+        // writes to. The point location grid stays in the mapping.
+        const VertexArrays& vs = mesh_vertices;
+        const PolygonArrays& ps = mesh_polygons;
+        const int V = vs.size();
+        const int P = ps.size();
+        vertex_points_storage.assign(vs.points.doubles,
+                                     vs.points.doubles + V);
+        vertex_flags_storage.assign(vs.flags, vs.flags + V);
+        vertex_offsets_storage.assign(vs.offsets, vs.offsets + V + 1);
+        vertex_polygons_storage.assign(vs.polygons,
+                                       vs.polygons + vs.offsets[V]);
+        polygon_offsets_storage.assign(ps.offsets, ps.offsets + P + 1);
+        polygon_vertices_storage.assign(ps.vertices,
+                                        ps.vertices + ps.offsets[P]);
+        polygon_neighbours_storage.assign(ps.neighbours,
+                                          ps.neighbours + ps.offsets[P]);
+        polygon_bounds_storage.assign(ps.bounds, ps.bounds + P);
+        polygon_flags_storage.assign(ps.flags, ps.flags + P);
+        use_storage();
+    }
+    if (polygon_neighbours_original.empty())
+    {
+        vertex_polygons_original = vertex_polygons_storage;
+        polygon_neighbours_original = polygon_neighbours_storage;
+    }
+}
+
+void Mesh::set_blocked(const std::vector<int>& polys, bool blocked)
+{
+    make_mutable();
+    std::vector<int> changed_polys, changed_vertices;
+    for (int poly : polys)
+    {
+        assert(poly >= 0 && poly < mesh_polygons.size());
+        if (is_blocked(poly) == blocked)
+        {
+            continue;
+        }
+        polygon_flags_storage[poly] ^= POLYGON_BLOCKED;
+        changed_polys.push_back(poly);
+        const int first = polygon_offsets_storage[poly];
+        const int last = polygon_offsets_storage[poly + 1];
+        for (int j = first; j < last; j++)
+        {
+            if (polygon_neighbours_original[j] != -1)
             {
-                const Vertex& v = mesh_vertices[result.vertex1];
-                if (v.is_corner)
-                {
-                    if (v.is_ambig)
-                    {
-                        return {PointLocation::ON_CORNER_VERTEX_AMBIG, -1, -1,
-                                result.vertex1, -1};
-                    }
-                    else
-                    {
-                        return {PointLocation::ON_CORNER_VERTEX_UNAMBIG,
-                                polygon, -1, result.vertex1, -1};
-                    }
-                }
-                else
-                {
-                    return {PointLocation::ON_NON_CORNER_VERTEX,
-                            polygon, -1,
-                            result.vertex1, -1};
-                }
+                changed_polys.push_back(polygon_neighbours_original[j]);
             }
+            changed_vertices.push_back(polygon_vertices_storage[j]);
+        }
+    }
+    if (changed_polys.empty())
+    {
+        return;
+    }
+    const auto sort_unique = [](std::vector<int>& v)
+    {
+        std::sort(v.begin(), v.end());
+        v.erase(std::unique(v.begin(), v.end()), v.end());
+    };
+    sort_unique(changed_polys);
+    sort_unique(changed_vertices);
+    for (int poly : changed_polys)
+    {
+        update_polygon(poly);
+    }
+    for (int vertex : changed_vertices)
+    {
+        update_vertex(vertex);
+    }
+    version++;
+}
 
-            default:
-                // This should not be reachable
-                assert(false);
+// Recomputes the neighbours and one-way flag of a polygon from its original
+// neighbours. Blocked polygons lose all their neighbours.
+void Mesh::update_polygon(int poly)
+{
+    const bool blocked = is_blocked(poly);
+    const int first = polygon_offsets_storage[poly];
+    const int last = polygon_offsets_storage[poly + 1];
+    int traversable = 0;
+    for (int j = first; j < last; j++)
+    {
+        const int neighbour = polygon_neighbours_original[j];
+        if (blocked || neighbour == -1 || is_blocked(neighbour))
+        {
+            polygon_neighbours_storage[j] = -1;
+        }
+        else
+        {
+            polygon_neighbours_storage[j] = neighbour;
+            traversable++;
         }
     }
-    // Haven't returned yet, therefore P does not lie on the mesh.
-    return {PointLocation::NOT_ON_MESH, -1, -1, -1, -1};
+    if (traversable <= 1)
+    {
+        polygon_flags_storage[poly] |= POLYGON_ONE_WAY;
+    }
+    else
+    {
+        polygon_flags_storage[poly] &= ~POLYGON_ONE_WAY;
+    }
+}
+
+// Recomputes the polygons around a vertex and its corner / ambiguous flags.
+void Mesh::update_vertex(int vertex)
+{
+    const int first = vertex_offsets_storage[vertex];
+    const int last = vertex_offsets_storage[vertex + 1];
+    for (int j = first; j < last; j++)
+    {
+        const int poly = vertex_polygons_original[j];
+        vertex_polygons_storage[j] =
+            (poly == -1 || is_blocked(poly)) ? -1 : poly;
+    }
+    // Blocking a polygon next to an obstacle leaves several -1s in a row,
+    // which is still just the one obstacle, so count runs of them.
+    int obstacles = 0;
+    int traversable = 0;
+    for (int j = first; j < last; j++)
+    {
+        const int prev = j == first ? last - 1 : j - 1;
+        if (vertex_polygons_storage[j] != -1)
+        {
+            traversable++;
+        }
+        else if (vertex_polygons_storage[prev] != -1)
+        {
+            obstacles++;
+        }
+    }
+    uint8_t& flags = vertex_flags_storage[vertex];
+    flags = 0;
+    if (traversable < last - first)
+    {
+        flags |= VERTEX_CORNER;
+    }
+    // A vertex with no traversable polygons left is unreachable anyway;
+    // treat it as ambiguous so point location doesn't pick a polygon.
+    if (obstacles >= 2 || traversable == 0)
+    {
+        flags |= VERTEX_AMBIG;
+    }
 }
 
 void Mesh::print(std::ostream& outfile)
@@ -520,23 +1117,25 @@ void Mesh::print(std::ostream& outfile)
     outfile << "mesh with " << mesh_vertices.size() << " vertices, " \
             << mesh_polygons.size() << " polygons" << std::endl;
     outfile << "vertices:" << std::endl;
-    for (Vertex vertex : mesh_vertices)
+    for (int i = 0; i < mesh_vertices.size(); i++)
     {
+        const Vertex vertex = mesh_vertices[i];
         outfile << vertex.p << " " << vertex.is_corner << std::endl;
     }
     outfile << std::endl;
     outfile << "polygons:" << std::endl;
-    for (Polygon polygon : mesh_polygons)
+    for (int i = 0; i < mesh_polygons.size(); i++)
     {
+        const Polygon polygon = mesh_polygons[i];
         for (int vertex : polygon.vertices)
         {
-            outfile << mesh_vertices[vertex].p << " ";
+            outfile << mesh_vertices.points[vertex] << " ";
         }
         outfile << std::endl;
     }
 }
 
-void Mesh::print_polygon(std::ostream& outfile, int index)
+void Mesh::print_polygon(std::ostream& outfile, int index) const
 {
     if (index == -1)
     {
@@ -544,8 +1143,7 @@ void Mesh::print_polygon(std::ostream& outfile, int index)
         return;
     }
     outfile << "P" << index << " [";
-    Polygon& poly = mesh_polygons[index];
-    const auto vertices = poly.vertices;
+    const IndexRange vertices = mesh_polygons[index].vertices;
     const int size = (int) vertices.size();
     for (int i = 0; i < size; i++)
     {
@@ -558,9 +1156,9 @@ void Mesh::print_polygon(std::ostream& outfile, int index)
     outfile << "]";
 }
 
-void Mesh::print_vertex(std::ostream& outfile, int index)
+void Mesh::print_vertex(std::ostream& outfile, int index) const
 {
-    outfile << "V" << index << " " <<  mesh_vertices[index].p;
+    outfile << "V" << index << " " <<  mesh_vertices.points[index];
 }
 
 }
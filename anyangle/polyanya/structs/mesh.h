@@ -1,10 +1,13 @@
 #pragma once
 #include "polygon.h"
 #include "vertex.h"
+#include "mappedfile.h"
+#include "geometry.h"
 #include <vector>
 #include <iostream>
 #include <map>
 #include <memory>
+#include <string>
 
 namespace polyanya
 {
@@ -195,29 +198,180 @@ struct PointLocation
     }
 };
 
+// Which index get_point_location uses.
+enum struct PointLocationMethod
+{
+    // Vertical slabs through every vertex, each holding the polygons which
+    // overlap it sorted by midpoint. Stored in a std::map.
+    SLAB,
+
+    // A flat uniform grid over the mesh's bounding box. Each cell holds the
+    // (sorted) ids of the polygons whose bounding box overlaps it.
+    GRID,
+};
+
 class Mesh
 {
     private:
+        PointLocationMethod pl_method;
         std::map<double, std::vector<int>> slabs;
         double min_x, max_x, min_y, max_y;
 
+        // Uniform grid index. The polygons of cell (cx, cy) are
+        // grid_polys[grid_offsets[c]] to grid_polys[grid_offsets[c+1]-1]
+        // where c = cy * grid_width + cx.
+        // The arrays point into either the storage vectors below or the
+        // mapped binary mesh file.
+        int grid_width, grid_height;
+        double grid_cell_size;
+        const int* grid_offsets;
+        const int* grid_polys;
+        std::vector<int> grid_offsets_storage;
+        std::vector<int> grid_polys_storage;
+
+        // Set if the mesh was read from a binary mesh file, in which case
+        // mesh_vertices and mesh_polygons point into the mapping.
+        std::unique_ptr<MappedFile> mapped;
+
+        // Otherwise they point into these.
+        std::vector<Point> vertex_points_storage;
+        std::vector<uint8_t> vertex_flags_storage;
+        std::vector<int> vertex_offsets_storage;
+        std::vector<int> vertex_polygons_storage;
+        std::vector<int> polygon_offsets_storage;
+        std::vector<int> polygon_vertices_storage;
+        std::vector<int> polygon_neighbours_storage;
+        std::vector<PolygonBounds> polygon_bounds_storage;
+        std::vector<uint8_t> polygon_flags_storage;
+        std::vector<double> polygon_weights_storage; // empty if unweighted
+        double min_weight;
+        // Used instead of vertex_points_storage (and polygon_bounds_storage)
+        // once the mesh is compacted.
+        std::vector<int32_t> vertex_coords32_storage;
+        std::vector<int16_t> vertex_coords16_storage;
+        double coord_unit;
+        void use_storage();
+
+        // Adjacency as read, before any polygons were blocked. Only filled
+        // in by the first call to set_blocked().
+        std::vector<int> vertex_polygons_original;
+        std::vector<int> polygon_neighbours_original;
+        int version;
+        void make_mutable();
+        void update_polygon(int poly);
+        void update_vertex(int vertex);
+
+        void precalc_slab_point_location();
+        void precalc_grid_point_location();
+        PointLocation get_point_location_slab(const Point& p) const;
+        PointLocation get_point_location_grid(const Point& p) const;
+        PointLocation containment_to_location(
+            int polygon, const PolyContainment& result) const;
+        PolygonBounds get_bounds(int poly) const;
+        // poly_contains_point for compacted meshes, when p is on the grid
+        // of coordinates they can store. This is exact.
+        PolyContainment poly_contains_point_exact(int poly,
+                                                  const IntPoint& p) const;
+
     public:
-        Mesh() { }
-        Mesh(std::istream& infile);
-        std::vector<Vertex> mesh_vertices;
-        std::vector<Polygon> mesh_polygons;
+        Mesh() : pl_method(PointLocationMethod::SLAB), min_weight(1),
+                 coord_unit(1), version(0), mesh_vertices(), mesh_polygons(),
+                 max_poly_sides(0) { }
+        Mesh(std::istream& infile,
+             PointLocationMethod method = PointLocationMethod::SLAB);
+        // Maps a binary mesh file (see utils/spec/mesh/binary.txt).
+        // Binary meshes always use the grid index stored in the file.
+        Mesh(const std::string& binary_filename);
+        // Not copyable, as the index may point into the mesh's own storage.
+        // Moving is fine: moved vectors keep their buffers.
+        Mesh(Mesh const &) = delete;
+        Mesh& operator=(Mesh const &) = delete;
+        Mesh(Mesh&&) = default;
+        Mesh& operator=(Mesh&&) = default;
+        // Packed arrays, read directly by the search. Indexing these gives a
+        // Vertex / Polygon view.
+        VertexArrays mesh_vertices;
+        PolygonArrays mesh_polygons;
         int max_poly_sides;
 
 
         void read(std::istream& infile);
+        void read_binary(const std::string& filename);
+        // Writes the mesh in the binary format. The mesh must use the grid
+        // index, as that is what gets stored.
+        void write_binary(std::ostream& outfile) const;
+        // Whether the file starts with the binary mesh header.
+        static bool is_binary_file(const std::string& filename);
+        // Builds the index used by get_point_location.
         void precalc_point_location();
+        // Shrinks the mesh, for meshes whose coordinates are all multiples
+        // of some 2^-k (such as meshes made from grids): the coordinates are
+        // stored as 16 or 32 bit integers in units of 2^-k, polygon bounds
+        // are dropped, and the point location index becomes the grid.
+        // Points on that grid are located with exact arithmetic.
+        // Returns false, leaving the mesh alone, if the coordinates don't
+        // fit or the mesh is a mapped binary mesh.
+        bool compact();
+        bool is_compact() const
+        {
+            return mesh_vertices.points.is_quantised();
+        }
+        // Bytes used by the mesh's arrays and point location index.
+        size_t memory_usage() const;
         void print(std::ostream& outfile);
-        PolyContainment poly_contains_point(int poly, Point& p);
-        PointLocation get_point_location(Point& p);
-        PointLocation get_point_location_naive(Point& p);
+        // The below are read-only, so a single Mesh can be shared between
+        // threads which each run their own SearchInstance.
+        PolyContainment poly_contains_point(int poly, const Point& p) const;
+        PointLocation get_point_location(const Point& p) const;
+        PointLocation get_point_location_naive(const Point& p) const;
+        bool is_visible(int poly, const Point& a, const Point& b) const;
+        // Like is_visible, but returns the weighted length of the segment
+        // (the sum of the length through each polygon times its weight), or
+        // -1 if it leaves the mesh.
+        double get_segment_cost(int poly, const Point& a,
+                                const Point& b) const;
+
+        // Whether the mesh was read as a weighted mesh (see
+        // utils/spec/mesh/weighted.txt). Otherwise every polygon has
+        // weight 1.
+        bool is_weighted() const
+        {
+            return mesh_polygons.weights != nullptr;
+        }
+        // The smallest weight of any polygon.
+        double get_min_weight() const
+        {
+            return min_weight;
+        }
+
+        PointLocationMethod get_point_location_method() const
+        {
+            return pl_method;
+        }
+
+        // Turns polygons into obstacles, or back again.
+        // Only the polygons, their neighbours and their vertices are
+        // updated, so this takes time proportional to the area changed; the
+        // point location index skips blocked polygons as it goes. This must
+        // not be called while a search is running on the mesh.
+        void set_blocked(const std::vector<int>& polys, bool blocked);
+        void set_blocked(int poly, bool blocked)
+        {
+            set_blocked(std::vector<int>(1, poly), blocked);
+        }
+        bool is_blocked(int poly) const
+        {
+            return (mesh_polygons.flags[poly] & POLYGON_BLOCKED) != 0;
+        }
+        // Changes whenever the mesh does, so that anything derived from it
+        // (like a PathCache) can tell when it is stale.
+        int get_version() const
+        {
+            return version;
+        }
 
-        void print_polygon(std::ostream& outfile, int index);
-        void print_vertex(std::ostream& outfile, int index);
+        void print_polygon(std::ostream& outfile, int index) const;
+        void print_vertex(std::ostream& outfile, int index) const;
 
 };
 
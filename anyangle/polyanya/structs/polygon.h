@@ -1,17 +1,82 @@
 #pragma once
-#include <vector>
+#include "indexrange.h"
+#include <stdint.h>
+#include <limits>
 
 namespace polyanya
 {
 
+const uint8_t POLYGON_ONE_WAY = 1;
+// An obstacle now, though it is still part of the mesh (see
+// Mesh::set_blocked).
+const uint8_t POLYGON_BLOCKED = 2;
+
+struct PolygonBounds
+{
+    double min_x, max_x, min_y, max_y;
+};
+
+// A view of one polygon of a mesh.
 struct Polygon
 {
     // "int" here means an array index.
-    std::vector<int> vertices;
-    std::vector<int> polygons;
-    std::vector<int> weights;
+    IndexRange vertices;
+    IndexRange polygons;
     bool is_one_way;
+    bool is_blocked;
+    double weight; // cost per unit of distance travelled through it
     double min_x, max_x, min_y, max_y;
 };
 
+// The polygons of a mesh, packed CSR-style.
+// The vertices and neighbouring polygons of polygon i are
+// vertices[offsets[i]] to vertices[offsets[i+1]-1] (and likewise for
+// neighbours).
+// The search reads these arrays directly; operator[] builds a Polygon view
+// for everything else.
+struct PolygonArrays
+{
+    int count;
+    const int* offsets;
+    const int* vertices;
+    const int* neighbours;
+    // nullptr for compacted meshes, whose Polygon views are unbounded.
+    const PolygonBounds* bounds;
+    const uint8_t* flags;
+    // nullptr unless the mesh was read as a weighted mesh.
+    const double* weights;
+
+    int size() const
+    {
+        return count;
+    }
+
+    int num_sides(int i) const
+    {
+        return offsets[i + 1] - offsets[i];
+    }
+
+    double weight(int i) const
+    {
+        return weights ? weights[i] : 1;
+    }
+
+    Polygon operator[](int i) const
+    {
+        assert(i >= 0 && i < count);
+        const int n = num_sides(i);
+        const double inf = std::numeric_limits<double>::infinity();
+        const PolygonBounds b = bounds ? bounds[i] :
+                                         PolygonBounds {-inf, inf, -inf, inf};
+        return {
+            IndexRange(vertices + offsets[i], n),
+            IndexRange(neighbours + offsets[i], n),
+            (flags[i] & POLYGON_ONE_WAY) != 0,
+            (flags[i] & POLYGON_BLOCKED) != 0,
+            weight(i),
+            b.min_x, b.max_x, b.min_y, b.max_y
+        };
+    }
+};
+
 }
@@ -1,19 +1,112 @@
 #pragma once
 #include "point.h"
-#include <vector>
+#include "indexrange.h"
+#include <stdint.h>
 
 namespace polyanya
 {
 
-// A point in the polygon mesh.
+const uint8_t VERTEX_CORNER = 1;
+const uint8_t VERTEX_AMBIG = 2;
+
+// A view of a point in the polygon mesh.
 struct Vertex
 {
     Point p;
     // "int" here means an array index.
-    std::vector<int> polygons;
+    IndexRange polygons;
 
     bool is_corner;
     bool is_ambig;
 };
 
+// The points of the vertices of a mesh. These are doubles, unless the mesh
+// has been compacted (see Mesh::compact), in which case they are integers in
+// units of unit, 16 bit if they fit and 32 bit otherwise.
+struct VertexPoints
+{
+    const Point* doubles;
+    const int32_t* coords32; // x, y pairs
+    const int16_t* coords16;
+    double unit;
+
+    Point operator[](int i) const
+    {
+        if (doubles)
+        {
+            return doubles[i];
+        }
+        if (coords16)
+        {
+            return {coords16[2 * i] * unit, coords16[2 * i + 1] * unit};
+        }
+        return {coords32[2 * i] * unit, coords32[2 * i + 1] * unit};
+    }
+
+    bool is_quantised() const
+    {
+        return doubles == nullptr;
+    }
+
+    // The coordinates of point i in units of unit, for quantised points.
+    int32_t x(int i) const
+    {
+        return coords16 ? coords16[2 * i] : coords32[2 * i];
+    }
+    int32_t y(int i) const
+    {
+        return coords16 ? coords16[2 * i + 1] : coords32[2 * i + 1];
+    }
+};
+
+// Quantised points of one width, as in VertexPoints. Code which reads many
+// points (such as get_successors) is specialised on this or on plain
+// doubles, rather than checking the representation on every read.
+template<typename Coord>
+struct QuantisedPoints
+{
+    const Coord* coords; // x, y pairs
+    double unit;
+
+    Point operator[](int i) const
+    {
+        return {coords[2 * i] * unit, coords[2 * i + 1] * unit};
+    }
+};
+
+// The vertices of a mesh, packed structure-of-arrays style.
+// The polygons around vertex i are polygons[offsets[i]] to
+// polygons[offsets[i+1]-1].
+// The search reads these arrays directly; operator[] builds a Vertex view
+// for everything else.
+struct VertexArrays
+{
+    int count;
+    VertexPoints points;
+    const uint8_t* flags;
+    const int* offsets;
+    const int* polygons;
+
+    int size() const
+    {
+        return count;
+    }
+
+    bool is_corner(int i) const
+    {
+        return flags[i] & VERTEX_CORNER;
+    }
+
+    Vertex operator[](int i) const
+    {
+        assert(i >= 0 && i < count);
+        return {
+            points[i],
+            IndexRange(polygons + offsets[i], offsets[i + 1] - offsets[i]),
+            (flags[i] & VERTEX_CORNER) != 0,
+            (flags[i] & VERTEX_AMBIG) != 0
+        };
+    }
+};
+
 }
@@ -2,16 +2,31 @@
 #include "expansion.h"
 #include "mesh.h"
 #include "geometry.h"
+#include "searchinstance.h"
+#include "queryservice.h"
+#include "batchfile.h"
+#include "weightedsearchinstance.h"
+#include "snellray.h"
 #include <stdio.h>
 #include <sstream>
+#include <fstream>
 #include <iomanip>
 #include <time.h>
 #include <random>
+#include <vector>
+#include <cmath>
+#include <algorithm>
 
 using namespace std;
 using namespace polyanya;
 
 Mesh m;
+// The same mesh using the uniform grid point location index.
+Mesh m_grid;
+// The same mesh again, with quantised coordinates.
+Mesh m_compact;
+// The text m was read from.
+string mesh_source;
 
 const int MIN_X = 0, MAX_X = 1024, MIN_Y = 0, MAX_Y = 768;
 const int MAX_ITER = 10000;
@@ -91,6 +106,545 @@ void test_point_lookup_correct()
     }
 }
 
+void test_grid_point_lookup_correct()
+{
+    cout << "Confirming that the grid point location index is correct" << endl;
+    for (int y = MIN_Y; y <= MAX_Y; y++)
+    {
+        for (int x = MIN_X; x <= MAX_X; x++)
+        {
+            Point test_point = {(double)x, (double)y};
+            PointLocation pl       = m_grid.get_point_location(test_point),
+                          pl_naive = m.get_point_location_naive(test_point);
+            if (pl != pl_naive)
+            {
+                cout << "Found discrepancy at " << test_point << endl;
+                cout << "Grid gives " << pl << endl;
+                cout << "Naive gives " << pl_naive << endl;
+            }
+        }
+    }
+}
+
+// Checks that quantising the coordinates changes neither point locations
+// (on and off the lattice) nor search costs.
+void test_compact_mesh()
+{
+    cout << "Confirming that the compact mesh gives the same results" << endl;
+    for (int y = MIN_Y; y <= MAX_Y; y++)
+    {
+        for (int x = MIN_X; x <= MAX_X; x++)
+        {
+            for (double offset : {0.0, 0.5})
+            {
+                Point test_point = {x + offset, y + offset};
+                PointLocation pl = m_compact.get_point_location(test_point),
+                    pl_naive = m.get_point_location_naive(test_point);
+                if (pl != pl_naive)
+                {
+                    cout << "Found discrepancy at " << test_point << endl;
+                    cout << "Compact gives " << pl << endl;
+                    cout << "Naive gives " << pl_naive << endl;
+                }
+            }
+        }
+    }
+
+    const int NUM_QUERIES = 1000;
+    uniform_real_distribution<double> unif_x(MIN_X, MAX_X);
+    uniform_real_distribution<double> unif_y(MIN_Y, MAX_Y);
+    SearchInstance si(&m), si_compact(&m_compact);
+    int mismatches = 0;
+    for (int i = 0; i < NUM_QUERIES; i++)
+    {
+        const Point start = {unif_x(engine), unif_y(engine)};
+        const Point goal = {(double) (int) unif_x(engine),
+                            (double) (int) unif_y(engine)};
+        si.set_start_goal(start, goal);
+        si_compact.set_start_goal(start, goal);
+        si.search();
+        si_compact.search();
+        if (std::abs(si.get_cost() - si_compact.get_cost()) > EPSILON)
+        {
+            mismatches++;
+        }
+    }
+    cout << mismatches << " of " << NUM_QUERIES << " searches on the "
+         << "compact mesh had a different cost." << endl;
+}
+
+// Compares the point location methods on the same set of random points
+// (half of them on integer coordinates, as scenarios on grid-derived meshes
+// are).
+void benchmark_point_lookup_methods()
+{
+    const int NUM_POINTS = 100000;
+    uniform_real_distribution<double> unif_x(MIN_X, MAX_X);
+    uniform_real_distribution<double> unif_y(MIN_Y, MAX_Y);
+    vector<Point> points(NUM_POINTS);
+    for (int i = 0; i < NUM_POINTS; i++)
+    {
+        points[i] = {unif_x(engine), unif_y(engine)};
+        if (i & 1)
+        {
+            points[i] = {floor(points[i].x), floor(points[i].y)};
+        }
+    }
+
+    const auto bench = [&](const char* name, const Mesh& mesh, bool naive)
+    {
+        int found = 0;
+        clock_t t = clock();
+        for (const Point& p : points)
+        {
+            const PointLocation pl = naive ?
+                mesh.get_point_location_naive(p) :
+                mesh.get_point_location(p);
+            found += pl.type != PointLocation::NOT_ON_MESH;
+        }
+        t = clock() - t;
+        const double average_micro =
+            (t/1.0/CLOCKS_PER_SEC * 1e6) / NUM_POINTS;
+        cout << setw(6) << name << setw(0) << " point lookup took "
+             << average_micro << "us on average (" << found << " on mesh)."
+             << endl;
+    };
+    bench("naive", m, true);
+    bench("slab", m, false);
+    bench("grid", m_grid, false);
+}
+
+// Runs the same random queries twice on one SearchInstance. The first pass
+// grows the node pool and open list to fit; the second should not allocate.
+void test_search_steady_state_allocations()
+{
+    const int NUM_QUERIES = 1000;
+    uniform_real_distribution<double> unif_x(MIN_X, MAX_X);
+    uniform_real_distribution<double> unif_y(MIN_Y, MAX_Y);
+    vector<Point> points(2 * NUM_QUERIES);
+    for (Point& p : points)
+    {
+        p = {unif_x(engine), unif_y(engine)};
+    }
+
+    SearchInstance si(&m);
+    int allocations[2] = {0, 0};
+    for (int pass = 0; pass < 2; pass++)
+    {
+        for (int i = 0; i < NUM_QUERIES; i++)
+        {
+            si.set_start_goal(points[2 * i], points[2 * i + 1]);
+            si.search();
+            allocations[pass] += si.get_allocations();
+        }
+    }
+    cout << "Searches allocated " << allocations[0] << " times on the first "
+         << "pass and " << allocations[1] << " times on the second." << endl;
+    if (allocations[1] != 0)
+    {
+        cout << "Expected no allocations on the second pass!" << endl;
+    }
+}
+
+// Checks that the stats (when built with POLYANYA_STATS) agree with the
+// search's own counters, and prints where the time went.
+void test_search_stats()
+{
+    if (!SearchStats::enabled)
+    {
+        cout << "Search stats are not compiled in." << endl;
+        return;
+    }
+    const int NUM_QUERIES = 1000;
+    uniform_real_distribution<double> unif_x(MIN_X, MAX_X);
+    uniform_real_distribution<double> unif_y(MIN_Y, MAX_Y);
+    SearchInstance si(&m);
+    long long successor_calls = 0, popped = 0;
+    for (int i = 0; i < NUM_QUERIES; i++)
+    {
+        si.set_start_goal({unif_x(engine), unif_y(engine)},
+                          {unif_x(engine), unif_y(engine)});
+        si.search();
+        successor_calls += si.successor_calls;
+        popped += si.nodes_popped;
+    }
+    const SearchStats stats = si.get_stats();
+    uint64_t total = 0;
+    for (int p = 0; p < SearchStats::NUM_PHASES; p++)
+    {
+        total += stats.cycles[p];
+    }
+    cout << "Search stats: " << stats.searches << " searches, "
+         << stats.calls[SearchStats::SUCCESSORS] << " successor calls, "
+         << stats.open_list_size.count << " pops";
+    for (int p = 0; p < SearchStats::NUM_PHASES; p++)
+    {
+        cout << ", " << SearchStats::phase_name(p) << " "
+             << setprecision(3) << 100.0 * stats.cycles[p] / total << "%";
+    }
+    cout << setprecision(6) << endl;
+    if (stats.searches != NUM_QUERIES ||
+        (long long) stats.calls[SearchStats::SUCCESSORS] != successor_calls ||
+        (long long) stats.successors.count != successor_calls ||
+        (long long) stats.open_list_size.count != popped)
+    {
+        cout << "Expected " << NUM_QUERIES << " searches, " << successor_calls
+             << " successor calls and " << popped << " pops!" << endl;
+    }
+}
+
+// Checks a distance table against one search per pair, and compares the
+// time taken.
+void test_distance_table()
+{
+    const int NUM_SOURCES = 10, NUM_TARGETS = 200;
+    uniform_real_distribution<double> unif_x(MIN_X, MAX_X);
+    uniform_real_distribution<double> unif_y(MIN_Y, MAX_Y);
+    vector<Point> sources(NUM_SOURCES), targets(NUM_TARGETS);
+    for (Point& p : sources)
+    {
+        p = {unif_x(engine), unif_y(engine)};
+    }
+    for (Point& p : targets)
+    {
+        p = {unif_x(engine), unif_y(engine)};
+    }
+
+    QueryService service(&m, 2);
+    vector<double> table;
+    service.run_table(sources, targets, table);
+    const double table_micro = service.get_batch_micro();
+
+    SearchInstance si(&m);
+    double pairs_micro = 0;
+    int mismatches = 0;
+    for (int i = 0; i < NUM_SOURCES; i++)
+    {
+        for (int j = 0; j < NUM_TARGETS; j++)
+        {
+            si.set_start_goal(sources[i], targets[j]);
+            si.search();
+            pairs_micro += si.get_search_micro();
+            const double expected = si.get_cost();
+            const double actual = table[i * NUM_TARGETS + j];
+            if (std::abs(expected - actual) > 1e-8)
+            {
+                if (mismatches++ < 5)
+                {
+                    cout << "Table gives " << actual << " from " << sources[i]
+                         << " to " << targets[j] << ", search gives "
+                         << expected << endl;
+                }
+            }
+        }
+    }
+    cout << "Distance table took " << table_micro << "us on 2 threads, "
+         << "one search per pair took " << pairs_micro << "us ("
+         << mismatches << " mismatches)." << endl;
+}
+
+// Streams the results of a threaded batch to a binary result file, and
+// checks that reading it back gives the same results as a normal batch.
+void test_batch_results()
+{
+    const int NUM_QUERIES = 500;
+    const string FILENAME = "test_batch_results.bin";
+    uniform_real_distribution<double> unif_x(MIN_X, MAX_X);
+    uniform_real_distribution<double> unif_y(MIN_Y, MAX_Y);
+    vector<Query> queries(NUM_QUERIES);
+    for (Query& q : queries)
+    {
+        q = {{unif_x(engine), unif_y(engine)}, {unif_x(engine), unif_y(engine)}};
+    }
+
+    QueryService service(&m, 2);
+    vector<QueryResult> expected;
+    service.run(queries, expected, true);
+
+    BatchResultWriter writer;
+    if (!writer.open(FILENAME, service.num_threads(), true))
+    {
+        cout << "Unable to open " << FILENAME << endl;
+        return;
+    }
+    service.run(queries, [&](int worker, int index, const QueryResult& r)
+    {
+        const BatchResultRecord record =
+        {
+            index, (int32_t) r.path.size(), r.cost, r.micro,
+            r.successor_calls, r.nodes_generated, r.nodes_pushed,
+            r.nodes_popped, r.nodes_pruned_post_pop, r.cache_hit
+        };
+        writer.write(worker, record, r.path.data());
+    }, true);
+    const bool written = writer.close();
+
+    BatchResultReader reader;
+    int num_read = 0, mismatches = 0;
+    vector<bool> seen(NUM_QUERIES);
+    BatchResultRecord record;
+    vector<Point> path;
+    if (written && reader.open(FILENAME))
+    {
+        while (reader.next(record, path))
+        {
+            num_read++;
+            const QueryResult& e = expected[record.index];
+            if (seen[record.index] || record.cost != e.cost ||
+                record.nodes_popped != e.nodes_popped || path != e.path)
+            {
+                mismatches++;
+            }
+            seen[record.index] = true;
+        }
+    }
+    remove(FILENAME.c_str());
+    cout << "Batch result file: " << num_read << " of " << NUM_QUERIES
+         << " results read back (" << mismatches << " mismatches)." << endl;
+}
+
+// Blocks random polygons, checks that paths avoid them, then unblocks them
+// and checks that the mesh and the search results are back to how they were.
+void test_block_polygons()
+{
+    const int NUM_QUERIES = 200;
+    uniform_real_distribution<double> unif_x(MIN_X, MAX_X);
+    uniform_real_distribution<double> unif_y(MIN_Y, MAX_Y);
+    vector<Point> points(2 * NUM_QUERIES);
+    for (Point& p : points)
+    {
+        p = {unif_x(engine), unif_y(engine)};
+    }
+    SearchInstance si(&m);
+    vector<double> costs(NUM_QUERIES);
+    for (int i = 0; i < NUM_QUERIES; i++)
+    {
+        si.set_start_goal(points[2 * i], points[2 * i + 1]);
+        si.search();
+        costs[i] = si.get_cost();
+    }
+    const int V = m.mesh_vertices.size();
+    const int P = m.mesh_polygons.size();
+    const vector<int> neighbours(m.mesh_polygons.neighbours,
+                                 m.mesh_polygons.neighbours +
+                                 m.mesh_polygons.offsets[P]);
+    const vector<int> vertex_polygons(m.mesh_vertices.polygons,
+                                      m.mesh_vertices.polygons +
+                                      m.mesh_vertices.offsets[V]);
+    const vector<uint8_t> vertex_flags(m.mesh_vertices.flags,
+                                       m.mesh_vertices.flags + V);
+    const vector<uint8_t> polygon_flags(m.mesh_polygons.flags,
+                                        m.mesh_polygons.flags + P);
+
+    vector<int> blocked;
+    uniform_int_distribution<int> unif_poly(0, P - 1);
+    for (int i = 0; i < P / 20 + 1; i++)
+    {
+        blocked.push_back(unif_poly(engine));
+    }
+    m.set_blocked(blocked, true);
+
+    int bad_locations = 0;
+    for (const Point& p : points)
+    {
+        bad_locations += m.get_point_location(p) !=
+                         m.get_point_location_naive(p);
+    }
+    int bad_paths = 0;
+    int cheaper = 0;
+    vector<Point> path;
+    for (int i = 0; i < NUM_QUERIES; i++)
+    {
+        si.set_start_goal(points[2 * i], points[2 * i + 1]);
+        if (!si.search())
+        {
+            continue;
+        }
+        cheaper += si.get_cost() < costs[i] - 1e-8;
+        si.get_path_points(path);
+        // Points inside blocked polygons are no longer on the mesh.
+        bool ok = true;
+        for (int j = 1; j < (int) path.size() && ok; j++)
+        {
+            for (int k = 1; k < 20; k++)
+            {
+                const Point p = get_point_on_line(path[j - 1], path[j],
+                                                  k / 20.0);
+                if (m.get_point_location(p).type ==
+                    PointLocation::NOT_ON_MESH)
+                {
+                    ok = false;
+                    break;
+                }
+            }
+        }
+        bad_paths += !ok;
+    }
+
+    m.set_blocked(blocked, false);
+    int changed = 0;
+    for (int i = 0; i < NUM_QUERIES; i++)
+    {
+        si.set_start_goal(points[2 * i], points[2 * i + 1]);
+        si.search();
+        changed += std::abs(si.get_cost() - costs[i]) > 1e-8;
+    }
+    const bool restored =
+        equal(neighbours.begin(), neighbours.end(),
+              m.mesh_polygons.neighbours) &&
+        equal(vertex_polygons.begin(), vertex_polygons.end(),
+              m.mesh_vertices.polygons) &&
+        equal(vertex_flags.begin(), vertex_flags.end(),
+              m.mesh_vertices.flags) &&
+        equal(polygon_flags.begin(), polygon_flags.end(),
+              m.mesh_polygons.flags);
+
+    cout << "Blocking " << blocked.size() << " polygons: "
+         << bad_locations << " bad point locations, " << bad_paths
+         << " paths through blocked polygons, " << cheaper
+         << " paths got cheaper. After unblocking: " << changed
+         << " costs changed, mesh " << (restored ? "" : "NOT ")
+         << "restored." << endl;
+}
+
+// Reading a mesh into a Mesh must change its version, so that a path cache
+// filled in on the old mesh is dropped rather than used on the new one.
+void test_mesh_reload()
+{
+    const int NUM_QUERIES = 50;
+    // The centres of random polygons, so every query is on the mesh.
+    const PolygonArrays& polygons = m.mesh_polygons;
+    uniform_int_distribution<int> unif_poly(0, polygons.size() - 1);
+    vector<Point> points(2 * NUM_QUERIES);
+    for (Point& p : points)
+    {
+        const int poly = unif_poly(engine);
+        p = {0, 0};
+        for (int j = polygons.offsets[poly]; j < polygons.offsets[poly + 1];
+             j++)
+        {
+            p = p + m.mesh_vertices.points[polygons.vertices[j]];
+        }
+        p = p * (1.0 / polygons.num_sides(poly));
+    }
+    Mesh reloaded;
+    {
+        stringstream mesh_text(mesh_source);
+        reloaded.read(mesh_text);
+        reloaded.precalc_point_location();
+    }
+    SearchInstance si(&reloaded);
+    si.enable_cache(2 * NUM_QUERIES);
+    for (int i = 0; i < NUM_QUERIES; i++)
+    {
+        si.set_start_goal(points[2 * i], points[2 * i + 1]);
+        si.search();
+    }
+    const size_t cached = si.get_cache()->size();
+
+    const int old_version = reloaded.get_version();
+    {
+        stringstream mesh_text(mesh_source);
+        reloaded.read(mesh_text);
+        reloaded.precalc_point_location();
+    }
+    // The first query on the new mesh has to search afresh, leaving only
+    // its own path in the cache.
+    si.get_cache()->reset_stats();
+    si.set_start_goal(points[0], points[1]);
+    si.search();
+    const int stale_hits = si.get_cache()->hits;
+    const size_t kept = si.get_cache()->size() - 1;
+    cout << "Reloading the mesh: version " << old_version << " -> "
+         << reloaded.get_version() << ", " << kept << " of " << cached
+         << " cached paths kept, " << stale_hits << " stale hits." << endl;
+    if (reloaded.get_version() == old_version || stale_hits != 0 ||
+        kept != 0)
+    {
+        cout << "!!! cached paths were kept across a mesh reload" << endl;
+    }
+}
+
+// With every weight 1 the weighted search has nothing to cross, so it must
+// agree with the usual one.
+void test_weighted_search()
+{
+    if (m.is_weighted())
+    {
+        cout << "Skipping the unit weight check on a weighted mesh." << endl;
+        return;
+    }
+    const int NUM_QUERIES = 200;
+    uniform_real_distribution<double> unif_x(MIN_X, MAX_X);
+    uniform_real_distribution<double> unif_y(MIN_Y, MAX_Y);
+    SearchInstance si(&m);
+    WeightedSearchInstance wsi(&m);
+    double micro = 0, weighted_micro = 0;
+    int mismatches = 0;
+    for (int i = 0; i < NUM_QUERIES; i++)
+    {
+        const Point s = {unif_x(engine), unif_y(engine)};
+        const Point g = {unif_x(engine), unif_y(engine)};
+        si.set_start_goal(s, g);
+        si.search();
+        micro += si.get_search_micro();
+        wsi.set_start_goal(s, g);
+        wsi.search();
+        weighted_micro += wsi.get_search_micro();
+        if (std::abs(si.get_cost() - wsi.get_cost()) > 1e-8)
+        {
+            if (mismatches++ < 5)
+            {
+                cout << "Weighted search gives " << wsi.get_cost()
+                     << " from " << s << " to " << g << ", search gives "
+                     << si.get_cost() << endl;
+            }
+        }
+    }
+    cout << "Weighted search with unit weights took " << weighted_micro
+         << "us, search took " << micro << "us (" << mismatches
+         << " mismatches)." << endl;
+}
+
+// Inside the edge, get_snell_point must obey w1 sin(a1) = w2 sin(a2).
+void test_snell_point()
+{
+    uniform_real_distribution<double> unif_w(1, 10);
+    int inside = 0, wrong = 0;
+    double worst = 0;
+    for (int i = 0; i < MAX_ITER; i++)
+    {
+        // A horizontal edge, with the start above it and the target below.
+        const Point r = {-10, 0}, l = {10, 0};
+        const Point s = {unif(engine), std::abs(unif(engine)) + 0.1};
+        const Point t = {unif(engine), -std::abs(unif(engine)) - 0.1};
+        const double ws = unif_w(engine), wt = unif_w(engine);
+        const Point p = get_snell_point(s, t, r, l, ws, wt);
+        if (p == r || p == l)
+        {
+            continue;
+        }
+        inside++;
+        // Snell's law, with the sines of the angles from the normal.
+        const double sin_s = (p.x - s.x) / s.distance(p);
+        const double sin_t = (t.x - p.x) / p.distance(t);
+        const double error = std::abs(ws * sin_s - wt * sin_t);
+        worst = max(worst, error);
+        if (error >= 1e-6)
+        {
+            if (wrong == 0)
+            {
+                cout << "!!! " << s << " to " << t << " with weights " << ws
+                     << " and " << wt << " crosses at " << p
+                     << ", off Snell's law by " << error << endl;
+            }
+            wrong++;
+        }
+    }
+    cout << "Snell points: " << wrong << " of " << inside
+         << " off Snell's law (worst by " << worst << ")." << endl;
+}
+
 void test_projection_asserts()
 {
     Point a, b, c, d;
@@ -130,9 +684,161 @@ void test_h_value_asserts()
     }
 }
 
+// Paths along edges between two weights, and goals on vertices and edges,
+// on a weighted mesh of arena made in strips (utils/bin/gridmap2rects
+// --weighted --strip 4 < utils/maps/arena.map). Each query must cost as
+// much both ways round.
+void test_weighted_edges()
+{
+    ifstream meshfile("weightedMeshes/arena-strips.mesh");
+    if (!meshfile.is_open())
+    {
+        cout << "Skipping the weighted edge check: run from the polyanya "
+             << "directory." << endl;
+        return;
+    }
+    Mesh weighted(meshfile);
+    WeightedSearchInstance wsi(&weighted);
+    const auto cost = [&](const Point& start, const Point& goal) -> double
+    {
+        wsi.set_start_goal(start, goal);
+        wsi.search();
+        return wsi.get_cost();
+    };
+
+    // Start, goal and cost.
+    const struct { Point start, goal; double cost; } known[] =
+    {
+        {{1, 12}, {1, 10}, 92},
+        {{1, 23}, {10, 8}, 828},
+        {{1, 23}, {14, 9}, 894.1980900709456},
+    };
+    int wrong = 0;
+    for (const auto& q : known)
+    {
+        if (std::abs(cost(q.start, q.goal) - q.cost) > 1e-6 ||
+            std::abs(cost(q.goal, q.start) - q.cost) > 1e-6)
+        {
+            cout << "!!! " << q.start << " to " << q.goal << " should cost "
+                 << setprecision(16) << q.cost << endl;
+            wrong++;
+        }
+    }
+
+    // Random vertices, which lie on edges between weights.
+    const int NUM_QUERIES = 500;
+    uniform_int_distribution<int> unif_vertex(
+        0, weighted.mesh_vertices.size() - 1);
+    int asymmetric = 0;
+    for (int i = 0; i < NUM_QUERIES; i++)
+    {
+        const Point& a = weighted.mesh_vertices.points[unif_vertex(engine)];
+        const Point& b = weighted.mesh_vertices.points[unif_vertex(engine)];
+        const double forward = cost(a, b);
+        const double backward = cost(b, a);
+        if (std::abs(forward - backward) > 1e-6 * (1 + forward))
+        {
+            if (asymmetric == 0)
+            {
+                cout << "!!! " << a << " to " << b << " costs "
+                     << setprecision(16) << forward << " but back costs "
+                     << backward << endl;
+            }
+            asymmetric++;
+        }
+    }
+    cout << "Weighted paths along edges: " << wrong << " of "
+         << sizeof(known) / sizeof(known[0]) << " known costs wrong, "
+         << asymmetric << " of " << NUM_QUERIES
+         << " queries cost more one way round." << endl;
+}
+
+// A weighted mesh made from a gridmap in strips has more polygons than one
+// made from the whole map, but the search must find paths of the same cost
+// on it. Both are of arena, from utils/bin/gridmap2rects --weighted, with
+// and without --strip 4. The paths aren't refined: that starts from
+// whichever of several equally cheap paths was found, so it can end up
+// with different costs.
+void test_weighted_strips()
+{
+    ifstream whole_file("weightedMeshes/arena-rects.mesh");
+    ifstream strip_file("weightedMeshes/arena-strips.mesh");
+    if (!whole_file.is_open() || !strip_file.is_open())
+    {
+        cout << "Skipping the weighted strip check: run from the polyanya "
+             << "directory." << endl;
+        return;
+    }
+    Mesh whole(whole_file), strips(strip_file);
+    WeightedSearchInstance whole_search(&whole), strip_search(&strips);
+    whole_search.set_refine_iterations(0);
+    strip_search.set_refine_iterations(0);
+
+    // Tile corners, which are vertices of one mesh or the other or on
+    // their edges, and points anywhere.
+    const int NUM_QUERIES = 500;
+    uniform_int_distribution<int> unif_corner(0, 49);
+    uniform_real_distribution<double> unif_coord(0, 49);
+    int differ = 0;
+    for (int i = 0; i < 2 * NUM_QUERIES; i++)
+    {
+        Point a, b;
+        if (i < NUM_QUERIES)
+        {
+            a = {(double) unif_corner(engine), (double) unif_corner(engine)};
+            b = {(double) unif_corner(engine), (double) unif_corner(engine)};
+        }
+        else
+        {
+            a = {unif_coord(engine), unif_coord(engine)};
+            b = {unif_coord(engine), unif_coord(engine)};
+        }
+        whole_search.set_start_goal(a, b);
+        whole_search.search();
+        strip_search.set_start_goal(a, b);
+        strip_search.search();
+        const double expected = whole_search.get_cost();
+        const double actual = strip_search.get_cost();
+        if (std::abs(expected - actual) > 1e-6 * (1 + std::abs(expected)))
+        {
+            if (differ == 0)
+            {
+                cout << "!!! " << a << " to " << b << " costs "
+                     << setprecision(16) << expected << " on the whole map "
+                     << "mesh but " << actual << " in strips" << endl;
+            }
+            differ++;
+        }
+    }
+    cout << "Weighted meshes made in strips: " << differ << " of "
+         << 2 * NUM_QUERIES << " queries cost something else." << endl;
+}
+
 int main(int argc, char* argv[])
 {
-    m = Mesh(cin);
+    {
+        // Keep the mesh around so we can build it twice.
+        stringstream mesh_text;
+        mesh_text << cin.rdbuf();
+        mesh_source = mesh_text.str();
+        m = Mesh(mesh_text);
+        mesh_text.clear();
+        mesh_text.seekg(0);
+        m_grid = Mesh(mesh_text, PointLocationMethod::GRID);
+        mesh_text.clear();
+        mesh_text.seekg(0);
+        m_compact = Mesh(mesh_text);
+    }
+    const size_t full_size = m_compact.memory_usage();
+    if (!m_compact.compact())
+    {
+        cout << "Unable to compact the mesh!" << endl;
+    }
+    else
+    {
+        cout << "Compacted the mesh from " << full_size << " to "
+             << m_compact.memory_usage() << " bytes" << endl;
+    }
     Point tp;
     if (argc == 3)
     {
@@ -148,10 +854,23 @@ int main(int argc, char* argv[])
     // test_io();
     // test_containment(tp);
     test_point_lookup_correct();
+    test_grid_point_lookup_correct();
+    test_compact_mesh();
     benchmark_point_lookup_average();
+    benchmark_point_lookup_methods();
     benchmark_point_lookup_single(tp);
+    test_search_steady_state_allocations();
+    test_search_stats();
+    test_distance_table();
+    test_batch_results();
+    test_weighted_search();
+    test_weighted_edges();
+    test_weighted_strips();
+    test_block_polygons();
+    test_mesh_reload();
     test_projection_asserts();
     test_reflection_asserts();
     test_h_value_asserts();
+    test_snell_point();
     return 0;
 }
@@ -0,0 +1,140 @@
+// Makes and reads the binary batch files of scenariorunner. See
+// spec/batch/binary.txt.
+#include "batchfile.h"
+#include "scenario.h"
+#include "point.h"
+#include <iostream>
+#include <fstream>
+#include <iomanip>
+#include <string>
+#include <vector>
+#include <algorithm>
+using namespace std;
+using namespace polyanya;
+
+int usage(const char* name)
+{
+    cerr << "usage: " << name << " pack <scenario> <queries>" << endl
+         << "       " << name << " dump <queries or results>" << endl;
+    return 1;
+}
+
+int pack(const string& scenario_filename, const string& queries_filename)
+{
+    ifstream scenfile(scenario_filename);
+    if (!scenfile.is_open())
+    {
+        cerr << "Unable to open scenarios" << endl;
+        return 1;
+    }
+    vector<Scenario> scenarios;
+    if (!load_scenarios(scenfile, scenarios))
+    {
+        return 1;
+    }
+    ofstream outfile(queries_filename, ios::out | ios::binary);
+    if (!outfile.is_open() || !write_batch_queries(outfile, scenarios))
+    {
+        cerr << "Error writing queries" << endl;
+        return 1;
+    }
+    return 0;
+}
+
+// Prints the queries as a scenario file, without the map details.
+int dump_queries(const string& filename)
+{
+    vector<Scenario> scenarios;
+    if (!load_batch_queries(filename, scenarios))
+    {
+        return 1;
+    }
+    cout << "version 1\n" << setprecision(16);
+    for (const Scenario& s : scenarios)
+    {
+        cout << "0\t-\t0\t0\t" << s.start.x << "\t" << s.start.y << "\t"
+             << s.goal.x << "\t" << s.goal.y << "\t" << s.gridcost << "\n";
+    }
+    return 0;
+}
+
+// Prints the results as scenariorunner does, in query order.
+int dump_results(const string& filename)
+{
+    BatchResultReader reader;
+    if (!reader.open(filename))
+    {
+        cerr << "Invalid batch file" << endl;
+        return 1;
+    }
+    struct Result
+    {
+        BatchResultRecord record;
+        vector<Point> path;
+    };
+    vector<Result> results(reader.size());
+    for (Result& r : results)
+    {
+        if (!reader.next(r.record, r.path))
+        {
+            cerr << "Results are truncated" << endl;
+            return 1;
+        }
+    }
+    sort(results.begin(), results.end(), [](const Result& a, const Result& b)
+    {
+        return a.record.index < b.record.index;
+    });
+
+    if (reader.has_paths())
+    {
+        for (const Result& r : results)
+        {
+            cout << "path " << r.record.index << ";";
+            for (const Point& p : r.path)
+            {
+                cout << " " << p;
+            }
+            cout << "\n";
+        }
+        return 0;
+    }
+    cout << "index;micro;successor_calls;generated;pushed;popped;"
+         << "pruned_post_pop;length;cache_hit\n";
+    for (const Result& r : results)
+    {
+        const BatchResultRecord& x = r.record;
+        cout << x.index << ";"
+             << x.micro << ";"
+             << x.successor_calls << ";"
+             << x.nodes_generated << ";"
+             << x.nodes_pushed << ";"
+             << x.nodes_popped << ";"
+             << x.nodes_pruned_post_pop << ";"
+             << setprecision(16) << x.cost << setprecision(6) << ";"
+             << x.cache_hit << "\n";
+    }
+    return 0;
+}
+
+int main(int argc, char* argv[])
+{
+    if (argc < 2)
+    {
+        return usage(argv[0]);
+    }
+    const string command = argv[1];
+    if (command == "pack" && argc == 4)
+    {
+        return pack(argv[2], argv[3]);
+    }
+    if (command == "dump" && argc == 3)
+    {
+        if (is_batch_queries_file(argv[2]))
+        {
+            return dump_queries(argv[2]);
+        }
+        return dump_results(argv[2]);
+    }
+    return usage(argv[0]);
+}
@@ -9,8 +9,21 @@ Area is the total area of the square, plus if you extend the square right/left.
 When we take a rectangle, mark all of the squares of that rectangle
 non-traversable and with the rectangle ID. Store that rectangle somewhere as
 well.
+
+With --weighted, the map is read as a weighted gridmap as in warthog: '@' is
+an obstacle and every other tile costs its ascii value. Rectangles are made
+for one kind of tile at a time, so each has a single weight, and the output is
+a weighted mesh (see spec/mesh/weighted.txt).
+
+With --strip or --threads, the map is converted in strips of rows instead:
+each strip gets its rectangles on its own (so none cross between strips),
+strips are converted by several threads at once, and the mesh is written as
+the strips are stitched together. Only the strips being converted and the
+rows on either side of each strip's borders are kept, never the whole grid.
 */
 #include <iostream>
+#include <sstream>
+#include <cstring>
 #include <string>
 #include <unordered_map>
 #include <vector>
@@ -18,6 +31,7 @@ well.
 #include <iomanip>
 #include <queue>
 #include <algorithm>
+#include <thread>
 
 using namespace std;
 
@@ -26,11 +40,18 @@ typedef vector<int> vint;
 
 
 // Everything here is [y][x]!
-vector<vbool> map_traversable;
+// The state of the conversion is thread_local, as each thread converts its
+// own strip of the map with it when converting in strips.
+thread_local vector<vbool> map_traversable;
+
+// Whether we read a weighted gridmap, and if so the tile at each cell
+// (0 for obstacles).
+bool weighted = false;
+thread_local vector<vint> map_tiles;
 
 // Length of longest line starting here going up.
-vector<vint> clear_above;
-vector<vint> clear_left;
+thread_local vector<vint> clear_above;
+thread_local vector<vint> clear_left;
 
 struct Rect
 {
@@ -70,14 +91,15 @@ struct SearchNode
 
 typedef vector<Rect> vrect;
 
-vector<vrect> grid_rectangles;
-vector<vint> rectangle_id;
-int cur_rect_id = 0;
+thread_local vector<vrect> grid_rectangles;
+thread_local vector<vint> rectangle_id;
+thread_local int cur_rect_id = 0;
 
 struct FinalRect
 {
     int y, x; // y, x of TOP-LEFT CORNER
     int width, height;
+    int weight;
 };
 
 struct Vertex
@@ -95,15 +117,15 @@ struct Vertex
     }
 };
 
-vector<FinalRect> final_rectangles;
+thread_local vector<FinalRect> final_rectangles;
 
 // [0][0] is top-left corner of map, [height][width] is bottom-right
-vector<vint> vertex_id;
-vector<Vertex> final_vertices;
-int cur_vertex_id = 0;
+thread_local vector<vint> vertex_id;
+thread_local vector<Vertex> final_vertices;
+thread_local int cur_vertex_id = 0;
 
-int map_width;
-int map_height;
+thread_local int map_width;
+thread_local int map_height;
 
 
 long long get_heuristic(int width, int height)
@@ -120,7 +142,7 @@ void fail(string msg)
     exit(1);
 }
 
-void read_map(istream& infile)
+void read_map_header(istream& infile)
 {
     // Most of this code is from dharabor's warthog.
     // read in the whole map. ensure that it is valid.
@@ -168,17 +190,60 @@ void read_map(istream& infile)
     {
         fail("err; map does not have 'map' keyword");
     }
+}
 
-
-    // basic checks passed. initialse the map
+void init_grid()
+{
     map_traversable = vector<vbool>(map_height, vbool(map_width));
     clear_above = vector<vint>(map_height, vint(map_width, 0));
     clear_left = vector<vint>(map_height, vint(map_width, 0));
+    map_tiles = vector<vint>(map_height, vint(map_width, 0));
     rectangle_id = vector<vint>(map_height, vint(map_width, -1));
     vertex_id = vector<vint>(map_height+1, vint(map_width+1, -1));
     grid_rectangles = vector<vrect>(map_height, vrect(map_width));
     // so to get (x, y), do map_traversable[y][x]
     // 0 is nontraversable, 1 is traversable
+    final_rectangles.clear();
+    final_vertices.clear();
+    cur_rect_id = 0;
+    cur_vertex_id = 0;
+}
+
+void set_cell(int y, int x, char c)
+{
+    if (weighted)
+    {
+        // Only '@' is an obstacle, as in warthog's weighted_gridmap.
+        map_tiles[y][x] = c == '@' ? 0 : (unsigned char) c;
+        map_traversable[y][x] = c != '@';
+    }
+    else switch (c)
+    {
+        case 'S':
+        case 'W':
+        case 'T':
+        case '@':
+        case 'O':
+            // obstacle
+            map_traversable[y][x] = 0;
+            break;
+        default:
+            // traversable
+            map_traversable[y][x] = 1;
+            break;
+    }
+}
+
+inline bool is_map_whitespace(char c)
+{
+    return c == ' ' || c == '\t' || c == '\n' || c == '\r';
+}
+
+void read_map(istream& infile)
+{
+    read_map_header(infile);
+    // basic checks passed. initialse the map
+    init_grid();
 
     // read in map_data
     int cur_y = 0;
@@ -187,7 +252,7 @@ void read_map(istream& infile)
     char c;
     while (infile.get(c))
     {
-        if (c == ' ' || c == '\t' || c == '\n' || c == '\r')
+        if (is_map_whitespace(c))
         {
             // whitespace.
             // cannot put in the switch statement below as we need to check
@@ -200,21 +265,7 @@ void read_map(istream& infile)
             fail("err; map has too many characters");
         }
 
-        switch (c)
-        {
-            case 'S':
-            case 'W':
-            case 'T':
-            case '@':
-            case 'O':
-                // obstacle
-                map_traversable[cur_y][cur_x] = 0;
-                break;
-            default:
-                // traversable
-                map_traversable[cur_y][cur_x] = 1;
-                break;
-        }
+        set_cell(cur_y, cur_x, c);
 
         cur_x++;
         if (cur_x == map_width)
@@ -419,7 +470,8 @@ void calculate_rectangles(int bottom_y, int bottom_x)
     }
 }
 
-void make_rectangles()
+// Takes rectangles out of the traversable cells, giving them all weight.
+void make_rectangles(int weight)
 {
     // Gets the best rectangle and takes that.
     // Repeat until there are no more rectangles.
@@ -488,171 +540,189 @@ void make_rectangles()
                 cur_vertex_id++;
             }
             // Push final rectangle.
-            final_rectangles.push_back({min_y, min_x, r.width, r.height});
+            final_rectangles.push_back({min_y, min_x, r.width, r.height,
+                                        weight});
         }
         cur_rect_id++;
     }
 }
 
-void print_mesh_vertices()
+// Prints the line of the mesh for the vertex at v.
+// cell(y, x) gives the id of the rectangle at a cell, or -1 if there is none
+// (including outside the map).
+template<typename CellId>
+void print_vertex(ostream& out, const Vertex& v, const CellId& cell)
 {
-    vector<int> temp;
-    temp.resize(4);
-    // For each vertex, print it out.
-    for (Vertex& v : final_vertices)
+    int temp[4];
+    out << v.x << " " << v.y;
+    // Now we get its neighbours.
+    // Remember that Vertices are {y, x}!
+    static const Vertex deltas[] = {
+        {-1, -1},
+        { 0, -1},
+        { 0,  0},
+        {-1,  0}
+    };
+
+    // Append all, then cull after.
+    for (int i = 0; i < 4; i++)
     {
-        cout << v.x << " " << v.y;
-        // Now we get its neighbours.
-        // Remember that Vertices are {y, x}!
-        static const Vertex deltas[] = {
-            {-1, -1},
-            { 0, -1},
-            { 0,  0},
-            {-1,  0}
-        };
+        Vertex grid_loc = v + deltas[i];
+        temp[i] = cell(grid_loc.y, grid_loc.x);
+    }
 
-        // Append all, then cull after.
+    // Cull.
+    vector<int> culled;
+    {
+        int last = temp[3];
         for (int i = 0; i < 4; i++)
         {
-            Vertex grid_loc = v + deltas[i];
-            if (grid_loc.x < 0 || grid_loc.x >= map_width ||
-                grid_loc.y < 0 || grid_loc.y >= map_height)
-            {
-                temp[i] = -1;
-            }
-            else
+            const int cur = temp[i];
+            if (cur != last)
             {
-                temp[i] = rectangle_id[grid_loc.y][grid_loc.x];
-            }
-        }
-
-        // Cull.
-        vector<int> out;
-        {
-            int last = temp[3];
-            for (int i = 0; i < 4; i++)
-            {
-                const int cur = temp[i];
-                if (cur != last)
-                {
-                    out.push_back(cur);
-                }
-                last = cur;
+                culled.push_back(cur);
             }
+            last = cur;
         }
+    }
 
-        // Print.
-        cout << " " << out.size();
-        for (int poly : out)
-        {
-            cout << " " << poly;
-        }
-        cout << "\n";
+    // Print.
+    out << " " << culled.size();
+    for (int poly : culled)
+    {
+        out << " " << poly;
     }
+    out << "\n";
 }
 
-void print_mesh_polygons()
+// Prints the line of the mesh for the rectangle r.
+// vertex(y, x) gives the id of the vertex at a point, or -1 if it isn't one,
+// and cell(y, x) is as in print_vertex.
+template<typename VertexId, typename CellId>
+void print_polygon(ostream& out, const FinalRect& r, const VertexId& vertex,
+                   const CellId& cell)
 {
-    for (FinalRect& r : final_rectangles)
-    {
-        /*
-        Iterate over vertices which lie on the rectangle in this order:
+    /*
+    Iterate over vertices which lie on the rectangle in this order:
 
-        16 15 14 13
-        01       12
-        02       11
-        03       10
-        04       09
-        05 06 07 08
-        */
+    16 15 14 13
+    01       12
+    02       11
+    03       10
+    04       09
+    05 06 07 08
+    */
 
-        assert(r.width  >= 1);
-        assert(r.height >= 1);
+    assert(r.width  >= 1);
+    assert(r.height >= 1);
 
-        vector<int> vertices;
-        vector<int> polygons;
+    vector<int> vertices;
+    vector<int> polygons;
 
-        auto push_vertex = [&](int y, int x, int dy, int dx)
+    auto push_vertex = [&](int y, int x, int dy, int dx)
+    {
+        // Assume that the coordianates we get are always valid.
+        const int v = vertex(y, x);
+        if (v == -1)
         {
-            // Assume that the coordianates we get are always valid.
-            const int vertex = vertex_id[y][x];
-            if (vertex == -1)
-            {
-                return;
-            }
-            vertices.push_back(vertex);
-            // Use dy and dx to get the grid location of the neighbours.
-            const int grid_loc_y = y + dy;
-            const int grid_loc_x = x + dx;
-            if (grid_loc_x < 0 || grid_loc_x >= map_width ||
-                grid_loc_y < 0 || grid_loc_y >= map_height)
-            {
-                polygons.push_back(-1);
-            }
-            else
-            {
-                polygons.push_back(rectangle_id[grid_loc_y][grid_loc_x]);
-            }
-        };
+            return;
+        }
+        vertices.push_back(v);
+        // Use dy and dx to get the grid location of the neighbours.
+        polygons.push_back(cell(y + dy, x + dx));
+    };
 
-        // Go through "01-05".
+    // Go through "01-05".
+    {
+        const int x = r.x;
+        for (int y = r.y + 1; y <= r.y + r.height; y++)
         {
-            const int x = r.x;
-            for (int y = r.y + 1; y <= r.y + r.height; y++)
-            {
-                // dy = -1, dx = -1
-                push_vertex(y, x, -1, -1);
-            }
+            // dy = -1, dx = -1
+            push_vertex(y, x, -1, -1);
         }
+    }
 
-        // Go through "06-08".
+    // Go through "06-08".
+    {
+        const int y = r.y + r.height;
+        for (int x = r.x + 1; x <= r.x + r.width; x++)
         {
-            const int y = r.y + r.height;
-            for (int x = r.x + 1; x <= r.x + r.width; x++)
-            {
-                // dy = 0, dx = -1
-                push_vertex(y, x, 0, -1);
-            }
+            // dy = 0, dx = -1
+            push_vertex(y, x, 0, -1);
         }
+    }
 
-        // Go through "09-13".
+    // Go through "09-13".
+    {
+        const int x = r.x + r.width;
+        for (int y = r.y + r.height - 1; y >= r.y; y--)
         {
-            const int x = r.x + r.width;
-            for (int y = r.y + r.height - 1; y >= r.y; y--)
-            {
-                // dy = 0, dx = 0
-                push_vertex(y, x, 0, 0);
-            }
+            // dy = 0, dx = 0
+            push_vertex(y, x, 0, 0);
         }
+    }
 
-        // Go through "14-16".
+    // Go through "14-16".
+    {
+        const int y = r.y;
+        for (int x = r.x + r.width - 1; x >= r.x; x--)
         {
-            const int y = r.y;
-            for (int x = r.x + r.width - 1; x >= r.x; x--)
-            {
-                // dy = -1, dx = 0
-                push_vertex(y, x, -1, 0);
-            }
+            // dy = -1, dx = 0
+            push_vertex(y, x, -1, 0);
         }
+    }
 
-        // Reverse because orientations are mixed up
-        reverse(vertices.begin(), vertices.end());
-        reverse(polygons.begin(), polygons.end());
-        // and fix up the broken polygons
-        rotate(polygons.begin(), polygons.end()-1, polygons.end());
+    // Reverse because orientations are mixed up
+    reverse(vertices.begin(), vertices.end());
+    reverse(polygons.begin(), polygons.end());
+    // and fix up the broken polygons
+    rotate(polygons.begin(), polygons.end()-1, polygons.end());
 
-        cout << vertices.size();
+    out << vertices.size();
 
-        for (int v : vertices)
-        {
-            cout << " " << v;
-        }
+    for (int v : vertices)
+    {
+        out << " " << v;
+    }
 
-        for (int p : polygons)
-        {
-            cout << " " << p;
-        }
-        cout << "\n";
+    for (int p : polygons)
+    {
+        out << " " << p;
+    }
+    if (weighted)
+    {
+        out << " " << r.weight;
+    }
+    out << "\n";
+}
+
+int get_rectangle_id(int y, int x)
+{
+    if (x < 0 || x >= map_width || y < 0 || y >= map_height)
+    {
+        return -1;
+    }
+    return rectangle_id[y][x];
+}
+
+void print_mesh_vertices()
+{
+    // For each vertex, print it out.
+    for (Vertex& v : final_vertices)
+    {
+        print_vertex(cout, v, get_rectangle_id);
+    }
+}
+
+void print_mesh_polygons()
+{
+    const auto get_vertex_id = [](int y, int x)
+    {
+        return vertex_id[y][x];
+    };
+    for (FinalRect& r : final_rectangles)
+    {
+        print_polygon(cout, r, get_vertex_id, get_rectangle_id);
     }
 }
 
@@ -794,8 +864,357 @@ void print_traversable()
     }
 }
 
-int main()
+void make_weighted_rectangles()
 {
+    // Make the rectangles of each kind of tile in turn.
+    vector<bool> seen(256);
+    for (int y = 0; y < map_height; y++)
+    {
+        for (int x = 0; x < map_width; x++)
+        {
+            const int tile = map_tiles[y][x];
+            if (tile == 0 || seen[tile])
+            {
+                continue;
+            }
+            seen[tile] = true;
+            for (int ty = 0; ty < map_height; ty++)
+            {
+                for (int tx = 0; tx < map_width; tx++)
+                {
+                    map_traversable[ty][tx] = map_tiles[ty][tx] == tile;
+                }
+            }
+            make_rectangles(tile);
+        }
+    }
+}
+
+// Converting in strips.
+// A strip keeps its rectangles and what the strips next to it need to know
+// about its borders. Rectangle ids are local to the strip until the mesh is
+// written, when they are offset by first_rect.
+struct Strip
+{
+    int y0, rows;
+    vector<FinalRect> rects; // with y in the map's coordinates
+    // Rectangle ids of the first and last rows.
+    vint top_ids, bottom_ids;
+    // Rectangle corners on the lines y0 and y0 + rows.
+    vbool top_corners, bottom_corners;
+    // Number of vertices on the lines in between.
+    int inner_vertices;
+    int first_rect, first_vertex;
+};
+
+// Reads the next n cells of the map into cells, ignoring whitespace.
+void read_cells(istream& infile, string& cells, int n)
+{
+    cells.resize(n);
+    char c;
+    int i = 0;
+    while (i < n && infile.get(c))
+    {
+        if (!is_map_whitespace(c))
+        {
+            cells[i++] = c;
+        }
+    }
+    if (i != n)
+    {
+        fail("err; map has too few characters");
+    }
+}
+
+// Makes the rectangles of the strip, given its cells row by row.
+void convert_strip(Strip& strip, const string& cells, int width)
+{
+    map_width = width;
+    map_height = strip.rows;
+    init_grid();
+    for (int y = 0; y < map_height; y++)
+    {
+        for (int x = 0; x < map_width; x++)
+        {
+            set_cell(y, x, cells[(size_t) y * map_width + x]);
+        }
+    }
+    if (weighted)
+    {
+        make_weighted_rectangles();
+    }
+    else
+    {
+        make_rectangles(1);
+    }
+
+    strip.rects = final_rectangles;
+    for (FinalRect& r : strip.rects)
+    {
+        r.y += strip.y0;
+    }
+    strip.top_ids = rectangle_id[0];
+    strip.bottom_ids = rectangle_id[map_height - 1];
+    strip.top_corners = vbool(map_width + 1);
+    strip.bottom_corners = vbool(map_width + 1);
+    strip.inner_vertices = 0;
+    for (int x = 0; x <= map_width; x++)
+    {
+        strip.top_corners[x] = vertex_id[0][x] != -1;
+        strip.bottom_corners[x] = vertex_id[map_height][x] != -1;
+        for (int y = 1; y < map_height; y++)
+        {
+            strip.inner_vertices += vertex_id[y][x] != -1;
+        }
+    }
+}
+
+// Writes the vertex lines (or the polygon lines) of strips[i] to out.
+// The vertices on the line between two strips belong to the lower one.
+void print_strip(ostream& out, const vector<Strip>& strips, int i, int width,
+                 int height, bool polygons)
+{
+    const Strip& strip = strips[i];
+    const Strip* above = i > 0 ? &strips[i - 1] : nullptr;
+    const Strip* below = i + 1 < (int) strips.size() ? &strips[i + 1] : nullptr;
+
+    // Rectangle ids of the strip's cells and the rows either side of it.
+    vector<vint> ids(strip.rows + 2, vint(width, -1));
+    for (int x = 0; x < width; x++)
+    {
+        if (above && above->bottom_ids[x] != -1)
+        {
+            ids[0][x] = above->first_rect + above->bottom_ids[x];
+        }
+        if (below && below->top_ids[x] != -1)
+        {
+            ids[strip.rows + 1][x] = below->first_rect + below->top_ids[x];
+        }
+    }
+    for (int id = 0; id < (int) strip.rects.size(); id++)
+    {
+        const FinalRect& r = strip.rects[id];
+        for (int y = r.y; y < r.y + r.height; y++)
+        {
+            for (int x = r.x; x < r.x + r.width; x++)
+            {
+                ids[y - strip.y0 + 1][x] = strip.first_rect + id;
+            }
+        }
+    }
+
+    // Vertex ids on the lines y0 to y0 + rows, numbered in order along each
+    // line, as they are printed.
+    vector<vint> vertex_ids(strip.rows + 1, vint(width + 1, -1));
+    for (const FinalRect& r : strip.rects)
+    {
+        const int y = r.y - strip.y0;
+        vertex_ids[y][r.x] = vertex_ids[y][r.x + r.width] = 0;
+        vertex_ids[y + r.height][r.x] =
+            vertex_ids[y + r.height][r.x + r.width] = 0;
+    }
+    for (int x = 0; x <= width; x++)
+    {
+        if (above && above->bottom_corners[x])
+        {
+            vertex_ids[0][x] = 0;
+        }
+        if (below && below->top_corners[x])
+        {
+            vertex_ids[strip.rows][x] = 0;
+        }
+    }
+    int next_vertex = strip.first_vertex;
+    for (vint& line : vertex_ids)
+    {
+        for (int& id : line)
+        {
+            if (id != -1)
+            {
+                id = next_vertex++;
+            }
+        }
+    }
+
+    const auto get_cell = [&](int y, int x)
+    {
+        if (x < 0 || x >= width || y < 0 || y >= height)
+        {
+            return -1;
+        }
+        return ids[y - strip.y0 + 1][x];
+    };
+    if (polygons)
+    {
+        const auto get_vertex = [&](int y, int x)
+        {
+            return vertex_ids[y - strip.y0][x];
+        };
+        for (const FinalRect& r : strip.rects)
+        {
+            print_polygon(out, r, get_vertex, get_cell);
+        }
+        return;
+    }
+    const int last_line = below ? strip.rows - 1 : strip.rows;
+    for (int y = 0; y <= last_line; y++)
+    {
+        for (int x = 0; x <= width; x++)
+        {
+            if (vertex_ids[y][x] != -1)
+            {
+                print_vertex(out, {strip.y0 + y, x}, get_cell);
+            }
+        }
+    }
+}
+
+// Runs job(i) for i in [0, n) on num_threads threads, a batch of num_threads
+// jobs at a time, calling done(i) for each job of a batch in order once the
+// batch has finished.
+template<typename Job, typename Done>
+void run_in_batches(int n, int num_threads, const Job& job, const Done& done)
+{
+    for (int first = 0; first < n; first += num_threads)
+    {
+        const int last = min(n, first + num_threads);
+        vector<thread> workers;
+        for (int i = first + 1; i < last; i++)
+        {
+            workers.emplace_back(job, i);
+        }
+        job(first);
+        for (thread& t : workers)
+        {
+            t.join();
+        }
+        for (int i = first; i < last; i++)
+        {
+            done(i);
+        }
+    }
+}
+
+void convert_in_strips(istream& infile, int strip_rows, int num_threads)
+{
+    read_map_header(infile);
+    const int width = map_width;
+    const int height = map_height;
+    const int num_strips = (height + strip_rows - 1) / strip_rows;
+
+    vector<Strip> strips(num_strips);
+    for (int i = 0; i < num_strips; i++)
+    {
+        strips[i].y0 = i * strip_rows;
+        strips[i].rows = min(strip_rows, height - strips[i].y0);
+    }
+
+    // Read num_threads strips at a time, and convert them at once.
+    vector<string> cells(num_threads);
+    for (int first = 0; first < num_strips; first += num_threads)
+    {
+        const int last = min(num_strips, first + num_threads);
+        for (int i = first; i < last; i++)
+        {
+            read_cells(infile, cells[i - first],
+                       strips[i].rows * width);
+        }
+        run_in_batches(last - first, num_threads, [&](int i)
+        {
+            convert_strip(strips[first + i], cells[i], width);
+        }, [](int) { });
+    }
+    char c;
+    while (infile.get(c))
+    {
+        if (!is_map_whitespace(c))
+        {
+            fail("err; map has too many characters");
+        }
+    }
+    cells.clear();
+
+    // Number the rectangles and vertices.
+    int num_rects = 0;
+    int num_vertices = 0;
+    for (int i = 0; i < num_strips; i++)
+    {
+        Strip& strip = strips[i];
+        strip.first_rect = num_rects;
+        strip.first_vertex = num_vertices;
+        num_rects += strip.rects.size();
+        num_vertices += strip.inner_vertices;
+        for (int x = 0; x <= width; x++)
+        {
+            num_vertices += strip.top_corners[x] ||
+                            (i > 0 && strips[i - 1].bottom_corners[x]);
+            if (i == num_strips - 1)
+            {
+                num_vertices += strip.bottom_corners[x];
+            }
+        }
+    }
+
+    cout << (weighted ? "weighted_mesh" : "mesh") << "\n";
+    cout << 2 << "\n";
+    cout << num_vertices << " " << num_rects << "\n";
+    // All the vertices come before all the polygons, so go over the strips
+    // twice rather than keep the output.
+    for (int polygons = 0; polygons < 2; polygons++)
+    {
+        vector<ostringstream> outs(num_threads);
+        run_in_batches(num_strips, num_threads, [&](int i)
+        {
+            print_strip(outs[i % num_threads], strips, i, width, height,
+                        polygons);
+        }, [&](int i)
+        {
+            ostringstream& out = outs[i % num_threads];
+            cout << out.str();
+            out.str("");
+        });
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    const char* usage = "usage: gridmap2rects [--weighted] "
+                        "[--strip <rows>] [--threads <n>] < map > mesh";
+    int strip_rows = 0;
+    int num_threads = 0;
+    for (int i = 1; i < argc; i++)
+    {
+        if (strcmp(argv[i], "--weighted") == 0)
+        {
+            weighted = true;
+        }
+        else if (strcmp(argv[i], "--strip") == 0 && i + 1 < argc)
+        {
+            strip_rows = atoi(argv[++i]);
+            if (strip_rows < 1)
+            {
+                fail(usage);
+            }
+        }
+        else if (strcmp(argv[i], "--threads") == 0 && i + 1 < argc)
+        {
+            num_threads = atoi(argv[++i]);
+            if (num_threads < 1)
+            {
+                fail(usage);
+            }
+        }
+        else
+        {
+            fail(usage);
+        }
+    }
+    if (strip_rows || num_threads)
+    {
+        convert_in_strips(cin, strip_rows ? strip_rows : 128,
+                          num_threads ? num_threads : 1);
+        return 0;
+    }
     read_map(cin);
     // calculate_clearance(-1, -1);
     // calculate_rectangles(-1, -1);
@@ -803,10 +1222,17 @@ int main()
     // print_rects();
     // print_traversable();
     // print_heuristic();
-    make_rectangles();
+    if (weighted)
+    {
+        make_weighted_rectangles();
+    }
+    else
+    {
+        make_rectangles(1);
+    }
     // print_rects();
     // print_ids();
-    cout << "mesh" << endl;
+    cout << (weighted ? "weighted_mesh" : "mesh") << endl;
     cout << 2 << endl;
     cout << cur_vertex_id << " " << cur_rect_id << endl;
     print_mesh_vertices();
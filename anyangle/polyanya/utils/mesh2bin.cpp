@@ -0,0 +1,46 @@
+// Converts a mesh into the binary mesh format, which Polyanya can memory map
+// instead of parsing. See spec/mesh/binary.txt.
+#include "mesh.h"
+#include <iostream>
+#include <fstream>
+#include <string>
+using namespace std;
+using namespace polyanya;
+
+int main(int argc, char* argv[])
+{
+    if (argc != 2)
+    {
+        cerr << "usage: " << argv[0] << " <file>" << endl;
+        return 1;
+    }
+    string filename = argv[1];
+    ifstream meshfile(filename);
+    if (!meshfile.is_open())
+    {
+        cerr << "Unable to open file" << endl;
+        return 1;
+    }
+    // The binary format stores the grid point location index.
+    Mesh mesh(meshfile, PointLocationMethod::GRID);
+    meshfile.close();
+    if (mesh.is_weighted())
+    {
+        cerr << "The binary format can't hold polygon weights" << endl;
+        return 1;
+    }
+
+    ofstream binfile(filename + ".bin", ios::out | ios::binary);
+    if (!binfile.is_open())
+    {
+        cerr << "Unable to open file" << endl;
+        return 1;
+    }
+    mesh.write_binary(binfile);
+    if (!binfile)
+    {
+        cerr << "Error writing binary mesh" << endl;
+        return 1;
+    }
+    return 0;
+}
@@ -1,5 +1,13 @@
 // Takes mesh from stdin, outputs to stdout.
+#include "mesh.h"
+#include "searchinstance.h"
+#include "scenario.h"
+#include "workqueue.h"
+#include "consts.h"
 #include <iostream>
+#include <fstream>
+#include <sstream>
+#include <iomanip>
 #include <vector>
 #include <string>
 #include <memory>
@@ -8,6 +16,7 @@
 #include <climits>
 #include <cmath>
 #include <queue>
+#include <thread>
 using namespace std;
 
 bool pretty = false;
@@ -82,6 +91,7 @@ void delete_nodes()
     {
         delete x;
     }
+    list_nodes.clear();
 }
 
 struct Point
@@ -845,7 +855,7 @@ void smart_merge(bool keep_deadends = true)
         while (first || cur_node_p != p.polygons)
         {
             first = false;
-            push_polygon(cur_node_p->val);
+            push_polygon(polygon_unions.find(cur_node_p->val));
             cur_node_p = cur_node_p->next;
         }
     }
@@ -990,12 +1000,303 @@ void print_mesh(ostream& outfile)
     #undef get_v
 }
 
+// The optimiser: instead of always merging one way, merge the mesh with each
+// of a few plans, run a sample of scenario queries on every result and keep
+// the one which does the least search work.
+
+enum class MergeMethod
+{
+    NONE,
+    NAIVE,
+    SMART
+};
+
+struct MergePlan
+{
+    const char* name;
+    bool deadends; // run merge_deadend first
+    MergeMethod method;
+    bool keep_deadends;
+};
+
+const vector<MergePlan> merge_plans = {
+    {"input",     false, MergeMethod::NONE,  true},
+    {"deadends",  true,  MergeMethod::NONE,  true},
+    {"naive",     true,  MergeMethod::NAIVE, true},
+    {"naive-all", true,  MergeMethod::NAIVE, false},
+    {"smart",     true,  MergeMethod::SMART, true},
+    {"smart-all", true,  MergeMethod::SMART, false},
+};
+// What meshmerger does without --optimise.
+const int DEFAULT_PLAN = 4;
+
+// Queries are handed to the workers in blocks of this many.
+const int OPTIMISE_BLOCK = 64;
+
+// Merges the mesh in input with plan, and returns the merged mesh.
+string run_plan(const string& input, const MergePlan& plan)
+{
+    delete_nodes();
+    mesh_vertices.clear();
+    mesh_polygons.clear();
+    istringstream infile(input);
+    read_mesh(infile);
+    if (plan.deadends)
+    {
+        merge_deadend();
+    }
+    switch (plan.method)
+    {
+        case MergeMethod::NONE:
+            break;
+        case MergeMethod::NAIVE:
+            naive_merge(plan.keep_deadends);
+            break;
+        case MergeMethod::SMART:
+            smart_merge(plan.keep_deadends);
+            break;
+    }
+    check_correct();
+    ostringstream outfile;
+    print_mesh(outfile);
+    return outfile.str();
+}
+
+struct PlanResult
+{
+    string mesh;
+    int polygons;
+    // For each query.
+    vector<double> cost;
+    vector<double> micro;
+    vector<int> successor_calls;
+    vector<int> nodes_generated;
+    // Totals over the sample.
+    double total_micro;
+    long long total_successor_calls;
+    long long total_nodes_generated;
+    int mismatches; // queries whose cost differs from the input mesh's
+};
+
+// Runs the queries on every plan's mesh, with num_threads workers sharing
+// the (plan, block of queries) jobs between them.
+void evaluate_plans(vector<PlanResult>& results,
+                    const vector<polyanya::Scenario>& queries, int num_threads)
+{
+    const int n = (int) queries.size();
+    const int num_blocks = (n + OPTIMISE_BLOCK - 1) / OPTIMISE_BLOCK;
+
+    // Meshes are only read by the searches, so workers share them.
+    vector<unique_ptr<polyanya::Mesh>> meshes;
+    for (PlanResult& r : results)
+    {
+        istringstream meshfile(r.mesh);
+        meshes.emplace_back(new polyanya::Mesh(meshfile));
+        r.polygons = (int) meshes.back()->mesh_polygons.size();
+        r.cost.assign(n, -1);
+        r.micro.assign(n, 0);
+        r.successor_calls.assign(n, 0);
+        r.nodes_generated.assign(n, 0);
+    }
+
+    polyanya::WorkStealingQueue jobs(num_threads);
+    jobs.fill((int) results.size() * num_blocks);
+    const auto work = [&](int worker)
+    {
+        int job;
+        while (jobs.pop(worker, job))
+        {
+            const int plan = job / num_blocks;
+            const int block = job % num_blocks;
+            PlanResult& r = results[plan];
+            polyanya::SearchInstance si(meshes[plan].get());
+            const int end = min(n, (block + 1) * OPTIMISE_BLOCK);
+            for (int i = block * OPTIMISE_BLOCK; i < end; i++)
+            {
+                si.set_start_goal(queries[i].start, queries[i].goal);
+                si.search();
+                r.cost[i] = si.get_cost();
+                r.micro[i] = si.get_search_micro();
+                r.successor_calls[i] = si.successor_calls;
+                r.nodes_generated[i] = si.nodes_generated;
+            }
+        }
+    };
+    vector<thread> workers;
+    for (int worker = 1; worker < num_threads; worker++)
+    {
+        workers.emplace_back(work, worker);
+    }
+    work(0);
+    for (thread& t : workers)
+    {
+        t.join();
+    }
+
+    for (PlanResult& r : results)
+    {
+        r.total_micro = 0;
+        r.total_successor_calls = 0;
+        r.total_nodes_generated = 0;
+        r.mismatches = 0;
+        for (int i = 0; i < n; i++)
+        {
+            r.total_micro += r.micro[i];
+            r.total_successor_calls += r.successor_calls[i];
+            r.total_nodes_generated += r.nodes_generated[i];
+            if (abs(r.cost[i] - results[0].cost[i]) > 1e-6)
+            {
+                r.mismatches++;
+            }
+        }
+    }
+}
+
+// Prints one line per plan, with the work per query and the speedup each
+// plan is expected to give over the default plan.
+void print_report(ostream& out, const vector<PlanResult>& results, int n,
+                  int chosen)
+{
+    const PlanResult& base = results[DEFAULT_PLAN];
+    out << "plan;polygons;successor_calls;generated;micro;"
+        << "call_speedup;time_speedup;mismatches\n";
+    for (int i = 0; i < (int) results.size(); i++)
+    {
+        const PlanResult& r = results[i];
+        out << merge_plans[i].name << (i == chosen ? "*" : "") << ";"
+            << r.polygons << ";"
+            << fixed << setprecision(2)
+            << (double) r.total_successor_calls / n << ";"
+            << (double) r.total_nodes_generated / n << ";"
+            << r.total_micro / n << ";"
+            << setprecision(3)
+            << (double) base.total_successor_calls /
+               max(1LL, r.total_successor_calls) << ";"
+            << base.total_micro / max(1e-9, r.total_micro) << ";"
+            << r.mismatches << "\n";
+    }
+    out.unsetf(ios::floatfield);
+    out << setprecision(6);
+}
+
+// Returns the mesh of the plan to use, and prints the report to stderr.
+// Plans are ranked by successor calls, then by nodes generated, as these are
+// the same from run to run, unlike the times. Successor calls follow the
+// search time much more closely than nodes generated do: merging more
+// eagerly can generate fewer nodes but leave more polygons to cross.
+string optimise(const string& input, const vector<polyanya::Scenario>& queries,
+                int num_threads)
+{
+    vector<PlanResult> results(merge_plans.size());
+    for (int i = 0; i < (int) merge_plans.size(); i++)
+    {
+        results[i].mesh = run_plan(input, merge_plans[i]);
+    }
+    evaluate_plans(results, queries, num_threads);
+
+    // Only plans which keep every cost can be chosen, the default included.
+    int chosen = -1;
+    for (int i = 0; i < (int) results.size(); i++)
+    {
+        const PlanResult& r = results[i];
+        if (r.mismatches != 0)
+        {
+            continue;
+        }
+        if (chosen != -1)
+        {
+            const PlanResult& best = results[chosen];
+            if (r.total_successor_calls > best.total_successor_calls ||
+                (r.total_successor_calls == best.total_successor_calls &&
+                 r.total_nodes_generated >= best.total_nodes_generated))
+            {
+                continue;
+            }
+        }
+        chosen = i;
+    }
+    if (chosen == -1)
+    {
+        // Even the input mesh disagrees with itself, which shouldn't happen.
+        cerr << "Every plan changes the cost of some queries; "
+             << "keeping the input mesh" << endl;
+        chosen = 0;
+    }
+    print_report(cerr, results, (int) queries.size(), chosen);
+    return results[chosen].mesh;
+}
+
+int usage(const char* name)
+{
+    cerr << "usage: " << name << " [--pretty] [--optimise <scenario>] "
+         << "[--sample <n>] [--threads <n>] < mesh > merged" << endl;
+    return 1;
+}
+
 int main(int argc, char* argv[])
 {
-    if (argc == 2 && string(argv[1]) == "--pretty")
+    string scenario_filename;
+    int sample = 1000;
+    int num_threads = 1;
+    for (int i = 1; i < argc; i++)
     {
-        pretty = true;
+        const string arg = argv[i];
+        if (arg == "--pretty")
+        {
+            pretty = true;
+        }
+        else if (arg == "--optimise" && i + 1 < argc)
+        {
+            scenario_filename = argv[++i];
+        }
+        else if (arg == "--sample" && i + 1 < argc)
+        {
+            sample = atoi(argv[++i]);
+        }
+        else if (arg == "--threads" && i + 1 < argc)
+        {
+            num_threads = atoi(argv[++i]);
+        }
+        else
+        {
+            return usage(argv[0]);
+        }
+    }
+    if (sample < 1 || num_threads < 1)
+    {
+        return usage(argv[0]);
+    }
+
+    if (!scenario_filename.empty())
+    {
+        ifstream scenfile(scenario_filename);
+        if (!scenfile.is_open())
+        {
+            cerr << "Unable to open scenarios" << endl;
+            return 1;
+        }
+        vector<polyanya::Scenario> scenarios;
+        if (!polyanya::load_scenarios(scenfile, scenarios) ||
+            scenarios.empty())
+        {
+            cerr << "No scenarios to optimise for" << endl;
+            return 1;
+        }
+        // Take an evenly spread sample of the scenarios.
+        vector<polyanya::Scenario> queries;
+        const int n = min(sample, (int) scenarios.size());
+        for (int i = 0; i < n; i++)
+        {
+            queries.push_back(scenarios[(long long) i * scenarios.size() / n]);
+        }
+
+        const string input((istreambuf_iterator<char>(cin)),
+                           istreambuf_iterator<char>());
+        cout << optimise(input, queries, num_threads);
+        delete_nodes();
+        return 0;
     }
+
     // cerr << "reading in" << endl;
     read_mesh(cin);
     // cerr << "merging dead ends" << endl;
@@ -150,6 +150,54 @@ class gridmap
 			tiles[2] = (uint32_t)(*((uint64_t*)(db_+pos3)) >> (bit_offset+1));
 		}
 
+		// as get_neighbours_32bit but fetches 64 tiles from each row.
+		// the last byte of the 64 tiles is read on its own, since bit
+		// padded_id needn't be the lowest bit of its dbword.
+		inline void
+		get_neighbours_64bit(uint32_t padded_id, uint64_t tiles[3])
+		{
+			uint32_t bit_offset = (padded_id & warthog::DBWORD_BITS_MASK);
+			uint32_t dbindex = padded_id >> warthog::LOG2_DBWORD_BITS;
+
+			uint32_t pos1 = dbindex - dbwidth_;
+			uint32_t pos2 = dbindex;
+			uint32_t pos3 = dbindex + dbwidth_;
+
+			// padded_id is in the lowest bit position of tiles[1].
+			// NB: shifting by 64 is undefined, hence two shifts for the
+			// high bits
+			tiles[0] = (*((uint64_t*)(db_+pos1)) >> bit_offset) |
+				(((uint64_t)db_[pos1+8] << (63 - bit_offset)) << 1);
+			tiles[1] = (*((uint64_t*)(db_+pos2)) >> bit_offset) |
+				(((uint64_t)db_[pos2+8] << (63 - bit_offset)) << 1);
+			tiles[2] = (*((uint64_t*)(db_+pos3)) >> bit_offset) |
+				(((uint64_t)db_[pos3+8] << (63 - bit_offset)) << 1);
+		}
+
+		// as get_neighbours_upper_32bit but fetches 64 tiles from each 
+		// row. padded_id is in the highest bit position of tiles[1].
+		inline void
+		get_neighbours_upper_64bit(uint32_t padded_id, uint64_t tiles[3])
+		{
+			uint32_t bit_offset = (padded_id & warthog::DBWORD_BITS_MASK);
+			uint32_t dbindex = padded_id >> warthog::LOG2_DBWORD_BITS;
+
+			// read the 8 dbwords that end with padded_id and take the
+			// lowest bits from the dbword before those
+			dbindex -= 7;
+
+			uint32_t pos1 = dbindex - dbwidth_;
+			uint32_t pos2 = dbindex;
+			uint32_t pos3 = dbindex + dbwidth_;
+
+			tiles[0] = (*((uint64_t*)(db_+pos1)) << (7 - bit_offset)) |
+				(db_[pos1-1] >> (bit_offset+1));
+			tiles[1] = (*((uint64_t*)(db_+pos2)) << (7 - bit_offset)) |
+				(db_[pos2-1] >> (bit_offset+1));
+			tiles[2] = (*((uint64_t*)(db_+pos3)) << (7 - bit_offset)) |
+				(db_[pos3-1] >> (bit_offset+1));
+		}
+
 		// get the label associated with the padded coordinate pair (x, y)
 		inline bool
 		get_label(uint32_t x, unsigned int y)
@@ -0,0 +1 @@
+#include "euclidean_heuristic.h"
@@ -0,0 +1,54 @@
+#ifndef WARTHOG_EUCLIDEAN_HEURISTIC_H
+#define WARTHOG_EUCLIDEAN_HEURISTIC_H
+
+// euclidean_heuristic.h
+//
+// Straight-line distance; admissible for any-angle search on grids 
+// (e.g. warthog::anya_expansion_policy).
+//
+// @created: 18/10/2026
+//
+
+#include "constants.h"
+#include "helpers.h"
+
+#include <cmath>
+
+namespace warthog
+{
+
+class euclidean_heuristic
+{
+	public:
+		euclidean_heuristic(unsigned int mapwidth, unsigned int mapheight) 
+	    	: mapwidth_(mapwidth)
+            { }
+		~euclidean_heuristic() { }
+
+		inline warthog::cost_t
+		h(int32_t x, int32_t y, int32_t x2, int32_t y2)
+		{
+            // NB: precision loss when warthog::cost_t is an integer
+			double dx = x-x2;
+			double dy = y-y2;
+			return sqrt(dx*dx + dy*dy) * warthog::ONE;
+		}
+
+		inline warthog::cost_t
+		h(unsigned int id, unsigned int id2)
+		{
+			unsigned int x, x2;
+			unsigned int y, y2;
+			warthog::helpers::index_to_xy(id, mapwidth_, x, y);
+			warthog::helpers::index_to_xy(id2,mapwidth_, x2, y2);
+			return this->h(x, y, x2, y2);
+		}
+
+	private:
+		unsigned int mapwidth_;
+};
+
+}
+
+#endif
+
@@ -0,0 +1,109 @@
+#include "compressed_jump_point_database.h"
+
+#include <algorithm>
+#include <iostream>
+#include <stdlib.h>
+
+// the labels that end a run, indexed by their codes
+const uint16_t warthog::compressed_jump_point_database::CODE_LABELS[4] =
+	{ 32768, 1, 32768 | 1, 32768 | 2 };
+
+warthog::compressed_jump_point_database::compressed_jump_point_database(
+		warthog::gridmap* map, const uint16_t* labels)
+	: map_(map)
+{
+	mapw_ = map_->width();
+	maph_ = map_->height();
+	uint32_t size = map_->padded_mapsize();
+	last_ = size - 1;
+	wdiv_ = UINT64_MAX / mapw_ + 1;
+
+	uint32_t ndiagonals = mapw_ + maph_ - 1;
+	int32_t anti_start = 0;
+	int32_t diag_start = 0;
+	for(int32_t k = 0; k < (int32_t)ndiagonals; k++)
+	{
+		int32_t ylo = std::max(0, k - ((int32_t)mapw_-1));
+		int32_t yhi = std::min((int32_t)maph_-1, k);
+		anti_.push_back(anti_start - ylo);
+		anti_start += yhi - ylo + 1;
+
+		int32_t c = k - ((int32_t)maph_-1);
+		ylo = std::max(0, -c);
+		yhi = std::min((int32_t)maph_-1, (int32_t)mapw_-1 - c);
+		diag_.push_back(diag_start - ylo);
+		diag_start += yhi - ylo + 1;
+	}
+
+	// node id deltas for one step in each direction
+	int32_t w = mapw_;
+	int32_t steps[8] = { -w, w, 1, -1, -w+1, -w-1, w+1, w-1 };
+
+	for(uint32_t i = 0; i < 8; i++)
+	{
+		codes_[i].resize(((size >> 6) + 1) * (i < 4 ? 1 : 2), 0);
+	}
+	for(uint32_t i = 0; i < 8; i++)
+	{
+		stops_[i] = new warthog::rle_bitmap(size);
+		for(uint32_t id = 0; id < size; id++)
+		{
+			uint16_t label = labels[8*id + i];
+			uint32_t pos = position(id, i);
+
+			// does the run continue with the next node along the line?
+			uint32_t next_id = id + steps[i];
+			if(next_id < size && position(next_id, i) == pos + 1 &&
+					label == labels[8*next_id + i] + 1)
+			{
+				continue;
+			}
+
+			uint32_t code = 0;
+			while(code < 4 && CODE_LABELS[code] != label) { code++; }
+			if(code == 4 || (i < 4 && code > 1))
+			{
+				std::cerr << "err; cannot compress jump point label "
+					<< label << " of node " << id << ". aborting.\n";
+				exit(1);
+			}
+
+			stops_[i]->set(pos);
+			if(i < 4)
+			{
+				codes_[i][pos >> 6] |= (uint64_t)code << (pos & 63);
+			}
+			else
+			{
+				uint64_t* words = &codes_[i][2*(pos >> 6)];
+				words[0] |= (uint64_t)(code & 1) << (pos & 63);
+				words[1] |= (uint64_t)(code >> 1) << (pos & 63);
+			}
+		}
+		stops_[i]->finish();
+	}
+}
+
+warthog::compressed_jump_point_database::~compressed_jump_point_database()
+{
+	for(uint32_t i = 0; i < 8; i++)
+	{
+		delete stops_[i];
+	}
+}
+
+uint32_t
+warthog::compressed_jump_point_database::mem()
+{
+	uint32_t bytes = sizeof(*this) +
+		sizeof(int32_t) * (anti_.capacity() + diag_.capacity());
+	for(uint32_t i = 0; i < 8; i++)
+	{
+		bytes += stops_[i]->mem();
+	}
+	for(uint32_t i = 0; i < 8; i++)
+	{
+		bytes += sizeof(uint64_t) * codes_[i].capacity();
+	}
+	return bytes;
+}
@@ -0,0 +1,115 @@
+#ifndef WARTHOG_COMPRESSED_JUMP_POINT_DATABASE_H
+#define WARTHOG_COMPRESSED_JUMP_POINT_DATABASE_H
+
+// compressed_jump_point_database.h
+//
+// The labels of a warthog::jump_point_database in about a sixth of the
+// space: 22 bits per node for all 8 directions rather than 128.
+//
+// Walking backward along a line of the map in one direction, the label
+// of each node is usually that of the next node plus one step. Such a
+// run ends at a node whose label is one of just four values: an obstacle
+// or dead-end with 0 steps, a jump point 1 step away, or (for diagonal
+// directions) a dead-end 1 or 2 steps away. For each direction the nodes
+// are ordered along their rows, columns or diagonals so that every run
+// is contiguous; an rle_bitmap marks the run ends and one or two more
+// bits say which of the four labels each one has. The label of a node is
+// then the number of steps to the end of its run plus the label there.
+//
+// @created: 18/10/2026
+//
+
+#include "gridmap.h"
+#include "rle.h"
+
+#include "stdint.h"
+#include <vector>
+
+namespace warthog
+{
+
+__extension__ typedef unsigned __int128 uint128_t;
+
+class compressed_jump_point_database
+{
+	public:
+		// compresses labels, the contents of a jump_point_database
+		compressed_jump_point_database(warthog::gridmap* map,
+				const uint16_t* labels);
+		~compressed_jump_point_database();
+
+		// the label of node_id for the direction with index i
+		// (i.e. warthog::jps::direction 1 << i)
+		inline uint16_t
+		label(uint32_t node_id, uint32_t i)
+		{
+			uint32_t pos = position(node_id, i);
+			uint32_t end = stops_[i]->next(pos);
+			uint32_t code;
+			if(i < 4)
+			{
+				code = (codes_[i][end >> 6] >> (end & 63)) & 1;
+			}
+			else
+			{
+				const uint64_t* words = &codes_[i][2*(end >> 6)];
+				code = ((words[0] >> (end & 63)) & 1) |
+					(((words[1] >> (end & 63)) & 1) << 1);
+			}
+			return (end - pos) + CODE_LABELS[code];
+		}
+
+		uint32_t
+		mem();
+
+	private:
+		static const uint16_t CODE_LABELS[4];
+
+		warthog::gridmap* map_;
+		uint32_t mapw_;
+		uint32_t maph_;
+		uint32_t last_; // the largest position; one less than the map size
+
+		// the run ends and their codes for each direction. the codes of
+		// the diagonal directions take two bits, which are kept in
+		// alternate words so that both are in the same cache line.
+		warthog::rle_bitmap* stops_[8];
+		std::vector<uint64_t> codes_[8];
+
+		// ceil(2^64 / mapw_), for dividing by mapw_ with a multiplication
+		// [Lemire, Kaser and Kurz, Faster Remainder by Direct Computation, 
+		// Software: Practice and Experience, 2019]
+		uint64_t wdiv_;
+
+		// where the diagonals with x + y = k (anti_[k]) and
+		// x - y = k - (maph_-1) (diag_[k]) begin, less their first y
+		std::vector<int32_t> anti_;
+		std::vector<int32_t> diag_;
+
+		// the position of node_id in the order used for direction i:
+		// along rows for east and west, columns for north and south and
+		// the diagonals for the rest, in the direction of travel
+		inline uint32_t
+		position(uint32_t node_id, uint32_t i)
+		{
+			if(i == 2) { return node_id; }
+			if(i == 3) { return last_ - node_id; }
+
+			uint32_t y = ((uint128_t)wdiv_ * node_id) >> 64;
+			uint32_t x = node_id - y * mapw_;
+			switch(i)
+			{
+				case 0: return last_ - (x * maph_ + y);
+				case 1: return x * maph_ + y;
+				case 4: return last_ - (anti_[x + y] + y);
+				case 5: return last_ - (diag_[x + maph_-1 - y] + y);
+				case 6: return diag_[x + maph_-1 - y] + y;
+				default: return anti_[x + y] + y;
+			}
+		}
+};
+
+}
+
+#endif
+
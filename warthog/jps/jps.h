@@ -36,6 +36,30 @@ typedef enum
 	SOUTHWEST = 128
 } direction;
 
+// Jump point locators return each jump point together with the direction
+// of the last step taken to reach it (i.e. the direction from its parent).
+// The two are packed into a jps_id: the node id is in the lower 32 bits 
+// and the direction in the 8 bits above that.
+typedef uint64_t jps_id;
+
+inline warthog::jps::jps_id
+to_jps_id(uint32_t node_id, warthog::jps::direction d)
+{
+	return ((uint64_t)d << 32) | node_id;
+}
+
+inline uint32_t
+get_node_id(warthog::jps::jps_id id)
+{
+	return (uint32_t)id;
+}
+
+inline warthog::jps::direction
+get_direction(warthog::jps::jps_id id)
+{
+	return (warthog::jps::direction)(id >> 32);
+}
+
 // Computes the set of "forced" directions in which to search for jump points
 // from a given location (x, y). 
 // A neighbour is forced if it cannot be proven that there is at least one 
@@ -1,10 +1,11 @@
 #include "jps2_expansion_policy.h"
 
-warthog::jps2_expansion_policy::jps2_expansion_policy(warthog::gridmap* map)
+warthog::jps2_expansion_policy::jps2_expansion_policy(
+		warthog::gridmap* map, bool jump64)
 {
 	map_ = map;
 	nodepool_ = new warthog::blocklist(map->height(), map->width());
-	jpl_ = new warthog::online_jump_point_locator2(map);
+	jpl_ = new warthog::online_jump_point_locator2(map, jump64);
 	reset();
 
 	neighbours_.reserve(100);
@@ -47,15 +48,13 @@ warthog::jps2_expansion_policy::expand(
 	}
 
 	uint32_t searchid = problem->get_searchid();
-	uint32_t id_mask = (1 << 24)-1;
 	for(uint32_t i = 0; i < jp_ids_.size(); i++)
 	{
-		// bits 0-23 store the id of the jump point
-		// bits 24-31 store the direction to the parent
-		uint32_t jp_id = jp_ids_.at(i);
-		warthog::jps::direction pdir = (warthog::jps::direction)*(((uint8_t*)(&jp_id))+3);
+		warthog::jps::jps_id jp_id = jp_ids_.at(i);
+		warthog::jps::direction pdir = warthog::jps::get_direction(jp_id);
 
-		warthog::search_node* mynode = nodepool_->generate(jp_id & id_mask);
+		warthog::search_node* mynode = 
+			nodepool_->generate(warthog::jps::get_node_id(jp_id));
 		neighbours_.push_back(mynode);
 		if(mynode->get_searchid() != searchid) { mynode->reset(searchid); }
 
@@ -27,7 +27,9 @@ namespace warthog
 class jps2_expansion_policy 
 {
 	public:
-		jps2_expansion_policy(warthog::gridmap* map);
+		// jump64: scan 64 tiles at a time when jumping 
+		// (cf. warthog::online_jump_point_locator2)
+		jps2_expansion_policy(warthog::gridmap* map, bool jump64 = false);
 		~jps2_expansion_policy();
 
 		// create a warthog::search_node object from a state description
@@ -104,7 +106,7 @@ class jps2_expansion_policy
 		uint32_t num_neighbours_;
 		std::vector<warthog::search_node*> neighbours_;
 		std::vector<warthog::cost_t> costs_;
-		std::vector<uint32_t> jp_ids_;
+		std::vector<warthog::jps::jps_id> jp_ids_;
 
 		inline void
 		reset()
@@ -5,6 +5,21 @@ warthog::jps2plus_expansion_policy::jps2plus_expansion_policy(warthog::gridmap*
 	map_ = map;
 	nodepool_ = new warthog::blocklist2(map->height(), map->width());
 	jpl_ = new warthog::offline_jump_point_locator2(map);
+	own_jpl_ = true;
+	reset();
+
+	neighbours_.reserve(100);
+	costs_.reserve(100);
+	jp_ids_.reserve(100);
+}
+
+warthog::jps2plus_expansion_policy::jps2plus_expansion_policy(
+		warthog::gridmap* map, warthog::offline_jump_point_locator2* jpl)
+{
+	map_ = map;
+	nodepool_ = new warthog::blocklist2(map->height(), map->width());
+	jpl_ = jpl;
+	own_jpl_ = false;
 	reset();
 
 	neighbours_.reserve(100);
@@ -14,7 +29,7 @@ warthog::jps2plus_expansion_policy::jps2plus_expansion_policy(warthog::gridmap*
 
 warthog::jps2plus_expansion_policy::~jps2plus_expansion_policy()
 {
-	delete jpl_;
+	if(own_jpl_) { delete jpl_; }
 	delete nodepool_;
 }
 
@@ -47,15 +62,13 @@ warthog::jps2plus_expansion_policy::expand(
 	}
 
 	uint32_t searchid = problem->get_searchid();
-	uint32_t id_mask = (1 << 24)-1;
 	for(uint32_t i = 0; i < jp_ids_.size(); i++)
 	{
-		// bits 0-23 store the id of the jump point
-		// bits 24-31 store the direction to the parent
-		uint32_t jp_id = jp_ids_.at(i);
-		warthog::jps::direction pdir = (warthog::jps::direction)*(((uint8_t*)(&jp_id))+3);
+		warthog::jps::jps_id jp_id = jp_ids_.at(i);
+		warthog::jps::direction pdir = warthog::jps::get_direction(jp_id);
 
-		warthog::search_node* mynode = nodepool_->generate(jp_id & id_mask);
+		warthog::search_node* mynode = 
+			nodepool_->generate(warthog::jps::get_node_id(jp_id));
 		neighbours_.push_back(mynode);
 		if(mynode->get_searchid() != searchid) { mynode->reset(searchid); }
 
@@ -26,6 +26,12 @@ class jps2plus_expansion_policy
 {
 	public:
 		jps2plus_expansion_policy(warthog::gridmap* map);
+
+		// uses a jump point database built elsewhere, which several 
+		// policies (e.g. one per thread) can then share. the caller 
+		// keeps ownership of jpl.
+		jps2plus_expansion_policy(warthog::gridmap* map, 
+				warthog::offline_jump_point_locator2* jpl);
 		~jps2plus_expansion_policy();
 
 		// create a warthog::search_node object from a state description
@@ -85,7 +91,8 @@ class jps2plus_expansion_policy
 		inline uint32_t
 		mem()
 		{
-			return sizeof(*this) + map_->mem() + nodepool_->mem() + jpl_->mem();
+			return sizeof(*this) + map_->mem() + nodepool_->mem() + 
+				(own_jpl_ ? jpl_->mem() : 0);
 		}
 
 		uint32_t 
@@ -98,11 +105,12 @@ class jps2plus_expansion_policy
 		warthog::gridmap* map_;
 		warthog::blocklist2* nodepool_;
 		offline_jump_point_locator2* jpl_;
+		bool own_jpl_;
 		uint32_t which_;
 		uint32_t num_neighbours_;
 		std::vector<warthog::search_node*> neighbours_;
 		std::vector<warthog::cost_t> costs_;
-		std::vector<uint32_t> jp_ids_;
+		std::vector<warthog::jps::jps_id> jp_ids_;
 
 		inline void
 		reset()
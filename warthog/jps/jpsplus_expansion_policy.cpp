@@ -5,12 +5,23 @@ warthog::jpsplus_expansion_policy::jpsplus_expansion_policy(warthog::gridmap* ma
 	map_ = map;
 	nodepool_ = new warthog::blocklist(map->height(), map->width());
 	jpl_ = new warthog::offline_jump_point_locator(map);
+	own_jpl_ = true;
+	reset();
+}
+
+warthog::jpsplus_expansion_policy::jpsplus_expansion_policy(
+		warthog::gridmap* map, warthog::offline_jump_point_locator* jpl)
+{
+	map_ = map;
+	nodepool_ = new warthog::blocklist(map->height(), map->width());
+	jpl_ = jpl;
+	own_jpl_ = false;
 	reset();
 }
 
 warthog::jpsplus_expansion_policy::~jpsplus_expansion_policy()
 {
-	delete jpl_;
+	if(own_jpl_) { delete jpl_; }
 	delete nodepool_;
 }
 
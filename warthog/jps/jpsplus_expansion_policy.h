@@ -29,6 +29,12 @@ class jpsplus_expansion_policy
 {
 	public:
 		jpsplus_expansion_policy(warthog::gridmap* map);
+
+		// uses a jump point database built elsewhere, which several 
+		// policies (e.g. one per thread) can then share. the caller 
+		// keeps ownership of jpl.
+		jpsplus_expansion_policy(warthog::gridmap* map, 
+				warthog::offline_jump_point_locator* jpl);
 		~jpsplus_expansion_policy();
 
 		// create a warthog::search_node object from a state description
@@ -88,7 +94,8 @@ class jpsplus_expansion_policy
 		inline uint32_t
 		mem()
 		{
-			return sizeof(*this) + map_->mem() + nodepool_->mem() + jpl_->mem();
+			return sizeof(*this) + map_->mem() + nodepool_->mem() + 
+				(own_jpl_ ? jpl_->mem() : 0);
 		}
 
 		uint32_t 
@@ -101,6 +108,7 @@ class jpsplus_expansion_policy
 		warthog::gridmap* map_;
 		warthog::blocklist* nodepool_;
 		offline_jump_point_locator* jpl_;
+		bool own_jpl_;
 		uint32_t which_;
 		uint32_t num_neighbours_;
 		warthog::search_node* neighbours_[9];
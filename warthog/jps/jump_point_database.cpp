@@ -0,0 +1,383 @@
+#include "gridmap.h"
+#include "jump_point_database.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <fcntl.h>
+#include <iostream>
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+namespace
+{
+
+const uint32_t JPDB_VERSION = 2;
+
+// the layout of a .jps+ file: this header, then the labels
+struct jpdb_header
+{
+	char magic[4];
+	uint32_t version;
+	uint32_t width;
+	uint32_t height;
+	uint32_t dbsize;
+	uint32_t unused;
+	uint64_t checksum;
+};
+
+// FNV-1a, eight bytes at a time
+uint64_t
+checksum(const uint16_t* labels, uint32_t size)
+{
+	const uint64_t* words = (const uint64_t*)labels;
+	uint64_t hash = 14695981039346656037ULL;
+	for(uint32_t i = 0; i < size / 4; i++)
+	{
+		hash ^= words[i];
+		hash *= 1099511628211ULL;
+	}
+	return hash;
+}
+
+// calls task(i) for each i < ntasks; threads take the next task
+// as soon as they finish the last one
+template<class F>
+void
+parallel_for(uint32_t nthreads, uint32_t ntasks, F task)
+{
+	std::atomic<uint32_t> next(0);
+	auto work = [&]()
+	{
+		for(uint32_t i = next++; i < ntasks; i = next++)
+		{
+			task(i);
+		}
+	};
+
+	std::vector<std::thread> workers;
+	for(uint32_t t = 1; t < nthreads; t++)
+	{
+		workers.push_back(std::thread(work));
+	}
+	work();
+	for(uint32_t t = 0; t < workers.size(); t++)
+	{
+		workers[t].join();
+	}
+}
+
+// labels the nodes of one row or column for a straight direction (index i).
+// first is the first node of the line in the direction of travel, step the
+// id delta of one move and side that of the nodes either side of the line.
+void
+sweep_straight(warthog::gridmap* map, uint16_t* labels, uint32_t first,
+		uint32_t step, uint32_t side, uint32_t length, uint32_t i)
+{
+	for(uint32_t t = length; t > 0; t--)
+	{
+		uint32_t node_id = first + (t-1)*step;
+		uint32_t next_id = node_id + step;
+
+		uint16_t label;
+		if(!map->get_label(node_id) || !map->get_label(next_id))
+		{
+			label = 32768;
+		}
+		else if(
+			(map->get_label(next_id + side) && !map->get_label(node_id + side)) ||
+			(map->get_label(next_id - side) && !map->get_label(node_id - side)))
+		{
+			// next_id has a forced neighbour
+			label = 1;
+		}
+		else
+		{
+			label = labels[8*next_id + i] + 1;
+		}
+		labels[8*node_id + i] = label;
+	}
+}
+
+// labels the nodes of one diagonal for a diagonal direction (index i).
+// nodes are visited from the end of the line backward; vertical and
+// horizontal are the id deltas of the two straight moves that make up a
+// diagonal one, vi and hi their indexes.
+void
+sweep_diagonal(warthog::gridmap* map, uint16_t* labels,
+		const std::vector<uint32_t>& line, uint32_t vertical,
+		uint32_t horizontal, uint32_t vi, uint32_t hi, uint32_t i)
+{
+	uint32_t step = vertical + horizontal;
+	for(uint32_t t = 0; t < line.size(); t++)
+	{
+		uint32_t node_id = line[t];
+		uint32_t next_id = node_id + step;
+
+		// no corner cutting
+		uint16_t label;
+		if(!(map->get_label(node_id) && map->get_label(next_id) &&
+			map->get_label(node_id + vertical) &&
+			map->get_label(node_id + horizontal)))
+		{
+			label = 32768;
+		}
+		else
+		{
+			uint16_t vlabel = labels[8*next_id + vi];
+			uint16_t hlabel = labels[8*next_id + hi];
+			if(!(vlabel & 32768) || !(hlabel & 32768))
+			{
+				// a straight jump from next_id finds a jump point
+				label = 1;
+			}
+			else if(!(vlabel & 32767) || !(hlabel & 32767))
+			{
+				// next_id is a dead-end
+				label = 32768 | 1;
+			}
+			else if(!map->get_label(next_id + step))
+			{
+				// the jump stops on the obstacle after next_id
+				label = 32768 | 2;
+			}
+			else
+			{
+				label = labels[8*next_id + i] + 1;
+			}
+		}
+		labels[8*node_id + i] = label;
+	}
+}
+
+}
+
+warthog::jump_point_database::jump_point_database(warthog::gridmap* map)
+	: map_(map), dbsize_(0), db_(0), mapping_(0), mapping_size_(0)
+{
+	if(map_->padded_mapsize() > (UINT32_MAX / 8) ||
+			map_->width() > 32767 || map_->height() > 32767)
+	{
+		// the database stores 8 labels per node, indexed by 8*node_id,
+		// and each label stores a jump distance in 15 bits
+		std::cerr << "map size too big for this implementation of JPS+."
+			<< " aborting."<< std::endl;
+		exit(1);
+	}
+
+	if(load(map_->filename())) { return; }
+
+	uint16_t* labels = new uint16_t[8*map_->padded_mapsize()];
+	compute(map_, labels, 0);
+	dbsize_ = 8*map_->padded_mapsize();
+	db_ = labels;
+	save(map_->filename());
+
+	// use the saved copy instead, so that other processes can share it
+	load(map_->filename());
+}
+
+warthog::jump_point_database::~jump_point_database()
+{
+	release();
+}
+
+void
+warthog::jump_point_database::release()
+{
+	if(mapping_)
+	{
+		munmap(mapping_, mapping_size_);
+		mapping_ = 0;
+	}
+	else
+	{
+		delete [] db_;
+	}
+	db_ = 0;
+}
+
+void
+warthog::jump_point_database::compute(warthog::gridmap* map,
+		uint16_t* labels, uint32_t nthreads)
+{
+	uint32_t mapw = map->width();
+	uint32_t w = map->header_width();
+	uint32_t h = map->header_height();
+	uint32_t dbsize = 8*map->padded_mapsize();
+	// padding is an obstacle, like any other
+	for(uint32_t i = 0; i < dbsize; i++) { labels[i] = 32768; }
+
+	if(nthreads == 0)
+	{
+		nthreads = std::max(1u, std::thread::hardware_concurrency());
+	}
+
+	// straight jumps; one task per row (east, west) and column
+	// (north, south)
+	parallel_for(nthreads, 2*h + 2*w,
+	[&](uint32_t task)
+	{
+		if(task < h)
+		{
+			sweep_straight(map, labels, map->to_padded_id(0, task),
+					1, mapw, w, 2);
+		}
+		else if(task < 2*h)
+		{
+			sweep_straight(map, labels, map->to_padded_id(w-1, task-h),
+					-1, mapw, w, 3);
+		}
+		else if(task < 2*h + w)
+		{
+			uint32_t x = task - 2*h;
+			sweep_straight(map, labels, map->to_padded_id(x, h-1),
+					-mapw, 1, h, 0);
+		}
+		else
+		{
+			uint32_t x = task - 2*h - w;
+			sweep_straight(map, labels, map->to_padded_id(x, 0),
+					mapw, 1, h, 1);
+		}
+	});
+
+	// diagonal jumps, which build on the straight ones. one task per
+	// diagonal and direction: NE, NW, SE, SW.
+	uint32_t ndiagonals = w + h - 1;
+	parallel_for(nthreads, 4*ndiagonals,
+	[&](uint32_t task)
+	{
+		uint32_t d = task / ndiagonals;
+		int32_t k = task % ndiagonals;
+		int32_t dx = (d == 0 || d == 2) ? 1 : -1;
+		int32_t dy = (d < 2) ? -1 : 1;
+
+		// the nodes (x, y) of the diagonal have x + y = k when
+		// dx != dy and x - y = k - (h-1) otherwise
+		int32_t c = (dx == dy) ? k - (int32_t)(h-1) : k;
+		int32_t ylo, yhi;
+		if(dx == dy)
+		{
+			ylo = std::max(0, -c);
+			yhi = std::min((int32_t)h-1, (int32_t)w-1 - c);
+		}
+		else
+		{
+			ylo = std::max(0, c - ((int32_t)w-1));
+			yhi = std::min((int32_t)h-1, c);
+		}
+
+		// visit the nodes from the end of the line backward
+		std::vector<uint32_t> line;
+		for(int32_t t = 0; t <= yhi - ylo; t++)
+		{
+			int32_t y = dy < 0 ? ylo + t : yhi - t;
+			int32_t x = (dx == dy) ? c + y : c - y;
+			line.push_back(map->to_padded_id(x, y));
+		}
+		sweep_diagonal(map, labels, line, dy*mapw, dx,
+				dy < 0 ? 0 : 1, dx > 0 ? 2 : 3, 4 + d);
+	});
+}
+
+bool
+warthog::jump_point_database::load(const char* filename)
+{
+	char fname[256];
+	strcpy(fname, filename);
+	strcat(fname, ".jps+");
+	std::cerr << "loading "<<fname << "... ";
+
+	int fd = open(fname, O_RDONLY);
+	if(fd == -1)
+	{
+		std::cerr << "no dice. oh well. keep going.\n"<<std::endl;
+		return false;
+	}
+
+	uint32_t dbsize = 8*map_->padded_mapsize();
+	size_t size = sizeof(jpdb_header) + sizeof(uint16_t)*dbsize;
+	struct stat st;
+	void* mapping = MAP_FAILED;
+	if(fstat(fd, &st) == 0 && (size_t)st.st_size == size)
+	{
+		mapping = mmap(0, size, PROT_READ, MAP_SHARED, fd, 0);
+	}
+	close(fd);
+	if(mapping == MAP_FAILED)
+	{
+		std::cerr << "cannot map file; not a jump point database for this "
+			<< "map? keep going.\n" << std::endl;
+		return false;
+	}
+
+	const jpdb_header* header = (const jpdb_header*)mapping;
+	const uint16_t* labels = (const uint16_t*)(header + 1);
+	if(memcmp(header->magic, "JPS+", 4) != 0 ||
+			header->version != JPDB_VERSION ||
+			header->width != map_->width() ||
+			header->height != map_->height() ||
+			header->dbsize != dbsize ||
+			header->checksum != checksum(labels, dbsize))
+	{
+		std::cerr << "out of date or corrupt. keep going.\n" << std::endl;
+		munmap(mapping, size);
+		return false;
+	}
+
+	release();
+	mapping_ = mapping;
+	mapping_size_ = size;
+	dbsize_ = dbsize;
+	db_ = labels;
+	std::cerr <<"#labels="<<dbsize_<<std::endl;
+	return true;
+}
+
+void
+warthog::jump_point_database::save(const char* filename)
+{
+	char fname[256];
+	strcpy(fname, filename);
+	strcat(fname, ".jps+");
+	std::cerr << "saving to file "<<fname<<"; nodes="<<dbsize_<<" size: "<<sizeof(db_[0])<<std::endl;
+
+	// write a temporary file and move it into place, so that processes
+	// which mapped an earlier version keep a complete copy
+	char tmpname[280];
+	sprintf(tmpname, "%s.%d", fname, (int)getpid());
+	FILE* f = fopen(tmpname, "wb");
+	if(f == NULL)
+	{
+		std::cerr << "err; cannot write jump-point graph to file "
+			<<fname<<". oh well. try to keep going.\n"<<std::endl;
+		return;
+	}
+
+	jpdb_header header;
+	memset(&header, 0, sizeof(header));
+	memcpy(header.magic, "JPS+", 4);
+	header.version = JPDB_VERSION;
+	header.width = map_->width();
+	header.height = map_->height();
+	header.dbsize = dbsize_;
+	header.checksum = checksum(db_, dbsize_);
+
+	bool ok = fwrite(&header, sizeof(header), 1, f) == 1 &&
+		fwrite(db_, sizeof(*db_), dbsize_, f) == dbsize_;
+	ok = (fclose(f) == 0) && ok;
+	if(!ok || rename(tmpname, fname) != 0)
+	{
+		std::cerr << "err; cannot write jump-point graph to file "
+			<<fname<<". oh well. try to keep going.\n"<<std::endl;
+		remove(tmpname);
+		return;
+	}
+	std::cerr << "jump-point graph saved to disk. file="<<fname<<std::endl;
+}
@@ -0,0 +1,92 @@
+#ifndef WARTHOG_JUMP_POINT_DATABASE_H
+#define WARTHOG_JUMP_POINT_DATABASE_H
+
+// jump_point_database.h
+//
+// The pre-computed jump distances used by the offline jump point locators
+// (JPS+). There are 8 labels per (padded) node, one for each direction,
+// in the order of warthog::jps::direction. The low 15 bits of a label are
+// the number of steps to the next jump point in that direction. If there
+// is none the leading bit is set and the steps are those to the last
+// traversable node before the jump runs into an obstacle. Obstacles,
+// including the padding around the map, have a label of 0 steps with the
+// leading bit set.
+//
+// The labels are computed with one sweep per row, column and diagonal of
+// the map, working backward from the end of each line: the label of a node
+// follows from that of the next node in the same direction. The straight
+// lines are independent of one another, and so are the diagonals once the
+// straight labels are known, so the lines are shared among threads.
+//
+// The database is saved next to the map (as [mapfile].jps+) with a header
+// that records the format version, the size of the map and a checksum of
+// the labels. A valid file is mapped read-only into memory rather than
+// read, so that processes using the same map share one copy of it.
+// Files that do not match the map (or come from older versions of the
+// program) are computed again and overwritten.
+//
+// @created: 18/10/2026
+//
+
+#include "stdint.h"
+#include <cstddef>
+
+namespace warthog
+{
+
+class gridmap;
+class jump_point_database
+{
+	public:
+		// loads the database of the map from disk, or computes and
+		// saves it if there is no valid file.
+		jump_point_database(warthog::gridmap* map);
+		~jump_point_database();
+
+		inline const uint16_t*
+		labels()
+		{
+			return db_;
+		}
+
+		inline uint32_t
+		size()
+		{
+			return dbsize_;
+		}
+
+		uint32_t
+		mem()
+		{
+			return sizeof(*this) + sizeof(*db_)*dbsize_;
+		}
+
+		// computes the labels of every node in the map, using up to
+		// nthreads threads (0 = as many as there are cores). labels
+		// must have room for 8*padded_mapsize() entries.
+		static void
+		compute(warthog::gridmap* map, uint16_t* labels, uint32_t nthreads);
+
+	private:
+		bool
+		load(const char* filename);
+
+		void
+		save(const char* filename);
+
+		void
+		release();
+
+		warthog::gridmap* map_;
+		uint32_t dbsize_;
+		const uint16_t* db_;
+
+		// the file backing the labels, if they were loaded from disk
+		void* mapping_;
+		size_t mapping_size_;
+};
+
+}
+
+#endif
+
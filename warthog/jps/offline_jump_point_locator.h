@@ -4,13 +4,16 @@
 // offline_jump_point_locator.h
 //
 // Identifies jump points using a pre-computed database that stores
-// distances from each node to jump points in every direction.
+// distances from each node to jump points in every direction
+// (see warthog::jump_point_database).
 //
 // @author: dharabor
 // @created: 05/05/2013
 //
 
+#include "compressed_jump_point_database.h"
 #include "jps.h"
+#include "jump_point_database.h"
 
 namespace warthog
 {
@@ -19,7 +22,9 @@ class gridmap;
 class offline_jump_point_locator
 {
 	public:
-		offline_jump_point_locator(warthog::gridmap* map);
+		// with compress set, the jump point database is kept in
+		// compressed form (see compressed_jump_point_database.h)
+		offline_jump_point_locator(warthog::gridmap* map, bool compress = false);
 		~offline_jump_point_locator();
 
 		void
@@ -29,21 +34,12 @@ class offline_jump_point_locator
 		uint32_t
 		mem()
 		{
-			return sizeof(this) + sizeof(*db_)*dbsize_;
+			return sizeof(this) + (cdb_ ? cdb_->mem() : jpdb_->mem());
 		}
 
 
 	private:
 
-		void
-		preproc();
-
-		bool
-		load(const char* filename);
-
-		void 
-		save(const char* filename);
-
 		void
 		jump_northwest(uint32_t node_id, uint32_t goal_id, 
 				uint32_t& jumpnode_id, warthog::cost_t& jumpcost);
@@ -70,8 +66,17 @@ class offline_jump_point_locator
 				uint32_t& jumpnode_id, warthog::cost_t& jumpcost);
 
 		warthog::gridmap* map_;
-		uint32_t dbsize_;
-		uint16_t* db_;	
+		warthog::jump_point_database* jpdb_;
+		warthog::compressed_jump_point_database* cdb_;
+		const uint16_t* db_;
+
+		// the label of node_id for the direction with index i
+		inline uint16_t
+		get_label(uint32_t node_id, uint32_t i)
+		{
+			if(db_) { return db_[8*node_id + i]; }
+			return cdb_->label(node_id, i);
+		}
 
 		//uint32_t jumppoints_[3];
 		//warthog::cost_t costs_[3];
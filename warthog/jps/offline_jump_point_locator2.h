@@ -5,7 +5,8 @@
 //
 // Variant of warthog::offline_jump_point_locator.
 // Jump points are identified using a pre-computed database that stores
-// distances from each node to jump points in every direction.
+// distances from each node to jump points in every direction
+// (see warthog::jump_point_database).
 // This version additionally prunes all jump points that do not have at
 // least one forced neighbour. 
 //
@@ -13,7 +14,9 @@
 // @created: 05/05/2013
 //
 
+#include "compressed_jump_point_database.h"
 #include "jps.h"
+#include "jump_point_database.h"
 
 namespace warthog
 {
@@ -22,59 +25,70 @@ class gridmap;
 class offline_jump_point_locator2
 {
 	public:
-		offline_jump_point_locator2(warthog::gridmap* map);
+		// with compress set, the jump point database is kept in
+		// compressed form (see compressed_jump_point_database.h)
+		offline_jump_point_locator2(warthog::gridmap* map, bool compress = false);
 		~offline_jump_point_locator2();
 
 		void
 		jump(warthog::jps::direction d, uint32_t node_id, uint32_t goalid, 
-				std::vector<uint32_t>& neighbours, std::vector<warthog::cost_t>& costs);
+				std::vector<warthog::jps::jps_id>& neighbours,
+				std::vector<warthog::cost_t>& costs);
 
 		uint32_t
 		mem()
 		{
-			return sizeof(this) + sizeof(*db_)*dbsize_;
+			return sizeof(this) + (cdb_ ? cdb_->mem() : jpdb_->mem());
 		}
 
 
 	private:
 
-		void
-		preproc();
-
-		bool
-		load(const char* filename);
-
-		void 
-		save(const char* filename);
-
 		void
 		jump_northwest(uint32_t node_id, uint32_t goal_id, 
-				std::vector<uint32_t>& neighbours, std::vector<warthog::cost_t>& costs);
+				std::vector<warthog::jps::jps_id>& neighbours,
+				std::vector<warthog::cost_t>& costs);
 		void
 		jump_northeast(uint32_t node_id, uint32_t goal_id, 
-				std::vector<uint32_t>& neighbours, std::vector<warthog::cost_t>& costs);
+				std::vector<warthog::jps::jps_id>& neighbours,
+				std::vector<warthog::cost_t>& costs);
 		void
 		jump_southwest(uint32_t node_id, uint32_t goal_id, 
-				std::vector<uint32_t>& neighbours, std::vector<warthog::cost_t>& costs);
+				std::vector<warthog::jps::jps_id>& neighbours,
+				std::vector<warthog::cost_t>& costs);
 		void
 		jump_southeast(uint32_t node_id, uint32_t goal_id, 
-				std::vector<uint32_t>& neighbours, std::vector<warthog::cost_t>& costs);
+				std::vector<warthog::jps::jps_id>& neighbours,
+				std::vector<warthog::cost_t>& costs);
 		void
 		jump_north(uint32_t node_id, uint32_t goal_id, warthog::cost_t cost_to_node_id,
-				std::vector<uint32_t>& neighbours, std::vector<warthog::cost_t>& costs);
+				std::vector<warthog::jps::jps_id>& neighbours,
+				std::vector<warthog::cost_t>& costs);
 		void
 		jump_south(uint32_t node_id, uint32_t goal_id, warthog::cost_t cost_to_node_id,
-				std::vector<uint32_t>& neighbours, std::vector<warthog::cost_t>& costs);
+				std::vector<warthog::jps::jps_id>& neighbours,
+				std::vector<warthog::cost_t>& costs);
 		void
 		jump_east(uint32_t node_id, uint32_t goal_id, warthog::cost_t cost_to_node_id,
-				std::vector<uint32_t>& neighbours, std::vector<warthog::cost_t>& costs);
+				std::vector<warthog::jps::jps_id>& neighbours,
+				std::vector<warthog::cost_t>& costs);
 		void
 		jump_west(uint32_t node_id, uint32_t goal_id, warthog::cost_t cost_to_node_id,
-				std::vector<uint32_t>& neighbours, std::vector<warthog::cost_t>& costs);
+				std::vector<warthog::jps::jps_id>& neighbours,
+				std::vector<warthog::cost_t>& costs);
 
 		warthog::gridmap* map_;
-		uint32_t dbsize_;
-		uint16_t* db_;	
+		warthog::jump_point_database* jpdb_;
+		warthog::compressed_jump_point_database* cdb_;
+		const uint16_t* db_;
+
+		// the label of node_id for the direction with index i
+		inline uint16_t
+		get_label(uint32_t node_id, uint32_t i)
+		{
+			if(db_) { return db_[8*node_id + i]; }
+			return cdb_->label(node_id, i);
+		}
 };
 
 }
@@ -5,8 +5,9 @@
 #include <cassert>
 #include <climits>
 
-warthog::online_jump_point_locator2::online_jump_point_locator2(warthog::gridmap* map)
-	: map_(map)//, jumplimit_(UINT32_MAX)
+warthog::online_jump_point_locator2::online_jump_point_locator2(
+		warthog::gridmap* map, bool jump64)
+	: map_(map), jump64_(jump64)//, jumplimit_(UINT32_MAX)
 {
 	rmap_ = create_rmap();
 	current_node_id_ = current_rnode_id_ = warthog::INF;
@@ -53,7 +54,7 @@ warthog::online_jump_point_locator2::create_rmap()
 void
 warthog::online_jump_point_locator2::jump(warthog::jps::direction d,
 	   	uint32_t node_id, uint32_t goal_id, 
-		std::vector<uint32_t>& jpoints,
+		std::vector<warthog::jps::jps_id>& jpoints,
 		std::vector<warthog::cost_t>& costs)
 {
 	// cache node and goal ids so we don't need to convert all the time
@@ -102,7 +103,7 @@ warthog::online_jump_point_locator2::jump(warthog::jps::direction d,
 
 void
 warthog::online_jump_point_locator2::jump_north(
-		std::vector<uint32_t>& jpoints,
+		std::vector<warthog::jps::jps_id>& jpoints,
 		std::vector<warthog::cost_t>& costs)
 {
 	uint32_t rnode_id = current_rnode_id_;
@@ -115,8 +116,7 @@ warthog::online_jump_point_locator2::jump_north(
 	if(jumpnode_id != warthog::INF)
 	{
 		jumpnode_id = current_node_id_ - (jumpcost / warthog::ONE) * map_->width();
-		*(((uint8_t*)&jumpnode_id)+3) = warthog::jps::NORTH;
-		jpoints.push_back(jumpnode_id);
+		jpoints.push_back(warthog::jps::to_jps_id(jumpnode_id, warthog::jps::NORTH));
 		costs.push_back(jumpcost);
 	}
 }
@@ -133,7 +133,7 @@ warthog::online_jump_point_locator2::__jump_north(uint32_t node_id,
 
 void
 warthog::online_jump_point_locator2::jump_south(
-		std::vector<uint32_t>& jpoints, 
+		std::vector<warthog::jps::jps_id>& jpoints, 
 		std::vector<warthog::cost_t>& costs)
 {
 	uint32_t rnode_id = current_rnode_id_;
@@ -146,8 +146,7 @@ warthog::online_jump_point_locator2::jump_south(
 	if(jumpnode_id != warthog::INF)
 	{
 		jumpnode_id = current_node_id_ + (jumpcost / warthog::ONE) * map_->width();
-		*(((uint8_t*)&jumpnode_id)+3) = warthog::jps::SOUTH;
-		jpoints.push_back(jumpnode_id);
+		jpoints.push_back(warthog::jps::to_jps_id(jumpnode_id, warthog::jps::SOUTH));
 		costs.push_back(jumpcost);
 	}
 }
@@ -164,7 +163,7 @@ warthog::online_jump_point_locator2::__jump_south(uint32_t node_id,
 
 void
 warthog::online_jump_point_locator2::jump_east(
-		std::vector<uint32_t>& jpoints, 
+		std::vector<warthog::jps::jps_id>& jpoints, 
 		std::vector<warthog::cost_t>& costs)
 {
 	uint32_t node_id = current_node_id_;
@@ -176,8 +175,7 @@ warthog::online_jump_point_locator2::jump_east(
 
 	if(jumpnode_id != warthog::INF)
 	{
-		*(((uint8_t*)&jumpnode_id)+3) = warthog::jps::EAST;
-		jpoints.push_back(jumpnode_id);
+		jpoints.push_back(warthog::jps::to_jps_id(jumpnode_id, warthog::jps::EAST));
 		costs.push_back(jumpcost);
 	}
 }
@@ -188,6 +186,12 @@ warthog::online_jump_point_locator2::__jump_east(uint32_t node_id,
 		uint32_t goal_id, uint32_t& jumpnode_id, warthog::cost_t& jumpcost, 
 		warthog::gridmap* mymap)
 {
+	if(jump64_)
+	{
+		__jump_east64(node_id, goal_id, jumpnode_id, jumpcost, mymap);
+		return;
+	}
+
 	jumpnode_id = node_id;
 
 	uint32_t neis[3] = {0, 0, 0};
@@ -252,7 +256,7 @@ warthog::online_jump_point_locator2::__jump_east(uint32_t node_id,
 // analogous to ::jump_east 
 void
 warthog::online_jump_point_locator2::jump_west(
-		std::vector<uint32_t>& jpoints, 
+		std::vector<warthog::jps::jps_id>& jpoints, 
 		std::vector<warthog::cost_t>& costs)
 {
 	uint32_t node_id = current_node_id_;
@@ -264,8 +268,7 @@ warthog::online_jump_point_locator2::jump_west(
 
 	if(jumpnode_id != warthog::INF)
 	{
-		*(((uint8_t*)&jumpnode_id)+3) = warthog::jps::WEST;
-		jpoints.push_back(jumpnode_id);
+		jpoints.push_back(warthog::jps::to_jps_id(jumpnode_id, warthog::jps::WEST));
 		costs.push_back(jumpcost);
 	}
 }
@@ -275,6 +278,12 @@ warthog::online_jump_point_locator2::__jump_west(uint32_t node_id,
 		uint32_t goal_id, uint32_t& jumpnode_id, warthog::cost_t& jumpcost, 
 		warthog::gridmap* mymap)
 {
+	if(jump64_)
+	{
+		__jump_west64(node_id, goal_id, jumpnode_id, jumpcost, mymap);
+		return;
+	}
+
 	bool deadend = false;
 	uint32_t neis[3] = {0, 0, 0};
 
@@ -327,9 +336,146 @@ warthog::online_jump_point_locator2::__jump_west(uint32_t node_id,
 	jumpcost = num_steps * warthog::ONE;
 }
 
+// as ::__jump_east, 64 tiles at a time
+void
+warthog::online_jump_point_locator2::__jump_east64(uint32_t node_id, 
+		uint32_t goal_id, uint32_t& jumpnode_id, warthog::cost_t& jumpcost, 
+		warthog::gridmap* mymap)
+{
+	bool deadend = false;
+
+	// most jumps stop within a few tiles. the first step reads only 32
+	// of them, as ::__jump_east does, since that is cheaper.
+	uint32_t neis32[3];
+	mymap->get_neighbours_32bit(node_id, neis32);
+	uint32_t 
+	forced_bits32 = (~neis32[0] << 1) & neis32[0];
+	forced_bits32 |= (~neis32[2] << 1) & neis32[2];
+	uint32_t 
+	deadend_bits32 = ~neis32[1];
+
+	jumpnode_id = node_id;
+	uint32_t stop_bits32 = (forced_bits32 | deadend_bits32);
+	if(stop_bits32)
+	{
+		uint32_t stop_pos = __builtin_ctz(stop_bits32);
+		jumpnode_id += stop_pos; 
+		deadend = deadend_bits32 & (1 << stop_pos);
+	}
+	else
+	{
+		uint64_t neis[3] = {0, 0, 0};
+		jumpnode_id += 31;
+		while(true)
+		{
+			mymap->get_neighbours_64bit(jumpnode_id, neis);
+
+			uint64_t 
+			forced_bits = (~neis[0] << 1) & neis[0];
+			forced_bits |= (~neis[2] << 1) & neis[2];
+			uint64_t 
+			deadend_bits = ~neis[1];
+
+			uint64_t stop_bits = (forced_bits | deadend_bits);
+			if(stop_bits)
+			{
+				uint32_t stop_pos = __builtin_ctzll(stop_bits);
+				jumpnode_id += stop_pos; 
+				deadend = deadend_bits & (1ULL << stop_pos);
+				break;
+			}
+			jumpnode_id += 63;
+		}
+	}
+
+	uint32_t num_steps = jumpnode_id - node_id;
+	uint32_t goal_dist = goal_id - node_id;
+	if(num_steps > goal_dist)
+	{
+		jumpnode_id = goal_id;
+		jumpcost = goal_dist * warthog::ONE;
+		return;
+	}
+
+	if(deadend)
+	{
+		num_steps -= (1 && num_steps);
+		jumpnode_id = warthog::INF;
+	}
+	jumpcost = num_steps * warthog::ONE;
+}
+
+// as ::__jump_west, 64 tiles at a time
+void
+warthog::online_jump_point_locator2::__jump_west64(uint32_t node_id, 
+		uint32_t goal_id, uint32_t& jumpnode_id, warthog::cost_t& jumpcost, 
+		warthog::gridmap* mymap)
+{
+	bool deadend = false;
+
+	// first step: 32 tiles (cf. ::__jump_east64)
+	uint32_t neis32[3];
+	mymap->get_neighbours_upper_32bit(node_id, neis32);
+	uint32_t 
+	forced_bits32 = (~neis32[0] >> 1) & neis32[0];
+	forced_bits32 |= (~neis32[2] >> 1) & neis32[2];
+	uint32_t 
+	deadend_bits32 = ~neis32[1];
+
+	jumpnode_id = node_id;
+	uint32_t stop_bits32 = (forced_bits32 | deadend_bits32);
+	if(stop_bits32)
+	{
+		uint32_t stop_pos = __builtin_clz(stop_bits32);
+		jumpnode_id -= stop_pos;
+		deadend = deadend_bits32 & (0x80000000 >> stop_pos);
+	}
+	else
+	{
+		uint64_t neis[3] = {0, 0, 0};
+		jumpnode_id -= 31;
+		while(true)
+		{
+			mymap->get_neighbours_upper_64bit(jumpnode_id, neis);
+
+			uint64_t 
+			forced_bits = (~neis[0] >> 1) & neis[0];
+			forced_bits |= (~neis[2] >> 1) & neis[2];
+			uint64_t 
+			deadend_bits = ~neis[1];
+
+			uint64_t stop_bits = (forced_bits | deadend_bits);
+			if(stop_bits)
+			{
+				uint32_t stop_pos = __builtin_clzll(stop_bits);
+				jumpnode_id -= stop_pos;
+				deadend = deadend_bits & (0x8000000000000000ULL >> stop_pos);
+				break;
+			}
+			jumpnode_id -= 63;
+		}
+	}
+
+	uint32_t num_steps = node_id - jumpnode_id;
+	uint32_t goal_dist = node_id - goal_id;
+	if(num_steps > goal_dist)
+	{
+		jumpnode_id = goal_id;
+		jumpcost = goal_dist * warthog::ONE;
+ 		return;
+	}
+
+	if(deadend)
+	{
+		num_steps -= (1 && num_steps);
+		jumpnode_id = warthog::INF;
+	}
+	jumpcost = num_steps * warthog::ONE;
+}
+
 void
 warthog::online_jump_point_locator2::jump_northeast(
-		std::vector<uint32_t>& jpoints,
+		std::vector<warthog::jps::jps_id>& jpoints,
 		std::vector<warthog::cost_t>& costs)
 {
 	uint32_t jumpnode_id, jp1_id, jp2_id;
@@ -362,16 +508,14 @@ warthog::online_jump_point_locator2::jump_northeast(
 		if(jp1_id != warthog::INF)
 		{
 			jp1_id = node_id - (jp1_cost / warthog::ONE) * map_->width();
-			*(((uint8_t*)&jp1_id)+3) = warthog::jps::NORTH;
-			jpoints.push_back(jp1_id);
+			jpoints.push_back(warthog::jps::to_jps_id(jp1_id, warthog::jps::NORTH));
 			costs.push_back(cost_to_nodeid + jumpcost + jp1_cost);
 			if(jp2_cost == 0) { break; } // no corner cutting
 		}
 
 		if(jp2_id != warthog::INF)
 		{
-			*(((uint8_t*)&jp2_id)+3) = warthog::jps::EAST;
-			jpoints.push_back(jp2_id);
+			jpoints.push_back(warthog::jps::to_jps_id(jp2_id, warthog::jps::EAST));
 			costs.push_back(cost_to_nodeid + jumpcost + jp2_cost);
 			if(jp1_cost == 0) { break; } // no corner cutting
 		}
@@ -419,7 +563,7 @@ warthog::online_jump_point_locator2::__jump_northeast(
 
 void
 warthog::online_jump_point_locator2::jump_northwest(
-		std::vector<uint32_t>& jpoints,
+		std::vector<warthog::jps::jps_id>& jpoints,
 		std::vector<warthog::cost_t>& costs)
 {
 	uint32_t jumpnode_id, jp1_id, jp2_id;
@@ -452,16 +596,14 @@ warthog::online_jump_point_locator2::jump_northwest(
 		if(jp1_id != warthog::INF)
 		{
 			jp1_id = node_id - (jp1_cost / warthog::ONE) * map_->width();
-			*(((uint8_t*)&jp1_id)+3) = warthog::jps::NORTH;
-			jpoints.push_back(jp1_id);
+			jpoints.push_back(warthog::jps::to_jps_id(jp1_id, warthog::jps::NORTH));
 			costs.push_back(cost_to_nodeid + jumpcost + jp1_cost);
 			if(jp2_cost == 0) { break; } // no corner cutting
 		}
 
 		if(jp2_id != warthog::INF)
 		{
-			*(((uint8_t*)&jp2_id)+3) = warthog::jps::WEST;
-			jpoints.push_back(jp2_id);
+			jpoints.push_back(warthog::jps::to_jps_id(jp2_id, warthog::jps::WEST));
 			costs.push_back(cost_to_nodeid + jumpcost + jp2_cost);
 			if(jp1_cost == 0) { break; } // no corner cutting
 		}
@@ -509,7 +651,7 @@ warthog::online_jump_point_locator2::__jump_northwest(
 
 void
 warthog::online_jump_point_locator2::jump_southeast(
-		std::vector<uint32_t>& jpoints,
+		std::vector<warthog::jps::jps_id>& jpoints,
 		std::vector<warthog::cost_t>& costs)
 {
 	uint32_t jumpnode_id, jp1_id, jp2_id;
@@ -542,16 +684,14 @@ warthog::online_jump_point_locator2::jump_southeast(
 		if(jp1_id != warthog::INF)
 		{
 			jp1_id = node_id + (jp1_cost / warthog::ONE) * map_->width();
-			*(((uint8_t*)&jp1_id)+3) = warthog::jps::SOUTH;
-			jpoints.push_back(jp1_id);
+			jpoints.push_back(warthog::jps::to_jps_id(jp1_id, warthog::jps::SOUTH));
 			costs.push_back(cost_to_nodeid + jumpcost + jp1_cost);
 			if(jp2_cost == 0) { break; } // no corner cutting
 		}
 
 		if(jp2_id != warthog::INF)
 		{
-			*(((uint8_t*)&jp2_id)+3) = warthog::jps::EAST;
-			jpoints.push_back(jp2_id);
+			jpoints.push_back(warthog::jps::to_jps_id(jp2_id, warthog::jps::EAST));
 			costs.push_back(cost_to_nodeid + jumpcost + jp2_cost);
 			if(jp1_cost == 0) { break; } // no corner cutting
 		}
@@ -599,7 +739,7 @@ warthog::online_jump_point_locator2::__jump_southeast(
 
 void
 warthog::online_jump_point_locator2::jump_southwest(
-		std::vector<uint32_t>& jpoints,
+		std::vector<warthog::jps::jps_id>& jpoints,
 		std::vector<warthog::cost_t>& costs)
 {
 	uint32_t jumpnode_id, jp1_id, jp2_id;
@@ -631,16 +771,14 @@ warthog::online_jump_point_locator2::jump_southwest(
 		if(jp1_id != warthog::INF)
 		{
 			jp1_id = node_id + (jp1_cost / warthog::ONE) * map_->width();
-			*(((uint8_t*)&jp1_id)+3) = warthog::jps::SOUTH;
-			jpoints.push_back(jp1_id);
+			jpoints.push_back(warthog::jps::to_jps_id(jp1_id, warthog::jps::SOUTH));
 			costs.push_back(cost_to_nodeid + jumpcost + jp1_cost);
 			if(jp2_cost == 0) { break; }
 		}
 
 		if(jp2_id != warthog::INF)
 		{
-			*(((uint8_t*)&jp2_id)+3) = warthog::jps::WEST;
-			jpoints.push_back(jp2_id);
+			jpoints.push_back(warthog::jps::to_jps_id(jp2_id, warthog::jps::WEST));
 			costs.push_back(cost_to_nodeid + jumpcost + jp2_cost);
 			if(jp1_cost == 0) { break; }
 		}
@@ -23,12 +23,15 @@ namespace warthog
 class online_jump_point_locator2
 {
 	public: 
-		online_jump_point_locator2(warthog::gridmap* map);
+		// with jump64 set, straight jumps (including those made along
+		// the way by diagonal jumps) scan 64 tiles per step instead of 32.
+		// this pays off on maps with long open rows and columns.
+		online_jump_point_locator2(warthog::gridmap* map, bool jump64 = false);
 		~online_jump_point_locator2();
 
 		void
 		jump(warthog::jps::direction d, uint32_t node_id, uint32_t goalid, 
-				std::vector<uint32_t>& jpoints,
+				std::vector<warthog::jps::jps_id>& jpoints,
 				std::vector<warthog::cost_t>& costs);
 
 		uint32_t 
@@ -40,35 +43,35 @@ class online_jump_point_locator2
 	private:
 		void
 		jump_north(
-				std::vector<uint32_t>& jpoints, 
+				std::vector<warthog::jps::jps_id>& jpoints, 
 				std::vector<warthog::cost_t>& costs);
 		void
 		jump_south(
-				std::vector<uint32_t>& jpoints, 
+				std::vector<warthog::jps::jps_id>& jpoints, 
 				std::vector<warthog::cost_t>& costs);
 		void
 		jump_east(
-				std::vector<uint32_t>& jpoints, 
+				std::vector<warthog::jps::jps_id>& jpoints, 
 				std::vector<warthog::cost_t>& costs);
 		void
 		jump_west(
-				std::vector<uint32_t>& jpoints, 
+				std::vector<warthog::jps::jps_id>& jpoints, 
 				std::vector<warthog::cost_t>& costs);
 		void
 		jump_northeast(
-				std::vector<uint32_t>& jpoints, 
+				std::vector<warthog::jps::jps_id>& jpoints, 
 				std::vector<warthog::cost_t>& costs);
 		void
 		jump_northwest(
-				std::vector<uint32_t>& jpoints, 
+				std::vector<warthog::jps::jps_id>& jpoints, 
 				std::vector<warthog::cost_t>& costs);
 		void
 		jump_southeast(
-				std::vector<uint32_t>& jpoints, 
+				std::vector<warthog::jps::jps_id>& jpoints, 
 				std::vector<warthog::cost_t>& costs);
 		void
 		jump_southwest(
-				std::vector<uint32_t>& jpoints, 
+				std::vector<warthog::jps::jps_id>& jpoints, 
 				std::vector<warthog::cost_t>& costs);
 
 		// these versions can be passed a map parameter to
@@ -91,6 +94,16 @@ class online_jump_point_locator2
 				uint32_t& jumpnode_id, warthog::cost_t& jumpcost, 
 				warthog::gridmap* mymap);
 
+		// 64 tile versions of __jump_east and __jump_west
+		void
+		__jump_east64(uint32_t node_id, uint32_t goal_id, 
+				uint32_t& jumpnode_id, warthog::cost_t& jumpcost, 
+				warthog::gridmap* mymap);
+		void
+		__jump_west64(uint32_t node_id, uint32_t goal_id, 
+				uint32_t& jumpnode_id, warthog::cost_t& jumpcost, 
+				warthog::gridmap* mymap);
+
 		// these versions perform a single diagonal jump, returning
 		// the intermediate diagonal jump point and the straight 
 		// jump points that caused the jumping process to stop
@@ -157,6 +170,7 @@ class online_jump_point_locator2
 		warthog::gridmap* map_;
 		warthog::gridmap* rmap_;
 		//uint32_t jumplimit_;
+		bool jump64_;
 
 		uint32_t current_goal_id_;
 		uint32_t current_rgoal_id_;
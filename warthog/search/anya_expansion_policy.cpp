@@ -0,0 +1,435 @@
+#include "anya_expansion_policy.h"
+
+#include <cmath>
+
+namespace
+{
+
+inline bool
+less(int64_t an, int64_t ad, int64_t bn, int64_t bd)
+{
+	return an * bd < bn * ad;
+}
+
+inline int64_t
+floor_div(int64_t n, int64_t d)
+{
+	int64_t q = n / d;
+	return (q * d > n) ? q - 1 : q;
+}
+
+inline int64_t
+ceil_div(int64_t n, int64_t d)
+{
+	return -floor_div(-n, d);
+}
+
+}
+
+warthog::anya_expansion_policy::anya_expansion_policy(warthog::gridmap* map)
+{
+	map_ = map;
+	nodepool_ = new warthog::blocklist(map->height(), map->width());
+	id_offset_ = map->to_padded_id(0);
+	width_ = map->width();
+	num_wedge_ = 0;
+	reset();
+
+	neighbours_.reserve(100);
+	costs_.reserve(100);
+	intervals_.reserve(100);
+}
+
+warthog::anya_expansion_policy::~anya_expansion_policy()
+{
+	delete nodepool_;
+}
+
+void
+warthog::anya_expansion_policy::expand(
+		warthog::search_node* current, warthog::problem_instance* problem)
+{
+	reset();
+
+	to_xy(current->get_id(), rx_, ry_);
+	goal_id_ = problem->get_goal();
+	to_xy(goal_id_, gx_, gy_);
+	uint32_t convex, dbl;
+	corners(gx_, gy_, convex, dbl);
+	goal_is_corner_ = convex & 1;
+	goal_is_double_ = dbl & 1;
+	set_wedge(current);
+
+	scan_flat(1);
+	scan_flat(-1);
+	scan_vertical(1);
+	scan_vertical(-1);
+	sweep(1);
+	sweep(-1);
+
+	num_neighbours_ = neighbours_.size();
+
+	// terminator
+	neighbours_.push_back(0);
+	costs_.push_back(0);
+}
+
+void
+warthog::anya_expansion_policy::set_wedge(warthog::search_node* current)
+{
+	num_wedge_ = 0;
+	warthog::search_node* parent = current->get_parent();
+	if(!parent)
+	{
+		// a start on a double corner is in the tile to its south-east;
+		// keep to that quadrant (east or south, or in between)
+		uint32_t convex, dbl;
+		corners(rx_, ry_, convex, dbl);
+		if(dbl & 1)
+		{
+			wsign_[0] = 1;
+			wdir_x_[0] = 1;
+			wdir_y_[0] = 0;
+			wsign_[1] = -1;
+			wdir_x_[1] = 0;
+			wdir_y_[1] = 1;
+			num_wedge_ = 2;
+		}
+		return;
+	}
+
+	// the direction of travel into the root, and which quadrant around
+	// the root is blocked
+	int32_t px, py;
+	to_xy(parent->get_id(), px, py);
+	int32_t dx = rx_ - px;
+	int32_t dy = ry_ - py;
+	int32_t qx = 1, qy = 1;
+	if(!traversable(rx_-1, ry_-1)) { qx = -1; qy = -1; }
+	else if(!traversable(rx_, ry_-1)) { qy = -1; }
+	else if(!traversable(rx_-1, ry_)) { qx = -1; }
+
+	// the path bends toward the obstacle, from straight ahead until it
+	// runs along the first edge of the blocked cell it meets
+	int32_t side = dx * qy - dy * qx;
+	if(side == 0) { return; }
+	side = side > 0 ? 1 : -1;
+	wsign_[0] = side;
+	wdir_x_[0] = dx;
+	wdir_y_[0] = dy;
+	wsign_[1] = -side;
+	wdir_x_[1] = (side * qx * qy > 0) ? qx : 0;
+	wdir_y_[1] = (side * qx * qy > 0) ? 0 : qy;
+	num_wedge_ = 2;
+}
+
+int32_t
+warthog::anya_expansion_policy::first_blocked_right(int32_t x, int32_t y)
+{
+	uint32_t tiles[3];
+	while(true)
+	{
+		map_->get_neighbours_32bit(id(x, y), tiles);
+		uint32_t blocked = ~tiles[1];
+		if(blocked) { return x + __builtin_ctz(blocked); }
+		x += 32;
+	}
+}
+
+int32_t
+warthog::anya_expansion_policy::first_blocked_left(int32_t x, int32_t y)
+{
+	uint32_t tiles[3];
+	while(true)
+	{
+		map_->get_neighbours_upper_32bit(id(x, y), tiles);
+		uint32_t blocked = ~tiles[1];
+		if(blocked) { return x - __builtin_clz(blocked); }
+		x -= 32;
+	}
+}
+
+int32_t
+warthog::anya_expansion_policy::first_free_right(
+		int32_t x, int32_t y, int32_t limit)
+{
+	uint32_t tiles[3];
+	for( ; x <= limit; x += 32)
+	{
+		map_->get_neighbours_32bit(id(x, y), tiles);
+		if(tiles[1]) { return x + __builtin_ctz(tiles[1]); }
+	}
+	return limit + 1;
+}
+
+void
+warthog::anya_expansion_policy::corners(
+		int32_t x, int32_t y, uint32_t& convex, uint32_t& dbl)
+{
+	// bit i of each mask is set if the cell to the north-west, north-east,
+	// south-west or south-east of corner (x+i, y) is blocked
+	uint32_t tiles[3];
+	map_->get_neighbours_32bit(id(x-1, y), tiles);
+	uint32_t nw = ~tiles[0];
+	uint32_t ne = nw >> 1;
+	uint32_t sw = ~tiles[1];
+	uint32_t se = sw >> 1;
+
+	uint32_t above = nw ^ ne;
+	uint32_t below = sw ^ se;
+	convex = (above ^ below) & ~(nw & ne) & ~(sw & se) & 0x7fffffff;
+	dbl = ((nw & se & ~ne & ~sw) | (ne & sw & ~nw & ~se)) & 0x7fffffff;
+}
+
+void
+warthog::anya_expansion_policy::add_successor(int32_t x, int32_t y)
+{
+	// likewise, a goal on a double corner can only be reached from the
+	// tile to its south-east
+	if(goal_is_double_ && id(x, y) == goal_id_ && (rx_ < x || ry_ < y))
+	{
+		return;
+	}
+
+	double dx = x - rx_;
+	double dy = y - ry_;
+	neighbours_.push_back(nodepool_->generate(id(x, y)));
+	costs_.push_back(sqrt(dx*dx + dy*dy) * warthog::ONE + 0.5);
+}
+
+void
+warthog::anya_expansion_policy::add_corner(int32_t x, int32_t y)
+{
+	if(id(x, y) == goal_id_)
+	{
+		add_successor(x, y);
+		return;
+	}
+
+	int32_t qx = 1, qy = 1;
+	if(!traversable(x-1, y-1)) { qx = -1; qy = -1; }
+	else if(!traversable(x, y-1)) { qy = -1; }
+	else if(!traversable(x-1, y)) { qx = -1; }
+
+	// a path from the root can only bend around the blocked cell if the
+	// ray from the root, carried on past the corner, misses it
+	int32_t dx = x - rx_;
+	int32_t dy = y - ry_;
+	if((dx == 0 || (dx > 0) == (qx > 0)) && (dy == 0 || (dy > 0) == (qy > 0)))
+	{
+		return;
+	}
+	add_successor(x, y);
+}
+
+void
+warthog::anya_expansion_policy::add_line(int32_t y, int32_t xlo, int32_t xhi)
+{
+	for(int32_t x = xlo; x <= xhi; x += 31)
+	{
+		uint32_t convex, dbl;
+		corners(x, y, convex, dbl);
+		if(xhi - x < 30)
+		{
+			convex &= (1u << (xhi - x + 1)) - 1;
+		}
+		while(convex)
+		{
+			int32_t cx = x + __builtin_ctz(convex);
+			convex &= convex - 1;
+			// points on the root's column are left to scan_vertical
+			if(cx != rx_) { add_corner(cx, y); }
+		}
+	}
+
+	if(!goal_is_corner_ && gy_ == y && gx_ >= xlo && gx_ <= xhi && gx_ != rx_)
+	{
+		add_successor(gx_, gy_);
+	}
+}
+
+void
+warthog::anya_expansion_policy::scan_flat(int32_t dx)
+{
+	if(!in_wedge(dx, 0)) { return; }
+
+	// the edge between two corners of row ry_ can be followed if there is
+	// a traversable cell on either side; a double corner can be reached
+	// but not passed.
+	uint32_t tiles[3];
+	int32_t y = ry_;
+	if(dx > 0)
+	{
+		// bit i: the edge from x+i to x+i+1 and corner x+i+1
+		for(int32_t x = rx_; ; x += 31)
+		{
+			map_->get_neighbours_32bit(id(x, y), tiles);
+			uint32_t convex, dbl;
+			corners(x+1, y, convex, dbl);
+			uint32_t stop = ~(tiles[0] | tiles[1]) | (dbl << 1);
+			uint32_t n = stop ? __builtin_ctz(stop) : 32;
+			uint32_t m = n < 31 ? n : 31;
+			convex &= (1u << m) - 1;
+			while(convex)
+			{
+				add_corner(x + 1 + __builtin_ctz(convex), y);
+				convex &= convex - 1;
+			}
+			if(!goal_is_corner_ && gy_ == y && gx_ > x && gx_ <= x + (int32_t)m)
+			{
+				add_successor(gx_, gy_);
+			}
+			if(n < 32) { break; }
+		}
+	}
+	else
+	{
+		// bit 31-i: the edge from x-i to x-i-1 and corner x-i-1
+		for(int32_t x = rx_; ; x -= 31)
+		{
+			map_->get_neighbours_upper_32bit(id(x-1, y), tiles);
+			uint32_t ne = ~tiles[0];
+			uint32_t nw = ne << 1;
+			uint32_t se = ~tiles[1];
+			uint32_t sw = se << 1;
+			uint32_t above = nw ^ ne;
+			uint32_t below = sw ^ se;
+			uint32_t convex = (above ^ below) & ~(nw & ne) & ~(sw & se);
+			uint32_t dbl = (nw & se & ~ne & ~sw) | (ne & sw & ~nw & ~se);
+
+			uint32_t stop = ~(tiles[0] | tiles[1]) | (dbl >> 1);
+			uint32_t n = stop ? __builtin_clz(stop) : 32;
+			uint32_t m = n < 31 ? n : 31;
+			convex = m ? convex & ~((1u << (32 - m)) - 1) : 0;
+			while(convex)
+			{
+				add_corner(x - 32 + __builtin_ctz(convex), y);
+				convex &= convex - 1;
+			}
+			if(!goal_is_corner_ && gy_ == y && gx_ < x && gx_ >= x - (int32_t)m)
+			{
+				add_successor(gx_, gy_);
+			}
+			if(n < 32) { break; }
+		}
+	}
+}
+
+void
+warthog::anya_expansion_policy::scan_vertical(int32_t dy)
+{
+	if(!in_wedge(0, dy)) { return; }
+
+	for(int32_t k = 1; ; k++)
+	{
+		int32_t row = dy > 0 ? ry_ + k - 1 : ry_ - k;
+		if(!traversable(rx_-1, row) && !traversable(rx_, row)) { break; }
+
+		int32_t y = ry_ + dy * k;
+		uint32_t convex, dbl;
+		corners(rx_, y, convex, dbl);
+		if(convex & 1)
+		{
+			add_corner(rx_, y);
+		}
+		else if(gx_ == rx_ && gy_ == y)
+		{
+			add_successor(gx_, gy_);
+		}
+		if(dbl & 1) { break; }
+	}
+}
+
+void
+warthog::anya_expansion_policy::sweep(int32_t dy)
+{
+	intervals_.clear();
+	fraction none = {0, 1};
+	project(dy, 0, none, none);
+	while(intervals_.size())
+	{
+		interval iv = intervals_.back();
+		intervals_.pop_back();
+
+		// the points of line k that the interval's rays reach
+		int64_t k = iv.k;
+		int32_t xlo = ceil_div(rx_ * iv.lo.d + iv.lo.n * k, iv.lo.d);
+		int32_t xhi = floor_div(rx_ * iv.hi.d + iv.hi.n * k, iv.hi.d);
+		add_line(ry_ + dy * iv.k, xlo, xhi);
+
+		project(dy, iv.k, iv.lo, iv.hi);
+	}
+}
+
+void
+warthog::anya_expansion_policy::project(
+		int32_t dy, int32_t k, fraction lo, fraction hi)
+{
+	int32_t row = dy > 0 ? ry_ + k : ry_ - k - 1;
+
+	// the cells of the row just past line k, where the rays cross it
+	int32_t c0, c1;
+	if(k == 0)
+	{
+		c0 = rx_ - 1;
+		c1 = rx_;
+	}
+	else
+	{
+		c0 = floor_div(rx_ * lo.d + lo.n * k, lo.d);
+		c1 = ceil_div(rx_ * hi.d + hi.n * k, hi.d) - 1;
+	}
+
+	// each span of traversable cells [left, right) lets through the rays
+	// that are inside it both at line k and at line k+1
+	int32_t c = first_free_right(c0, row, c1);
+	while(c <= c1)
+	{
+		int32_t left = (c == c0) ? first_blocked_left(c, row) + 1 : c;
+		int32_t right = first_blocked_right(c, row);
+
+		fraction nlo = {left - rx_, k + 1};
+		fraction nhi = {right - rx_, k + 1};
+		if(k == 0)
+		{
+			// the first row: clip to the taut wedge instead. a ray with
+			// slope t heads in direction (t, dy)
+			for(uint32_t i = 0; i < num_wedge_; i++)
+			{
+				int64_t wx = wdir_x_[i];
+				int64_t wy = wdir_y_[i];
+				if(wy == 0)
+				{
+					if(wsign_[i] * wx * dy < 0) { nhi = nlo; }
+					continue;
+				}
+				fraction bound = {wx * dy, wy};
+				if(wy < 0) { bound.n = -bound.n; bound.d = -bound.d; }
+				if(wsign_[i] * wy > 0)
+				{
+					if(less(bound.n, bound.d, nhi.n, nhi.d)) { nhi = bound; }
+				}
+				else
+				{
+					if(less(nlo.n, nlo.d, bound.n, bound.d)) { nlo = bound; }
+				}
+			}
+		}
+		else
+		{
+			if(left - rx_ > 0) { nlo.d = k; }
+			if(right - rx_ < 0) { nhi.d = k; }
+			if(less(nlo.n, nlo.d, lo.n, lo.d)) { nlo = lo; }
+			if(less(hi.n, hi.d, nhi.n, nhi.d)) { nhi = hi; }
+		}
+
+		// a single ray runs through a double corner; rays along the
+		// root's column are left to scan_vertical
+		if(less(nlo.n, nlo.d, nhi.n, nhi.d))
+		{
+			interval iv = {k + 1, nlo, nhi};
+			intervals_.push_back(iv);
+		}
+		c = first_free_right(right, row, c1);
+	}
+}
@@ -0,0 +1,249 @@
+#ifndef WARTHOG_ANYA_EXPANSION_POLICY_H
+#define WARTHOG_ANYA_EXPANSION_POLICY_H
+
+// anya_expansion_policy.h
+//
+// Optimal any-angle search on uniform-cost grids, after the Anya
+// algorithm of Harabor, Grastien, Oz and Aksakalli (JAIR 2016).
+//
+// Paths run between the corners of grid cells rather than their centres.
+// A path may follow the edge between a traversable and a blocked cell but
+// it may not squeeze through a double corner (a point touching two
+// diagonally adjacent obstacles). Each node is a root: the start, the goal
+// or a convex corner (a point touching exactly one blocked cell) at which
+// an optimal path can turn.
+//
+// Anya proper searches over intervals of points seen from a root. To fit
+// flexible_astar, which needs every node to have an id, this policy instead
+// expands each root in one go: it projects the root's intervals row by row,
+// upward and downward, as Anya does, and generates every convex corner
+// (and the goal) inside them, with its straight-line cost. Intervals are
+// bounded by rays through grid points and kept as exact fractions.
+// Free spans of each row are found 32 tiles at a time with
+// gridmap::get_neighbours_32bit.
+//
+// Two rules from Anya keep the number of successors down:
+//  - a corner is only generated if the path can bend around its obstacle,
+//    i.e. the ray from the root does not run into the blocked cell;
+//  - a root only projects into its taut wedge: the directions between the
+//    ray from its parent and the first edge of the obstacle it bends around.
+//
+// Node ids are padded ids: corner (x, y) has the id of the cell whose
+// top-left corner it is, so the start and goal tiles of a scenario stand
+// for their top-left corners. As in Polyanya, a start or goal on a double
+// corner belongs to the tile to its south-east. Costs are euclidean
+// distances; use with warthog::euclidean_heuristic.
+//
+// @created: 18/10/2026
+//
+
+#include "blocklist.h"
+#include "gridmap.h"
+#include "problem_instance.h"
+#include "search_node.h"
+
+#include "stdint.h"
+#include <vector>
+
+namespace warthog
+{
+
+class anya_expansion_policy
+{
+	public:
+		anya_expansion_policy(warthog::gridmap* map);
+		~anya_expansion_policy();
+
+		// create a warthog::search_node object from a state description
+		// (in this case, an id)
+		inline warthog::search_node*
+		generate(uint32_t node_id)
+		{
+			return nodepool_->generate(node_id);
+		}
+
+		// reset the policy and discard all generated nodes
+		inline void
+		clear()
+		{
+			reset();
+			nodepool_->clear();
+		}
+
+		void
+		expand(warthog::search_node*, warthog::problem_instance*);
+
+		inline void
+		first(warthog::search_node*& ret, warthog::cost_t& cost)
+		{
+			which_ = 0;
+			ret = neighbours_[which_];
+			cost = costs_[which_];
+		}
+
+		inline void
+		next(warthog::search_node*& ret, warthog::cost_t& cost)
+		{
+			if(which_ < num_neighbours_)
+			{
+				which_++;
+			}
+			ret = neighbours_[which_];
+			cost = costs_[which_];
+		}
+
+		inline uint32_t
+		mem()
+		{
+			return sizeof(*this) + map_->mem() + nodepool_->mem() +
+				sizeof(interval) * intervals_.capacity();
+		}
+
+		uint32_t
+		mapwidth()
+		{
+			return map_->width();
+		}
+
+	private:
+		// a fraction n/d with d > 0. the slope (change in x per row) of a
+		// ray from the root.
+		struct fraction
+		{
+			int64_t n;
+			int64_t d;
+		};
+
+		// the rays from the root with slopes in [lo, hi], which are
+		// unobstructed up to the k-th grid line from the root
+		struct interval
+		{
+			int32_t k;
+			fraction lo;
+			fraction hi;
+		};
+
+		warthog::gridmap* map_;
+		warthog::blocklist* nodepool_;
+		uint32_t which_;
+		uint32_t num_neighbours_;
+		std::vector<warthog::search_node*> neighbours_;
+		std::vector<warthog::cost_t> costs_;
+		std::vector<interval> intervals_;
+
+		// padded id of the cell (0, 0)
+		int32_t id_offset_;
+		int32_t width_;
+
+		// the root being expanded and the goal
+		int32_t rx_, ry_;
+		int32_t gx_, gy_;
+		uint32_t goal_id_;
+		bool goal_is_corner_;
+		bool goal_is_double_;
+
+		// the taut wedge of the root: directions e with
+		// wsign_[i] * cross(wdir_[i], e) >= 0 for each i < num_wedge_
+		uint32_t num_wedge_;
+		int32_t wsign_[2];
+		int32_t wdir_x_[2];
+		int32_t wdir_y_[2];
+
+		inline void
+		reset()
+		{
+			which_ = 0;
+			num_neighbours_ = 0;
+			neighbours_.clear();
+			costs_.clear();
+		}
+
+		inline uint32_t
+		id(int32_t x, int32_t y)
+		{
+			return id_offset_ + y * width_ + x;
+		}
+
+		inline void
+		to_xy(uint32_t id, int32_t& x, int32_t& y)
+		{
+			x = (id - id_offset_) % width_;
+			y = (id - id_offset_) / width_;
+		}
+
+		inline bool
+		traversable(int32_t x, int32_t y)
+		{
+			return map_->get_label(id(x, y));
+		}
+
+		inline bool
+		in_wedge(int32_t ex, int32_t ey)
+		{
+			for(uint32_t i = 0; i < num_wedge_; i++)
+			{
+				int64_t cross = (int64_t)wdir_x_[i] * ey -
+					(int64_t)wdir_y_[i] * ex;
+				if(wsign_[i] * cross < 0) { return false; }
+			}
+			return true;
+		}
+
+		// the first blocked cell in row y at or to the right of x
+		// (to the left of x, for the second); the padding always stops
+		// the scan at the edge of the map
+		int32_t
+		first_blocked_right(int32_t x, int32_t y);
+
+		int32_t
+		first_blocked_left(int32_t x, int32_t y);
+
+		// the first traversable cell in row y from x to limit, or
+		// limit+1 if there is none
+		int32_t
+		first_free_right(int32_t x, int32_t y, int32_t limit);
+
+		// bit i is set if corner (x+i, y) touches exactly one blocked cell
+		// (for i < 31); bit i of dbl is set if corner (x+i, y) is a double
+		// corner
+		void
+		corners(int32_t x, int32_t y, uint32_t& convex, uint32_t& dbl);
+
+		void
+		set_wedge(warthog::search_node* current);
+
+		// generates the convex corner (x, y) unless no taut path from the
+		// root bends there
+		void
+		add_corner(int32_t x, int32_t y);
+
+		void
+		add_successor(int32_t x, int32_t y);
+
+		// the points along grid line y between xlo and xhi
+		void
+		add_line(int32_t y, int32_t xlo, int32_t xhi);
+
+		// along the root's row, to the east (dx = 1) or west (dx = -1)
+		void
+		scan_flat(int32_t dx);
+
+		// along the root's column, down (dy = 1) or up (dy = -1)
+		void
+		scan_vertical(int32_t dy);
+
+		// projects the intervals of the root row by row, down (dy = 1) or
+		// up (dy = -1)
+		void
+		sweep(int32_t dy);
+
+		// turns the rays in [lo, hi] that pass through row k of the sweep
+		// (between lines k and k+1) into intervals of line k+1
+		void
+		project(int32_t dy, int32_t k, fraction lo, fraction hi);
+};
+
+}
+
+#endif
+
@@ -0,0 +1,355 @@
+#ifndef BIDIRECTIONAL_ASTAR_H
+#define BIDIRECTIONAL_ASTAR_H
+
+// bidirectional_astar.h
+//
+// Bidirectional A*, for the same combinations of heuristic functions and
+// expansion policies as warthog::flexible_astar, and with the same
+// interface. One search runs forward from the start to the goal and the
+// other backward from the goal to the start; each step expands a node
+// from whichever side has the smaller open list.
+//
+// Moves on uniform-cost grids without corner cutting are symmetric, so
+// the backward search is just a forward search from the goal. This also
+// holds for jump point search: jumps in the backward search stop at the
+// start instead of the goal, and the rules are otherwise unchanged.
+//
+// Whenever one side reaches a node with a better g-value it looks the
+// node up on the other side; if both have reached it, it joins a path
+// from start to goal of cost g_forward + g_backward. The search stops
+// once the best such path costs no more than the smallest f-value on
+// one of the open lists; with an admissible heuristic, that side can
+// then no longer find a shorter path. Nodes whose f-value is no less
+// than the cost of the best path so far are not added to the open
+// lists.
+// [Pohl, Bi-directional Search, Machine Intelligence 6, 1971]
+//
+// Each side needs its own expansion policy, since the nodes of a policy
+// store the g-values of one search.
+//
+// @created: 18/10/2026
+//
+
+#include "pqueue.h"
+#include "problem_instance.h"
+#include "search_node.h"
+#include "timer.h"
+
+#include <algorithm>
+#include <iostream>
+#include <stack>
+#include <vector>
+
+namespace warthog
+{
+
+// H is a heuristic function
+// E is an expansion policy
+// Q is the open list; warthog::pqueue or warthog::radix_heap
+template <class H, class E, class Q = warthog::pqueue>
+class bidirectional_astar
+{
+	public:
+		bidirectional_astar(H* heuristic, E* forward, E* backward)
+			: heuristic_(heuristic), fexpander_(forward), bexpander_(backward)
+		{
+			fopen_ = new Q(1024);
+			bopen_ = new Q(1024);
+			searchid_ = 0;
+			verbose_ = false;
+			hscale_ = 1.0;
+		}
+
+		~bidirectional_astar()
+		{
+			cleanup();
+			delete fopen_;
+			delete bopen_;
+		}
+
+		inline std::stack<uint32_t>
+		get_path(uint32_t startid, uint32_t goalid)
+		{
+			std::stack<uint32_t> path;
+			if(search(startid, goalid))
+			{
+				// the nodes from the meeting point to the goal, in reverse,
+				// then those from the meeting point back to the start
+				std::vector<uint32_t> tail;
+				for(warthog::search_node* cur = bmeet_->get_parent();
+						cur != 0;
+						cur = cur->get_parent())
+				{
+					tail.push_back(cur->get_id());
+				}
+				for(uint32_t i = tail.size(); i > 0; i--)
+				{
+					path.push(tail[i-1]);
+				}
+				for(warthog::search_node* cur = fmeet_;
+						cur != 0;
+					    cur = cur->get_parent())
+				{
+					path.push(cur->get_id());
+				}
+				assert(path.top() == startid);
+			}
+			cleanup();
+			return path;
+		}
+
+		double
+		get_length(uint32_t startid, uint32_t goalid)
+		{
+			warthog::cost_t len = warthog::INF;
+			if(search(startid, goalid))
+			{
+				len = best_;
+			}
+			cleanup();
+			return len / (double)warthog::ONE;
+		}
+
+		inline size_t
+		mem()
+		{
+			size_t bytes =
+				// memory for the priority queues
+				fopen_->mem() + bopen_->mem() +
+				// gridmap size and other stuff needed to expand nodes
+				fexpander_->mem() + bexpander_->mem() +
+				// misc
+				sizeof(*this);
+			return bytes;
+		}
+
+		inline uint32_t
+		get_nodes_expanded() { return nodes_expanded_; }
+
+		inline uint32_t
+		get_nodes_generated() { return nodes_generated_; }
+
+		inline uint32_t
+		get_nodes_touched() { return nodes_touched_; }
+
+		inline double
+		get_search_time() { return search_time_; }
+
+		inline bool
+		get_verbose() { return verbose_; }
+
+		inline void
+		set_verbose(bool verbose) { verbose_ = verbose; }
+
+		inline double
+		get_hscale() { return hscale_; }
+
+		inline void
+		set_hscale(double hscale) { hscale_ = hscale; }
+
+	private:
+		H* heuristic_;
+		E* fexpander_;
+		E* bexpander_;
+		Q* fopen_;
+		Q* bopen_;
+		bool verbose_;
+		uint32_t searchid_; // per instance, so instances can run in parallel
+		uint32_t nodes_expanded_;
+		uint32_t nodes_generated_;
+		uint32_t nodes_touched_;
+		double search_time_;
+		double hscale_; // heuristic scaling factor
+
+		// the best path found so far: its cost and the node where the
+		// two searches meet, on either side
+		warthog::cost_t best_;
+		warthog::search_node* fmeet_;
+		warthog::search_node* bmeet_;
+
+		// no copy
+		bidirectional_astar(const bidirectional_astar& other) { }
+		bidirectional_astar&
+		operator=(const bidirectional_astar& other) { return *this; }
+
+		// @return true if there is a path from startid to goalid
+		bool
+		search(uint32_t startid, uint32_t goalid)
+		{
+			nodes_expanded_ = nodes_generated_ = nodes_touched_ = 0;
+			search_time_ = 0;
+			best_ = warthog::INF;
+			fmeet_ = bmeet_ = 0;
+
+			warthog::timer mytimer;
+			mytimer.start();
+
+			#ifndef NDEBUG
+			if(verbose_)
+			{
+				std::cerr << "search: startid="<<startid<<" goalid=" <<goalid
+					<< std::endl;
+			}
+			#endif
+
+			warthog::problem_instance forward;
+			forward.set_start(startid);
+			forward.set_goal(goalid);
+			forward.set_searchid(searchid_);
+
+			warthog::problem_instance backward;
+			backward.set_start(goalid);
+			backward.set_goal(startid);
+			backward.set_searchid(searchid_++);
+
+			warthog::search_node* start = fexpander_->generate(startid);
+			start->reset(forward.get_searchid());
+			start->set_g(0);
+			start->set_f(heuristic_->h(startid, goalid) * hscale_);
+			fopen_->push(start);
+
+			warthog::search_node* goal = bexpander_->generate(goalid);
+			goal->reset(backward.get_searchid());
+			goal->set_g(0);
+			goal->set_f(heuristic_->h(goalid, startid) * hscale_);
+			bopen_->push(goal);
+
+			if(startid == goalid)
+			{
+				best_ = 0;
+				fmeet_ = start;
+				bmeet_ = goal;
+			}
+
+			while(true)
+			{
+				warthog::search_node* fnext = fopen_->peek();
+				warthog::search_node* bnext = bopen_->peek();
+				if(fnext == 0 || bnext == 0 ||
+						best_ <= std::max(fnext->get_f(), bnext->get_f()))
+				{
+					break;
+				}
+
+				if(fopen_->size() <= bopen_->size())
+				{
+					expand(fopen_, fexpander_, bexpander_, &forward, true);
+				}
+				else
+				{
+					expand(bopen_, bexpander_, fexpander_, &backward, false);
+				}
+			}
+
+			mytimer.stop();
+			search_time_ = mytimer.elapsed_time_micro();
+			return best_ != warthog::INF;
+		}
+
+		// expands the best node on one side: open and expander belong to
+		// it, other is the expansion policy of the opposite side.
+		void
+		expand(Q* open, E* expander, E* other,
+				warthog::problem_instance* instance, bool forward)
+		{
+			nodes_touched_++;
+			nodes_expanded_++;
+
+			warthog::search_node* current = open->pop();
+			#ifndef NDEBUG
+			if(verbose_) { trace("expanding", current, forward); }
+			#endif
+			current->set_expanded(true); // NB: set this before calling expander
+			expander->expand(current, instance);
+
+			uint32_t target = instance->get_goal();
+			warthog::search_node* n = 0;
+			warthog::cost_t cost_to_n = warthog::INF;
+			for(expander->first(n, cost_to_n);
+					n != 0;
+				   	expander->next(n, cost_to_n))
+			{
+				nodes_touched_++;
+				if(n->get_expanded())
+				{
+					// skip neighbours already expanded
+					continue;
+				}
+
+				warthog::cost_t gval = current->get_g() + cost_to_n;
+				if(gval >= n->get_g())
+				{
+					// no better than the path we already know
+					continue;
+				}
+
+				if(open->contains(n))
+				{
+					// update a node from the fringe
+					n->relax(gval, current);
+					open->decrease_key(n);
+					#ifndef NDEBUG
+					if(verbose_) { trace("  updating", n, forward); }
+					#endif
+				}
+				else
+				{
+					// add a new node to the fringe, unless it cannot lead
+					// to a shorter path than the best one so far
+					if(n->get_g() == warthog::INF) { nodes_generated_++; }
+					n->set_g(gval);
+					n->set_f(gval + heuristic_->h(n->get_id(), target) * hscale_);
+				   	n->set_parent(current);
+					if(n->get_f() < best_)
+					{
+						open->push(n);
+					}
+					#ifndef NDEBUG
+					if(verbose_) { trace("  generating", n, forward); }
+					#endif
+				}
+
+				// has the other side reached n too? (some node pools keep
+				// their nodes between searches; a node from an earlier
+				// search has a different searchid). NB: written so that
+				// adding the g-values cannot overflow
+				warthog::search_node* m = other->generate(n->get_id());
+				if(m->get_searchid() == instance->get_searchid() &&
+						gval < best_ && m->get_g() < best_ - gval)
+				{
+					best_ = gval + m->get_g();
+					fmeet_ = forward ? n : m;
+					bmeet_ = forward ? m : n;
+					#ifndef NDEBUG
+					if(verbose_) { trace("  meeting at", n, forward); }
+					#endif
+				}
+			}
+		}
+
+		void
+		trace(const char* event, warthog::search_node* n, bool forward)
+		{
+			uint32_t x, y;
+			y = (n->get_id() / fexpander_->mapwidth());
+			x = n->get_id() % fexpander_->mapwidth();
+			std::cerr << event << " ("<<x<<", "<<y<<") "
+				<< (forward ? "forward" : "backward") << "...";
+			n->print(std::cerr);
+			std::cerr << std::endl;
+		}
+
+		void
+		cleanup()
+		{
+			fopen_->clear();
+			bopen_->clear();
+			fexpander_->clear();
+			bexpander_->clear();
+		}
+};
+
+}
+
+#endif
+
@@ -6,7 +6,8 @@
 // A* implementation that allows arbitrary combinations of 
 // (weighted) heuristic functions and node expansion policies.
 // This implementation uses a binary heap for the open_ list
-// and a bit array for the closed_ list.
+// (unless another is given; see below) and a bit array for the 
+// closed_ list.
 //
 // TODO: is it better to store a separate closed list and ungenerate nodes
 // or use more memory and not ungenerate until the end of search??
@@ -31,14 +32,16 @@ namespace warthog
 
 // H is a heuristic function
 // E is an expansion policy
-template <class H, class E>
+// Q is the open list; warthog::pqueue or warthog::radix_heap
+template <class H, class E, class Q = warthog::pqueue>
 class flexible_astar 
 {
 	public:
 		flexible_astar(H* heuristic, E* expander)
 			: heuristic_(heuristic), expander_(expander)
 		{
-			open_ = new warthog::pqueue(1024, true);
+			open_ = new Q(1024);
+			searchid_ = 0;
 			verbose_ = false;
             hscale_ = 1.0;
 		}
@@ -153,9 +156,9 @@ class flexible_astar
 	private:
 		H* heuristic_;
 		E* expander_;
-		warthog::pqueue* open_;
+		Q* open_;
 		bool verbose_;
-		static uint32_t searchid_;
+		uint32_t searchid_; // per instance, so instances can run in parallel
 		uint32_t nodes_expanded_;
 		uint32_t nodes_generated_;
 		uint32_t nodes_touched_;
@@ -332,9 +335,6 @@ class flexible_astar
 
 };
 
-template <class H, class E>
-uint32_t warthog::flexible_astar<H, E>::searchid_ = 0;
-
 }
 
 #endif
@@ -1,3 +1,3 @@
 #include "search_node.h"
 
-unsigned int warthog::search_node::refcount_ = 0;
+thread_local uint32_t warthog::search_node::refcount_ = 0;
@@ -16,16 +16,15 @@
 namespace warthog
 {
 	
-const uint32_t NODEID_AND_STATUS_MASK = (1 << 24) - 1;
-const uint32_t STATUS_MASK = 1;
 class search_node
 {
 	public:
 		search_node(uint32_t id) 
-			: id_and_status_(id << 1), f_(warthog::INF), g_(warthog::INF), parent_(0), 
+			: id_(id), expanded_(0), pdir_(warthog::jps::NONE), 
+			f_(warthog::INF), g_(warthog::INF), parent_(0), 
 			priority_(warthog::INF), searchid_(0)
 		{
-			assert(this->get_id() < ((1ul<<31)-1));
+			assert(id != warthog::INF);
 			refcount_++;
 		}
 
@@ -37,7 +36,7 @@ class search_node
 		inline void
 		reset(uint32_t searchid)
 		{
-			id_and_status_ &= ~1;
+			expanded_ = 0;
 			f_ = g_ = warthog::INF;
 			parent_ = 0;
 			priority_ = warthog::INF;
@@ -59,37 +58,28 @@ class search_node
 		}
 
 		inline uint32_t 
-		get_id() const { return (id_and_status_ & NODEID_AND_STATUS_MASK) >> 1; }
+		get_id() const { return id_; }
 
 		inline void
-		set_id(uint32_t id) 
-		{ 
-			id = ((id << 1) | (id_and_status_ & 1)) & NODEID_AND_STATUS_MASK;
-			id_and_status_ |= id;
-		} 
+		set_id(uint32_t id) { id_ = id; } 
 
 		inline warthog::jps::direction
 		get_pdir() const
 		{
-			return (warthog::jps::direction)
-			   	*(((uint8_t*)(&id_and_status_))+3);
+			return (warthog::jps::direction)pdir_;
 		}
 
 		inline void
 		set_pdir(warthog::jps::direction d)
 		{
-			*(((uint8_t*)(&id_and_status_))+3) = d;
+			pdir_ = d;
 		}
 
 		inline bool
-		get_expanded() const { return (id_and_status_ & STATUS_MASK); }
+		get_expanded() const { return expanded_; }
 
 		inline void
-		set_expanded(bool expanded) 
-		{ 
-			id_and_status_ &= ~STATUS_MASK; // reset bit0
-			id_and_status_ ^= (uint32_t)(expanded?1:0); // set it anew
-		}
+		set_expanded(bool expanded) { expanded_ = expanded; }
 
 		inline warthog::search_node* 
 		get_parent() const { return parent_; }
@@ -221,14 +211,21 @@ class search_node
 		}
 
 	private:
-		uint32_t id_and_status_; // bit 0 is expansion status; 1-31 are id
+		// ids use all 32 bits (warthog::INF excepted); the expansion status
+		// and the direction from the parent fit in the padding after them,
+		// so search nodes are no bigger than when they shared a word
+		uint32_t id_;
+		uint8_t expanded_;
+		uint8_t pdir_;
 		warthog::cost_t f_;
 		warthog::cost_t g_;
 		warthog::search_node* parent_;
 		uint32_t priority_; // expansion priority
 		uint32_t searchid_;
 
-		static uint32_t refcount_;
+		// one count per thread; threads searching in parallel each
+		// allocate their own nodes
+		static thread_local uint32_t refcount_;
 };
 
 }
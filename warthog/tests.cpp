@@ -1,4 +1,6 @@
+#include "bidirectional_astar.h"
 #include "blockmap.h"
+#include "compressed_jump_point_database.h"
 #include "cuckoo_table.h"
 #include "cpool.h"
 #include "flexible_astar.h"
@@ -6,7 +8,10 @@
 #include "gridmap_expansion_policy.h"
 #include "hash_table.h"
 #include "jps_expansion_policy.h"
+#include "jump_point_database.h"
+#include "online_jump_point_locator.h"
 #include "pqueue.h"
+#include "radix_heap.h"
 #include "octile_heuristic.h"
 #include "search_node.h"
 #include "scenario_manager.h"
@@ -21,6 +26,9 @@
 void blockmap_access_test();
 void gridmap_access_test();
 void pqueue_insert_test();
+void radix_heap_test();
+void jump_point_database_test();
+void bidirectional_astar_test();
 void cuckoo_table_test();
 void unordered_map_test();
 void hash_table_test();
@@ -32,6 +40,9 @@ void online_jps_test();
 int main(int argc, char** argv)
 {
 	//flexible_astar_test();
+	radix_heap_test();
+	jump_point_database_test();
+	bidirectional_astar_test();
 	online_jps_test();
 }
 
@@ -351,6 +362,245 @@ void pqueue_insert_test()
 	std::cout << "/pqueue_insert_test...\n";
 }
 
+void radix_heap_test()
+{
+	std::cout << "radix_heap_test...\n";
+	unsigned int numnodes = 100000;
+	warthog::radix_heap open(numnodes);
+	warthog::search_node** nodes = new warthog::search_node*[numnodes];
+	srand(1);
+	for(unsigned int i=0; i < numnodes; i++)
+	{
+		nodes[i] = new warthog::search_node(i);
+		nodes[i]->set_g(rand() % 1000);
+		nodes[i]->set_f(nodes[i]->get_g() + rand() % 1000);
+		open.push(nodes[i]);
+	}
+	// test duplicate detection
+	for(unsigned int i=0; i < numnodes; i++)
+	{
+		open.push(nodes[i]);
+	}
+	assert(open.size() == numnodes);
+
+	// test decrease_key
+	for(unsigned int i=0; i < numnodes; i+=3)
+	{
+		if(nodes[i]->get_g() > 0)
+		{
+			nodes[i]->relax(nodes[i]->get_g()-1, 0);
+			open.decrease_key(nodes[i]);
+		}
+	}
+	assert(open.size() == numnodes);
+
+	// test pop: nodes come out by f and then by larger g
+	warthog::search_node* last = 0;
+	for(unsigned int i=0; i < numnodes; i++)
+	{
+		assert(open.size() == numnodes-i);
+		warthog::search_node* n = open.pop();
+		assert(!open.contains(n));
+		if(last && (last->get_f() > n->get_f() || 
+				(last->get_f() == n->get_f() && last->get_g() < n->get_g())))
+		{
+			std::cerr << "radix_heap_test: nodes popped out of order\n";
+			exit(1);
+		}
+		last = n;
+	}
+	assert(open.pop() == 0);
+
+	for(unsigned int i=0; i < numnodes; i++)
+	{
+		delete nodes[i];
+	}
+	delete [] nodes;
+	assert(warthog::search_node::get_refcount() == 0);
+	std::cout << "/radix_heap_test...\n";
+}
+
+// compares the labels computed by jump_point_database with those of an
+// online jump from every node, on random maps; and the labels of 
+// compressed_jump_point_database with the uncompressed ones
+void jump_point_database_test()
+{
+	std::cout << "jump_point_database_test...\n";
+	srand(1);
+	uint32_t sizes[4][2] = { {1, 1}, {7, 40}, {70, 33}, {100, 150} };
+	for(uint32_t m = 0; m < 12; m++)
+	{
+		uint32_t h = sizes[m % 4][0];
+		uint32_t w = sizes[m % 4][1];
+		uint32_t density = 5 + 15 * (m / 4);
+		warthog::gridmap map(h, w);
+		for(uint32_t y = 0; y < h; y++)
+		{
+			for(uint32_t x = 0; x < w; x++)
+			{
+				map.set_label(map.to_padded_id(x, y),
+						(uint32_t)(rand() % 100) >= density);
+			}
+		}
+
+		uint32_t dbsize = 8*map.padded_mapsize();
+		uint16_t* labels = new uint16_t[dbsize];
+		uint16_t* labels4 = new uint16_t[dbsize];
+		warthog::jump_point_database::compute(&map, labels, 1);
+		warthog::jump_point_database::compute(&map, labels4, 4);
+
+		warthog::online_jump_point_locator jpl(&map);
+		for(uint32_t y = 0; y < h; y++)
+		{
+			for(uint32_t x = 0; x < w; x++)
+			{
+				uint32_t mapid = map.to_padded_id(x, y);
+				for(uint32_t i = 0; i < 8; i++)
+				{
+					uint32_t jumpnode_id;
+					warthog::cost_t jumpcost;
+					jpl.jump((warthog::jps::direction)(1 << i), mapid,
+							warthog::INF, jumpnode_id, jumpcost);
+					uint16_t label = jumpcost / 
+						(i < 4 ? warthog::ONE : warthog::ROOT_TWO);
+					if(jumpnode_id == warthog::INF) { label |= 32768; }
+
+					if(labels[mapid*8 + i] != label ||
+							labels4[mapid*8 + i] != label)
+					{
+						std::cerr << "jump_point_database_test: wrong label "
+							<< "for ("<<x<<", "<<y<<") direction "<<(1 << i)
+							<< " map "<<m<<": "<<labels[mapid*8 + i]
+							<< " expected "<<label<<std::endl;
+						exit(1);
+					}
+				}
+			}
+		}
+
+		warthog::compressed_jump_point_database cdb(&map, labels);
+		for(uint32_t id = 0; id < map.padded_mapsize(); id++)
+		{
+			for(uint32_t i = 0; i < 8; i++)
+			{
+				if(cdb.label(id, i) != labels[id*8 + i])
+				{
+					std::cerr << "jump_point_database_test: wrong compressed "
+						<< "label for node "<<id<<" direction "<<(1 << i)
+						<< " map "<<m<<": "<<cdb.label(id, i)
+						<< " expected "<<labels[id*8 + i]<<std::endl;
+					exit(1);
+				}
+			}
+		}
+		delete [] labels;
+		delete [] labels4;
+	}
+	std::cout << "/jump_point_database_test...\n";
+}
+
+void bidirectional_astar_test()
+{
+	std::cout << "bidirectional_astar_test...\n";
+	srand(1);
+	for(uint32_t m = 0; m < 6; m++)
+	{
+		uint32_t h = 20 + 30 * (m % 3);
+		uint32_t w = 60 - 15 * (m % 3);
+		uint32_t density = 10 + 10 * (m / 2);
+		warthog::gridmap map(h, w);
+		for(uint32_t y = 0; y < h; y++)
+		{
+			for(uint32_t x = 0; x < w; x++)
+			{
+				// odd maps are divided into rooms by walls with a few gaps
+				bool wall = (m & 1) && y % 6 == 5 && rand() % 100 >= 8;
+				map.set_label(map.to_padded_id(x, y),
+						!wall && (uint32_t)(rand() % 100) >= density);
+			}
+		}
+
+		warthog::octile_heuristic heuristic(map.width(), map.height());
+		warthog::gridmap_expansion_policy expander(&map);
+		warthog::gridmap_expansion_policy fexpander(&map);
+		warthog::gridmap_expansion_policy bexpander(&map);
+		warthog::jps_expansion_policy jfexpander(&map);
+		warthog::jps_expansion_policy jbexpander(&map);
+		warthog::flexible_astar<
+			warthog::octile_heuristic,
+			warthog::gridmap_expansion_policy> astar(&heuristic, &expander);
+		warthog::bidirectional_astar<
+			warthog::octile_heuristic,
+			warthog::gridmap_expansion_policy> 
+				bi_astar(&heuristic, &fexpander, &bexpander);
+		warthog::bidirectional_astar<
+			warthog::octile_heuristic,
+			warthog::jps_expansion_policy, warthog::radix_heap> 
+				bi_jps(&heuristic, &jfexpander, &jbexpander);
+
+		for(uint32_t i = 0; i < 500; i++)
+		{
+			uint32_t startid = map.to_padded_id(rand() % w, rand() % h);
+			uint32_t goalid = map.to_padded_id(rand() % w, rand() % h);
+			if(i % 50 == 0) { goalid = startid; }
+			if(!map.get_label(startid) || !map.get_label(goalid))
+			{
+				continue;
+			}
+
+			double len = astar.get_length(startid, goalid);
+			double bi_len = bi_astar.get_length(startid, goalid);
+			double jps_len = bi_jps.get_length(startid, goalid);
+			if(bi_len != len || jps_len != len)
+			{
+				std::cerr << "bidirectional_astar_test: wrong length from "
+					<< startid << " to " << goalid << " map " << m << ": "
+					<< bi_len << " and " << jps_len << " expected " << len
+					<< std::endl;
+				exit(1);
+			}
+
+			// the path must go from start to goal, one move at a time,
+			// and have the length found above
+			std::stack<uint32_t> path = bi_astar.get_path(startid, goalid);
+			if(len * warthog::ONE == warthog::INF)
+			{
+				if(!path.empty())
+				{
+					std::cerr << "bidirectional_astar_test: path from "
+						<< startid << " to " << goalid << " map " << m 
+						<< " should be empty" << std::endl;
+					exit(1);
+				}
+				continue;
+			}
+
+			uint32_t pw = map.width();
+			warthog::cost_t cost = 0;
+			uint32_t last = startid;
+			bool valid = !path.empty() && path.top() == startid;
+			for(path.pop(); valid && !path.empty(); path.pop())
+			{
+				uint32_t next = path.top();
+				int32_t dx = (int32_t)(next % pw) - (int32_t)(last % pw);
+				int32_t dy = (int32_t)(next / pw) - (int32_t)(last / pw);
+				valid = map.get_label(next) && abs(dx) <= 1 && abs(dy) <= 1
+					&& map.get_label(last + dx) && map.get_label(last + dy*pw);
+				cost += (dx && dy) ? warthog::ROOT_TWO : warthog::ONE;
+				last = next;
+			}
+			if(!valid || last != goalid || cost / (double)warthog::ONE != len)
+			{
+				std::cerr << "bidirectional_astar_test: invalid path from "
+					<< startid << " to " << goalid << " map " << m 
+					<< std::endl;
+				exit(1);
+			}
+		}
+	}
+	std::cout << "/bidirectional_astar_test...\n";
+}
+
 void gridmap_access_test()
 {
 	std::cout << "gridmap_access_test..."<<std::endl;
@@ -22,7 +22,7 @@ class search_node;
 class pqueue 
 {
 	public:
-		pqueue(unsigned int size, bool minqueue);
+		pqueue(unsigned int size, bool minqueue = true);
 		~pqueue();
 
 		// removes all elements from the pqueue
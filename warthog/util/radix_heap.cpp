@@ -0,0 +1,146 @@
+#include "radix_heap.h"
+
+#include <algorithm>
+#include <cassert>
+
+warthog::radix_heap::radix_heap(unsigned int size)
+	: last_(0), size_(0), stamp_(0)
+{
+	buckets_[0].reserve(size);
+}
+
+warthog::radix_heap::~radix_heap()
+{
+}
+
+void
+warthog::radix_heap::push(warthog::search_node* val)
+{
+	if(contains(val))
+	{
+		return;
+	}
+	val->set_priority(stamp_);
+	size_++;
+	insert(val);
+}
+
+void
+warthog::radix_heap::decrease_key(warthog::search_node* val)
+{
+	assert(contains(val));
+	insert(val);
+}
+
+warthog::search_node*
+warthog::radix_heap::pop()
+{
+	settle();
+	if(size_ == 0)
+	{
+		return 0;
+	}
+
+	std::vector<entry>& top = buckets_[0];
+	warthog::search_node* ans = top.front().node;
+	std::pop_heap(top.begin(), top.end(), smaller_g());
+	top.pop_back();
+
+	ans->set_priority(warthog::INF);
+	size_--;
+	return ans;
+}
+
+void
+warthog::radix_heap::insert(warthog::search_node* val)
+{
+	entry e;
+	e.node = val;
+	e.key = std::max(val->get_f(), last_);
+	e.g = val->get_g();
+	insert(e, bucket_of(e.key));
+}
+
+void
+warthog::radix_heap::insert(const entry& e, uint32_t bucket)
+{
+	std::vector<entry>& b = buckets_[bucket];
+	b.push_back(e);
+	if(bucket == 0)
+	{
+		std::push_heap(b.begin(), b.end(), smaller_g());
+	}
+}
+
+void
+warthog::radix_heap::settle()
+{
+	std::vector<entry>& top = buckets_[0];
+	while(true)
+	{
+		// drop stale entries from the top of bucket 0
+		while(top.size() && !is_current(top.front()))
+		{
+			std::pop_heap(top.begin(), top.end(), smaller_g());
+			top.pop_back();
+		}
+		if(top.size() || size_ == 0)
+		{
+			return;
+		}
+
+		// bucket 0 is empty; the next key is the smallest one
+		// in the lowest non-empty bucket
+		uint32_t i = 1;
+		while(buckets_[i].empty()) { i++; }
+		assert(i < NUM_BUCKETS);
+
+		std::vector<entry>& b = buckets_[i];
+		warthog::cost_t min = warthog::INF;
+		for(uint32_t j = 0; j < b.size(); j++)
+		{
+			if(b[j].key < min && is_current(b[j]))
+			{
+				min = b[j].key;
+			}
+		}
+
+		// every current entry moves to a lower bucket; the rest are dropped
+		if(min != warthog::INF)
+		{
+			last_ = min;
+			for(uint32_t j = 0; j < b.size(); j++)
+			{
+				if(is_current(b[j]))
+				{
+					insert(b[j], bucket_of(b[j].key));
+				}
+			}
+		}
+		b.clear();
+	}
+}
+
+void
+warthog::radix_heap::clear()
+{
+	for(uint32_t i = 0; i < NUM_BUCKETS; i++)
+	{
+		buckets_[i].clear();
+	}
+	last_ = 0;
+	size_ = 0;
+	stamp_++;
+}
+
+unsigned int
+warthog::radix_heap::mem()
+{
+	unsigned int bytes = sizeof(*this);
+	for(uint32_t i = 0; i < NUM_BUCKETS; i++)
+	{
+		bytes += buckets_[i].capacity() * sizeof(entry);
+	}
+	return bytes;
+}
+
@@ -0,0 +1,151 @@
+#ifndef WARTHOG_RADIX_HEAP_H
+#define WARTHOG_RADIX_HEAP_H
+
+// radix_heap.h
+//
+// A monotone min priority queue for search nodes, keyed on their integer
+// f-values. After the radix heap of Ahuja, Mehlhorn, Orlin and Tarjan
+// [Faster Algorithms for the Shortest Path Problem, JACM, 1990].
+// It can replace warthog::pqueue as the open list of warthog::flexible_astar.
+//
+// With a consistent heuristic A* never pops a node whose f-value is smaller
+// than that of the last node popped. Each key is therefore only compared
+// with the last key popped: bucket 0 holds the nodes whose key is equal to
+// it and bucket i > 0 those whose key first differs from it at bit i-1.
+// Pushing a node takes constant time. Popping takes the nodes of bucket 0
+// and, when that runs out, redistributes the lowest non-empty bucket into
+// lower ones. Each node moves down at most 32 times, and usually much less
+// often since octile costs only ever add a few bits to the last key.
+//
+// Ties are broken as in warthog::pqueue, in favour of larger g-values;
+// to this end bucket 0 is a binary heap on g.
+//
+// decrease_key is lazy: the node is pushed again with its new key and the
+// old entry is dropped when it is reached. An entry is current while the
+// node's g-value is the one it was pushed with; search_node::priority_
+// marks the nodes in the queue.
+//
+// A node whose key is smaller than the last key popped (i.e. when the
+// heuristic is not consistent) is queued as if its key were equal to it.
+//
+// @created: 18/10/2026
+//
+
+#include "constants.h"
+#include "search_node.h"
+
+#include <stdint.h>
+#include <vector>
+
+namespace warthog
+{
+
+class radix_heap
+{
+	public:
+		radix_heap(unsigned int size);
+		~radix_heap();
+
+		// removes all elements from the queue
+		void
+		clear();
+
+		// requeue an element whose f-value has decreased
+		void
+		decrease_key(warthog::search_node* val);
+
+		// add a new element to the queue
+		void
+		push(warthog::search_node* val);
+
+		// remove the top element from the queue
+		warthog::search_node*
+		pop();
+
+		// @return true if the element is in the queue, false otherwise
+		inline bool
+		contains(warthog::search_node* n)
+		{
+			return n->get_priority() == stamp_;
+		}
+
+		// retrieve the top element without removing it
+		inline warthog::search_node*
+		peek()
+		{
+			settle();
+			if(size_ > 0)
+			{
+				return buckets_[0].front().node;
+			}
+			return 0;
+		}
+
+		inline unsigned int
+		size()
+		{
+			return size_;
+		}
+
+		unsigned int
+		mem();
+
+	private:
+		struct entry
+		{
+			warthog::search_node* node;
+			warthog::cost_t key;
+			warthog::cost_t g;
+		};
+
+		// orders bucket 0 as a max-heap on g
+		struct smaller_g
+		{
+			inline bool
+			operator()(const entry& a, const entry& b) const
+			{
+				return a.g < b.g;
+			}
+		};
+
+		static const uint32_t NUM_BUCKETS = 33;
+		std::vector<entry> buckets_[NUM_BUCKETS];
+		warthog::cost_t last_; // key of the last node popped
+		unsigned int size_;
+
+		// the priority of every node in the queue; changed by each
+		// call to clear so that nodes left over from earlier searches
+		// are not mistaken for nodes in the queue
+		uint32_t stamp_;
+
+		inline uint32_t
+		bucket_of(warthog::cost_t key)
+		{
+			if(key == last_) { return 0; }
+			return 32 - __builtin_clz(key ^ last_);
+		}
+
+		inline bool
+		is_current(const entry& e)
+		{
+			return e.node->get_priority() == stamp_ &&
+				e.node->get_g() == e.g;
+		}
+
+		// puts val into the bucket for its f-value
+		void
+		insert(warthog::search_node* val);
+
+		void
+		insert(const entry& e, uint32_t bucket);
+
+		// moves the top element into bucket 0 and discards any stale
+		// entries above it
+		void
+		settle();
+};
+
+}
+
+#endif
+
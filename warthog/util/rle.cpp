@@ -0,0 +1,46 @@
+#include "rle.h"
+
+warthog::rle_bitmap::rle_bitmap(uint32_t size) : size_(size)
+{
+	num_words_ = (size >> 6) + 1;
+	words_ = new uint64_t[num_words_ + 1];
+	skip_ = new uint16_t[num_words_ + 1];
+	for(uint32_t i = 0; i < num_words_; i++)
+	{
+		words_[i] = 0;
+		skip_[i] = 0;
+	}
+	words_[num_words_] = ~(uint64_t)0;
+	skip_[num_words_] = 0;
+}
+
+warthog::rle_bitmap::~rle_bitmap()
+{
+	delete [] words_;
+	delete [] skip_;
+}
+
+void
+warthog::rle_bitmap::finish()
+{
+	for(uint32_t w = num_words_; w > 0; w--)
+	{
+		uint32_t i = w - 1;
+		if(words_[i])
+		{
+			skip_[i] = 0;
+		}
+		else
+		{
+			uint32_t skip = skip_[i+1] + 1;
+			skip_[i] = skip < 65535 ? skip : 65535;
+		}
+	}
+}
+
+uint32_t
+warthog::rle_bitmap::mem()
+{
+	return sizeof(*this) +
+		(num_words_ + 1) * (sizeof(*words_) + sizeof(*skip_));
+}
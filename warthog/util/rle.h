@@ -0,0 +1,85 @@
+#ifndef WARTHOG_RLE_H
+#define WARTHOG_RLE_H
+
+// rle.h
+//
+// Run-length encoding of a sequence by the positions at which its runs
+// end. An rle_bitmap marks the last position of each run; next(i) finds
+// the end of the run that contains position i, from which the caller
+// recovers whatever the run stands for.
+//
+// Each word of the bitmap that marks nothing stores the number of words
+// to skip to reach one that does, so next() reads at most two words when
+// runs are shorter than 64 * 65535 positions (longer gaps are crossed
+// 65535 words at a time).
+//
+// @created: 18/10/2026
+//
+
+#include <stdint.h>
+
+namespace warthog
+{
+
+class rle_bitmap
+{
+	public:
+		rle_bitmap(uint32_t size);
+		~rle_bitmap();
+
+		// marks position i as the end of a run
+		inline void
+		set(uint32_t i)
+		{
+			words_[i >> 6] |= (uint64_t)1 << (i & 63);
+		}
+
+		inline bool
+		get(uint32_t i)
+		{
+			return (words_[i >> 6] >> (i & 63)) & 1;
+		}
+
+		// computes the skip distances; call once all runs are marked
+		void
+		finish();
+
+		// @return the end of the run containing position i: the first
+		// marked position >= i, or a position >= size() if there is none
+		inline uint32_t
+		next(uint32_t i)
+		{
+			uint32_t w = i >> 6;
+			uint64_t bits = words_[w] >> (i & 63);
+			if(bits)
+			{
+				return i + __builtin_ctzll(bits);
+			}
+			w++;
+			while(!words_[w]) { w += skip_[w]; }
+			return (w << 6) + __builtin_ctzll(words_[w]);
+		}
+
+		inline uint32_t
+		size()
+		{
+			return size_;
+		}
+
+		uint32_t
+		mem();
+
+	private:
+		uint32_t size_;
+		uint32_t num_words_; // plus one sentinel word, which marks everything
+		uint64_t* words_;
+		uint16_t* skip_;
+
+		rle_bitmap(const warthog::rle_bitmap& other) {}
+		rle_bitmap& operator=(const warthog::rle_bitmap& other) { return *this; }
+};
+
+}
+
+#endif
+
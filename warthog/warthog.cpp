@@ -4,7 +4,10 @@
 // @created: August 2012
 //
 
+#include "anya_expansion_policy.h"
+#include "bidirectional_astar.h"
 #include "cfg.h"
+#include "euclidean_heuristic.h"
 #include "flexible_astar.h"
 #include "gridmap.h"
 #include "gridmap_expansion_policy.h"
@@ -13,17 +16,25 @@
 #include "jpsplus_expansion_policy.h"
 #include "jps2plus_expansion_policy.h"
 #include "octile_heuristic.h"
+#include "pqueue.h"
+#include "radix_heap.h"
 #include "scenario_manager.h"
 #include "weighted_gridmap.h"
 #include "wgridmap_expansion_policy.h"
 #include "zero_heuristic.h"
 
 #include "getopt.h"
+#include "timer.h"
 
+#include <algorithm>
+#include <atomic>
 #include <iomanip>
 #include <sstream>
+#include <thread>
 #include <tr1/unordered_map>
 #include <memory>
+#include <type_traits>
+#include <vector>
 
 // check computed solutions are optimal
 int checkopt = 0;
@@ -33,15 +44,30 @@ int verbose = 0;
 int print_help = 0;
 // treat the map as a weighted-cost grid
 int wgm = 0;
+// jps2 scans 64 tiles at a time when jumping
+int jump64 = 0;
+// use a radix heap rather than a binary heap for the open list
+int radix = 0;
+// number of threads running experiments
+int nthreads = 1;
+// keep the jump point database of jps+ and jps2+ in compressed form
+int compress = 0;
+// search from the start and the goal at the same time
+int bidirectional = 0;
 
 void
 help()
 {
 	std::cerr << "valid parameters:\n"
-	<< "--alg [astar | jps | jps2 | jps+ | jps2+ | jps | sssp ]\n"
+	<< "--alg [astar | jps | jps2 | jps+ | jps2+ | jps | sssp | anya ]\n"
 	<< "--scen [scenario filename]\n"
 	<< "--gen [map filename]\n"
 	<< "--wgm (optional)\n"
+	<< "--jump64 (optional; jps2 only)\n"
+	<< "--radix (optional; astar, jps, jps2, jps+ and jps2+ only)\n"
+	<< "--threads [number] (optional; not sssp)\n"
+	<< "--compress (optional; jps+ and jps2+ only)\n"
+	<< "--bidirectional (optional; not sssp)\n"
 	<< "--checkopt (optional)\n"
 	<< "--verbose (optional)\n";
 }
@@ -92,249 +118,269 @@ check_optimality(double len, warthog::experiment* exp)
 	}
 }
 
-void
-run_jpsplus(warthog::scenario_manager& scenmgr)
+// the outcome of one experiment
+struct result
 {
-    warthog::gridmap map(scenmgr.get_experiment(0)->map().c_str());
-	warthog::jpsplus_expansion_policy expander(&map);
-	warthog::octile_heuristic heuristic(map.width(), map.height());
-
-	warthog::flexible_astar<
-		warthog::octile_heuristic,
-	   	warthog::jpsplus_expansion_policy> astar(&heuristic, &expander);
-	astar.set_verbose(verbose);
+	uint32_t expd;
+	uint32_t gend;
+	uint32_t touched;
+	double time;
+	double len;
+};
+
+// @return the p-th percentile (nearest rank) of sorted values
+double
+percentile(std::vector<double>& sorted, double p)
+{
+	if(sorted.size() == 0) { return 0; }
+	uint32_t rank = ceil(p / 100 * sorted.size());
+	return sorted.at(rank ? rank - 1 : 0);
+}
 
-	std::cout << "id\talg\texpd\tgend\ttouched\ttime\tcost\tsfile\n";
-	for(unsigned int i=0; i < scenmgr.num_experiments(); i++)
+// Runs every experiment in the scenario file and prints a line for each,
+// in the order of the file. There is one search for each thread (see
+// run_experiments) and experiments are handed out to whichever thread is
+// free. Afterwards the throughput and the percentiles of search time are
+// printed to stderr, and the searches are deleted.
+// @return the memory used by the searches
+template <class S, class M>
+size_t
+run_searches(warthog::scenario_manager& scenmgr, M& map,
+		std::vector<S*>& searches, const std::string& alg, double hscale,
+		bool checkable)
+{
+	for(uint32_t t = 0; t < searches.size(); t++)
 	{
-		warthog::experiment* exp = scenmgr.get_experiment(i);
+		searches[t]->set_verbose(verbose);
+		searches[t]->set_hscale(hscale);
+	}
 
-		int startid = exp->starty() * exp->mapwidth() + exp->startx();
-		int goalid = exp->goaly() * exp->mapwidth() + exp->goalx();
-		double len = astar.get_length(
-				map.to_padded_id(startid),
-			   	map.to_padded_id(goalid));
-		if(len == warthog::INF)
+	std::vector<result> results(scenmgr.num_experiments());
+	std::atomic<uint32_t> next(0);
+	auto work = [&](S* search)
+	{
+		for(uint32_t i = next++; i < results.size(); i = next++)
 		{
-			len = 0;
+			warthog::experiment* exp = scenmgr.get_experiment(i);
+
+			int startid = exp->starty() * exp->mapwidth() + exp->startx();
+			int goalid = exp->goaly() * exp->mapwidth() + exp->goalx();
+			double len = search->get_length(
+					map.to_padded_id(startid),
+					map.to_padded_id(goalid));
+			if(len == warthog::INF)
+			{
+				len = 0;
+			}
+
+			result& r = results[i];
+			r.expd = search->get_nodes_expanded();
+			r.gend = search->get_nodes_generated();
+			r.touched = search->get_nodes_touched();
+			r.time = search->get_search_time();
+			r.len = len;
 		}
+	};
 
-		std::cout << i<<"\t" << "jps+" << "\t" 
-		<< astar.get_nodes_expanded() << "\t" 
-		<< astar.get_nodes_generated() << "\t"
-		<< astar.get_nodes_touched() << "\t"
-		<< astar.get_search_time()  << "\t"
-		<< len << "\t" 
+	warthog::timer wallclock;
+	wallclock.start();
+	std::vector<std::thread> workers;
+	for(uint32_t t = 1; t < searches.size(); t++)
+	{
+		workers.push_back(std::thread(work, searches[t]));
+	}
+	work(searches[0]);
+	for(uint32_t t = 0; t < workers.size(); t++)
+	{
+		workers[t].join();
+	}
+	wallclock.stop();
+
+	std::cout << "id\talg\texpd\tgend\ttouched\ttime\tcost\tsfile\n";
+	for(unsigned int i=0; i < results.size(); i++)
+	{
+		result& r = results[i];
+		std::cout << i<<"\t" << alg << "\t" 
+		<< r.expd << "\t" 
+		<< r.gend << "\t"
+		<< r.touched << "\t"
+		<< r.time  << "\t"
+		<< r.len << "\t" 
 		<< scenmgr.last_file_loaded() << std::endl;
 
-		check_optimality(len, exp);
+		if(checkable)
+		{
+			check_optimality(r.len, scenmgr.get_experiment(i));
+		}
 	}
-	std::cerr << "done. total memory: "<< astar.mem() + scenmgr.mem() << "\n";
+
+	std::vector<double> times;
+	for(unsigned int i=0; i < results.size(); i++)
+	{
+		times.push_back(results[i].time);
+	}
+	std::sort(times.begin(), times.end());
+	double secs = wallclock.elapsed_time_micro() / 1e6;
+	std::cerr << "threads: " << nthreads << " queries: " << results.size()
+		<< " wallclock: " << secs << "s throughput: " 
+		<< (secs > 0 ? results.size() / secs : 0) << " queries/s\n";
+	std::cerr << "search time (micro) p50: " << percentile(times, 50)
+		<< " p90: " << percentile(times, 90)
+		<< " p99: " << percentile(times, 99)
+		<< " max: " << percentile(times, 100) << "\n";
+
+	size_t mem = 0;
+	for(uint32_t t = 0; t < searches.size(); t++)
+	{
+		mem += searches[t]->mem();
+		delete searches[t];
+	}
+	return mem;
 }
 
+// Runs every experiment in the scenario file (see run_searches). With
+// --threads N there are N threads, each with its own search and expansion 
+// policy (from new_expander); with --bidirectional each search has two 
+// policies, one for either direction. The map, the heuristic and whatever 
+// new_expander shares between policies (e.g. a jump point database, whose 
+// size is given by shared_mem) are shared by all.
+template <class Q, class H, class M, class F>
 void
-run_jps2plus(warthog::scenario_manager& scenmgr)
+run_experiments(warthog::scenario_manager& scenmgr, M& map, H* heuristic, 
+		F new_expander, const char* alg, size_t shared_mem = 0, 
+		double hscale = 1.0, bool checkable = true)
 {
-    warthog::gridmap map(scenmgr.get_experiment(0)->map().c_str());
-	warthog::jps2plus_expansion_policy expander(&map);
-	warthog::octile_heuristic heuristic(map.width(), map.height());
+	typedef typename std::remove_pointer<decltype(new_expander())>::type E;
 
-	warthog::flexible_astar<
-		warthog::octile_heuristic,
-	   	warthog::jps2plus_expansion_policy> astar(&heuristic, &expander);
-	astar.set_verbose(verbose);
-
-	std::cout << "id\talg\texpd\tgend\ttouched\ttime\tcost\tsfile\n";
-	for(unsigned int i=0; i < scenmgr.num_experiments(); i++)
+	std::vector<E*> expanders;
+	size_t mem = shared_mem + scenmgr.mem();
+	if(bidirectional)
 	{
-		warthog::experiment* exp = scenmgr.get_experiment(i);
-
-		int startid = exp->starty() * exp->mapwidth() + exp->startx();
-		int goalid = exp->goaly() * exp->mapwidth() + exp->goalx();
-		double len = astar.get_length(
-				map.to_padded_id(startid),
-			   	map.to_padded_id(goalid));
-		if(len == warthog::INF)
+		typedef warthog::bidirectional_astar<H, E, Q> search_t;
+		std::vector<search_t*> searches;
+		for(int t = 0; t < nthreads; t++)
 		{
-			len = 0;
+			expanders.push_back(new_expander());
+			expanders.push_back(new_expander());
+			searches.push_back(new search_t(heuristic, 
+						expanders[2*t], expanders[2*t+1]));
 		}
+		mem += run_searches(scenmgr, map, searches, 
+				std::string(alg) + "_bi", hscale, checkable);
+	}
+	else
+	{
+		typedef warthog::flexible_astar<H, E, Q> search_t;
+		std::vector<search_t*> searches;
+		for(int t = 0; t < nthreads; t++)
+		{
+			expanders.push_back(new_expander());
+			searches.push_back(new search_t(heuristic, expanders[t]));
+		}
+		mem += run_searches(scenmgr, map, searches, alg, hscale, checkable);
+	}
 
-		std::cout << i<<"\t" << "jps2+" << "\t" 
-		<< astar.get_nodes_expanded() << "\t" 
-		<< astar.get_nodes_generated() << "\t"
-		<< astar.get_nodes_touched() << "\t"
-		<< astar.get_search_time()  << "\t"
-		<< len << "\t" 
-		<< scenmgr.last_file_loaded() << std::endl;
-
-		check_optimality(len, exp);
+	// every policy counts the map; it is only there once
+	mem -= (expanders.size()-1) * map.mem();
+	for(uint32_t i = 0; i < expanders.size(); i++)
+	{
+		delete expanders[i];
 	}
-	std::cerr << "done. total memory: "<< astar.mem() + scenmgr.mem() << "\n";
+	std::cerr << "done. total memory: "<< mem << "\n";
 }
 
+template <class Q>
 void
-run_jps2(warthog::scenario_manager& scenmgr)
+run_jpsplus(warthog::scenario_manager& scenmgr)
 {
     warthog::gridmap map(scenmgr.get_experiment(0)->map().c_str());
-	warthog::jps2_expansion_policy expander(&map);
+	warthog::offline_jump_point_locator jpl(&map, compress);
 	warthog::octile_heuristic heuristic(map.width(), map.height());
+	std::cerr << "jump point database: " << jpl.mem() << " bytes"
+		<< (compress ? " (compressed)" : "") << std::endl;
 
-	warthog::flexible_astar<
-		warthog::octile_heuristic,
-	   	warthog::jps2_expansion_policy> astar(&heuristic, &expander);
-	astar.set_verbose(verbose);
+	run_experiments<Q>(scenmgr, map, &heuristic, 
+		[&]() { return new warthog::jpsplus_expansion_policy(&map, &jpl); },
+		"jps+", jpl.mem());
+}
 
-	std::cout << "id\talg\texpd\tgend\ttouched\ttime\tcost\tsfile\n";
-	for(unsigned int i=0; i < scenmgr.num_experiments(); i++)
-	{
-		warthog::experiment* exp = scenmgr.get_experiment(i);
+template <class Q>
+void
+run_jps2plus(warthog::scenario_manager& scenmgr)
+{
+    warthog::gridmap map(scenmgr.get_experiment(0)->map().c_str());
+	warthog::offline_jump_point_locator2 jpl(&map, compress);
+	warthog::octile_heuristic heuristic(map.width(), map.height());
+	std::cerr << "jump point database: " << jpl.mem() << " bytes"
+		<< (compress ? " (compressed)" : "") << std::endl;
 
-		int startid = exp->starty() * exp->mapwidth() + exp->startx();
-		int goalid = exp->goaly() * exp->mapwidth() + exp->goalx();
-		double len = astar.get_length(
-				map.to_padded_id(startid),
-			   	map.to_padded_id(goalid));
-		if(len == warthog::INF)
-		{
-			len = 0;
-		}
+	run_experiments<Q>(scenmgr, map, &heuristic, 
+		[&]() { return new warthog::jps2plus_expansion_policy(&map, &jpl); },
+		"jps2+", jpl.mem());
+}
 
-		std::cout << i<<"\t" << "jps2" << "\t" 
-		<< astar.get_nodes_expanded() << "\t" 
-		<< astar.get_nodes_generated() << "\t"
-		<< astar.get_nodes_touched() << "\t"
-		<< astar.get_search_time()  << "\t"
-		<< len << "\t" 
-		<< scenmgr.last_file_loaded() << std::endl;
+template <class Q>
+void
+run_jps2(warthog::scenario_manager& scenmgr)
+{
+    warthog::gridmap map(scenmgr.get_experiment(0)->map().c_str());
+	warthog::octile_heuristic heuristic(map.width(), map.height());
 
-		check_optimality(len, exp);
-	}
-	std::cerr << "done. total memory: "<< astar.mem() + scenmgr.mem() << "\n";
+	run_experiments<Q>(scenmgr, map, &heuristic, 
+		[&]() { return new warthog::jps2_expansion_policy(&map, jump64); },
+		"jps2");
 }
 
+template <class Q>
 void
 run_jps(warthog::scenario_manager& scenmgr)
 {
     warthog::gridmap map(scenmgr.get_experiment(0)->map().c_str());
-	warthog::jps_expansion_policy expander(&map);
 	warthog::octile_heuristic heuristic(map.width(), map.height());
 
-	warthog::flexible_astar<
-		warthog::octile_heuristic,
-	   	warthog::jps_expansion_policy> astar(&heuristic, &expander);
-	astar.set_verbose(verbose);
-
-	std::cout << "id\talg\texpd\tgend\ttouched\ttime\tcost\tsfile\n";
-	for(unsigned int i=0; i < scenmgr.num_experiments(); i++)
-	{
-		warthog::experiment* exp = scenmgr.get_experiment(i);
-
-		int startid = exp->starty() * exp->mapwidth() + exp->startx();
-		int goalid = exp->goaly() * exp->mapwidth() + exp->goalx();
-		double len = astar.get_length(
-				map.to_padded_id(startid),
-			   	map.to_padded_id(goalid));
-		if(len == warthog::INF)
-		{
-			len = 0;
-		}
-
-		std::cout << i<<"\t" << "jps" << "\t" 
-		<< astar.get_nodes_expanded() << "\t" 
-		<< astar.get_nodes_generated() << "\t"
-		<< astar.get_nodes_touched() << "\t"
-		<< astar.get_search_time()  << "\t"
-		<< len << "\t" 
-		<< scenmgr.last_file_loaded() << std::endl;
+	run_experiments<Q>(scenmgr, map, &heuristic, 
+		[&]() { return new warthog::jps_expansion_policy(&map); },
+		"jps");
+}
 
-		check_optimality(len, exp);
-	}
-	std::cerr << "done. total memory: "<< astar.mem() + scenmgr.mem() << "\n";
+void
+run_anya(warthog::scenario_manager& scenmgr)
+{
+    warthog::gridmap map(scenmgr.get_experiment(0)->map().c_str());
+	warthog::euclidean_heuristic heuristic(map.width(), map.height());
+
+	// NB: any-angle paths are shorter than the octile distances given by 
+	// the scenario file, so --checkopt does not apply here.
+	// the start and goal are the top-left corners of their tiles.
+	run_experiments<warthog::pqueue>(scenmgr, map, &heuristic, 
+		[&]() { return new warthog::anya_expansion_policy(&map); },
+		"anya", 0, 1.0, false);
 }
 
+template <class Q>
 void
 run_astar(warthog::scenario_manager& scenmgr)
 {
     warthog::gridmap map(scenmgr.get_experiment(0)->map().c_str());
-	warthog::gridmap_expansion_policy expander(&map);
 	warthog::octile_heuristic heuristic(map.width(), map.height());
 
-	warthog::flexible_astar<
-		warthog::octile_heuristic,
-	   	warthog::gridmap_expansion_policy> astar(&heuristic, &expander);
-	astar.set_verbose(verbose);
-
-
-	std::cout << "id\talg\texpd\tgend\ttouched\ttime\tcost\tsfile\n";
-	for(unsigned int i=0; i < scenmgr.num_experiments(); i++)
-	{
-		warthog::experiment* exp = scenmgr.get_experiment(i);
-
-		int startid = exp->starty() * exp->mapwidth() + exp->startx();
-		int goalid = exp->goaly() * exp->mapwidth() + exp->goalx();
-		double len = astar.get_length(
-				map.to_padded_id(startid), 
-				map.to_padded_id(goalid));
-		if(len == warthog::INF)
-		{
-			len = 0;
-		}
-
-		std::cout << i<<"\t" << "astar" << "\t" 
-		<< astar.get_nodes_expanded() << "\t" 
-		<< astar.get_nodes_generated() << "\t"
-		<< astar.get_nodes_touched() << "\t"
-		<< astar.get_search_time()  << "\t"
-		<< len << "\t" 
-		<< scenmgr.last_file_loaded() << std::endl;
-
-		check_optimality(len, exp);
-	}
-	std::cerr << "done. total memory: "<< astar.mem() + scenmgr.mem() << "\n";
+	run_experiments<Q>(scenmgr, map, &heuristic, 
+		[&]() { return new warthog::gridmap_expansion_policy(&map); },
+		"astar");
 }
 
 void
 run_wgm_astar(warthog::scenario_manager& scenmgr)
 {
     warthog::weighted_gridmap map(scenmgr.get_experiment(0)->map().c_str());
-	warthog::wgridmap_expansion_policy expander(&map);
 	warthog::octile_heuristic heuristic(map.width(), map.height());
 
-	warthog::flexible_astar<
-		warthog::octile_heuristic,
-	   	warthog::wgridmap_expansion_policy> astar(&heuristic, &expander);
-	astar.set_verbose(verbose);
     // cheapest terrain (movingai benchmarks) has ascii value '.'; we scale
     // all heuristic values accordingly (otherwise the heuristic doesn't 
     // impact f-values much and search starts to behave like dijkstra)
-    astar.set_hscale('.');  
-
-	std::cout << "id\talg\texpd\tgend\ttouched\ttime\tcost\tsfile\n";
-	for(unsigned int i=0; i < scenmgr.num_experiments(); i++)
-	{
-		warthog::experiment* exp = scenmgr.get_experiment(i);
-
-		int startid = exp->starty() * exp->mapwidth() + exp->startx();
-		int goalid = exp->goaly() * exp->mapwidth() + exp->goalx();
-		double len = astar.get_length(
-				map.to_padded_id(startid), 
-				map.to_padded_id(goalid));
-		if(len == warthog::INF)
-		{
-			len = 0;
-		}
-
-		std::cout << i<<"\t" << "astar_wgm" << "\t" 
-		<< astar.get_nodes_expanded() << "\t" 
-		<< astar.get_nodes_generated() << "\t"
-		<< astar.get_nodes_touched() << "\t"
-		<< astar.get_search_time()  << "\t"
-		<< len << "\t" 
-		<< scenmgr.last_file_loaded() << std::endl;
-
-		check_optimality(len, exp);
-	}
-	std::cerr << "done. total memory: "<< astar.mem() + scenmgr.mem() << "\n";
+	run_experiments<warthog::pqueue>(scenmgr, map, &heuristic, 
+		[&]() { return new warthog::wgridmap_expansion_policy(&map); },
+		"astar_wgm", 0, '.');
 }
 
 void
@@ -379,7 +425,13 @@ main(int argc, char** argv)
 		{"help", no_argument, &print_help, 1},
 		{"checkopt",  no_argument, &checkopt, 1},
 		{"verbose",  no_argument, &verbose, 1},
-		{"wgm",  no_argument, &wgm, 1}
+		{"wgm",  no_argument, &wgm, 1},
+		{"jump64",  no_argument, &jump64, 1},
+		{"radix",  no_argument, &radix, 1},
+		{"threads", required_argument, 0, 4},
+		{"compress",  no_argument, &compress, 1},
+		{"bidirectional",  no_argument, &bidirectional, 1},
+		{0, 0, 0, 0}
 	};
 
 	warthog::util::cfg cfg;
@@ -394,6 +446,11 @@ main(int argc, char** argv)
 	std::string sfile = cfg.get_param_value("scen");
 	std::string alg = cfg.get_param_value("alg");
 	std::string gen = cfg.get_param_value("gen");
+	std::string threads = cfg.get_param_value("threads");
+	if(threads != "")
+	{
+		nthreads = std::max(1, atoi(threads.c_str()));
+	}
 
     // generate scenarios
 	if(gen != "")
@@ -418,33 +475,70 @@ main(int argc, char** argv)
 
 	if(alg == "jps+")
 	{
-		run_jpsplus(scenmgr);
+		if(radix)
+		{
+			run_jpsplus<warthog::radix_heap>(scenmgr);
+		}
+		else
+		{
+			run_jpsplus<warthog::pqueue>(scenmgr);
+		}
 	}
 
 	if(alg == "jps2")
 	{
-		run_jps2(scenmgr);
+		if(radix)
+		{
+			run_jps2<warthog::radix_heap>(scenmgr);
+		}
+		else
+		{
+			run_jps2<warthog::pqueue>(scenmgr);
+		}
 	}
 
 	if(alg == "jps2+")
 	{
-		run_jps2plus(scenmgr);
+		if(radix)
+		{
+			run_jps2plus<warthog::radix_heap>(scenmgr);
+		}
+		else
+		{
+			run_jps2plus<warthog::pqueue>(scenmgr);
+		}
 	}
 
     if(alg == "jps")
     {
-        run_jps(scenmgr);
+        if(radix)
+        {
+            run_jps<warthog::radix_heap>(scenmgr);
+        }
+        else
+        {
+            run_jps<warthog::pqueue>(scenmgr);
+        }
     }
 
+	if(alg == "anya")
+	{
+		run_anya(scenmgr);
+	}
+
 	if(alg == "astar")
 	{
         if(wgm) 
         { 
             run_wgm_astar(scenmgr); 
         }
+        else if(radix)
+        { 
+            run_astar<warthog::radix_heap>(scenmgr); 
+        }
         else 
         { 
-            run_astar(scenmgr); 
+            run_astar<warthog::pqueue>(scenmgr); 
         }
 	}
 